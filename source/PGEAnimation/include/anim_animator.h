@@ -1,13 +1,28 @@
 #ifndef PGE_ANIMATION_ANIM_ANIMATOR_H
 #define PGE_ANIMATION_ANIM_ANIMATOR_H
 
-#include "anim_skeleton.h"
+#include "anim_pose.h"
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <iostream>
 
 namespace pge
 {
+    using anim_TriggerId = uint32_t;
+
+    // FNV-1a, so trigger names can be hashed at compile time
+    constexpr anim_TriggerId
+    anim_HashTrigger(const char* name)
+    {
+        anim_TriggerId hash = 2166136261u;
+        for (; *name != 0; ++name) {
+            hash ^= static_cast<uint8_t>(*name);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
     struct anim_AnimationState {
         std::string                   name;
         const anim_SkeletonAnimation* animation;
@@ -46,41 +61,91 @@ namespace pge
         struct Transition {
             const anim_AnimationState* from;
             const anim_AnimationState* to;
-            std::string                trigger;
+            anim_TriggerId             trigger;
             float                      duration;
         };
-        const anim_Skeleton*             m_skeleton;
-        std::vector<anim_AnimationState> m_states;
-        std::vector<Transition>          m_transitions;
+        const anim_SkeletonDef*            m_skeleton;
+        std::vector<anim_AnimationState>   m_states;
+        std::vector<anim_AnimationBinding> m_bindings;        // One per state
+        std::vector<Transition>            m_transitions;     // Grouped by the state they leave
+        std::vector<unsigned>              m_firstTransition; // Per state, plus one past the last transition
+
+        const anim_AnimationBinding& GetBinding(const anim_AnimationState* state) const;
+        const Transition*            FindTransition(const anim_AnimationState* from, anim_TriggerId trigger) const;
 
     public:
-        void Initialize(const anim_Skeleton*        skeleton,
+        void Initialize(const anim_SkeletonDef*     skeleton,
                         const anim_AnimationState*  states,
                         unsigned                    numStates,
                         const anim_TransitionParam* transitions,
                         unsigned                    numTransitions);
 
         anim_AnimatorConfig() = default;
-        anim_AnimatorConfig(const anim_Skeleton*        skeleton,
+        anim_AnimatorConfig(const anim_SkeletonDef*     skeleton,
                             const anim_AnimationState*  states,
                             unsigned                    numStates,
                             const anim_TransitionParam* transitions,
                             unsigned                    numTransitions);
+
+        const anim_SkeletonDef*    GetSkeleton() const;
+        unsigned                   GetStateCount() const;
+        const anim_AnimationState& GetState(unsigned index) const;
+    };
+
+    // Cheaper evaluation for animators that are far away or small on screen
+    struct anim_AnimatorLod {
+        bool skipLeafBones; // Bones without children keep their bind pose
+        bool singleClip;    // Transitions show the clip with the larger weight instead of blending both
+
+        anim_AnimatorLod(bool skipLeafBones = false, bool singleClip = false)
+            : skipLeafBones(skipLeafBones)
+            , singleClip(singleClip)
+        {}
+    };
+
+    // Animators with equal keys evaluate to the same pose. Only animators playing a single clip have one.
+    struct anim_PoseKey {
+        const anim_SkeletonDef*       skeleton;
+        const anim_SkeletonAnimation* animation;
+        uint32_t                      frame; // Playback time, in steps of the quantization
+        bool                          skipLeafBones;
+
+        bool operator==(const anim_PoseKey& rhs) const;
     };
 
     class anim_Animator {
-        const anim_AnimatorConfig*             m_config;
-        const anim_AnimationState*             m_currentState;
-        const anim_AnimatorConfig::Transition* m_currentTrans;
-        float                                  m_currentAnimTime;
-        float                                  m_transitTime;
+        const anim_AnimatorConfig*              m_config;
+        const anim_AnimationState*              m_currentState;
+        const anim_AnimatorConfig::Transition*  m_currentTrans;
+        float                                   m_currentAnimTime;
+        float                                   m_transitTime;
+        mutable std::vector<anim_ChannelCursor> m_cursors; // For the channels of the animation playing at m_currentAnimTime
+        mutable anim_Pose                       m_pose;
+        mutable anim_Pose                       m_blendPose; // The destination of a transition, blended into m_pose
+        mutable bool                            m_poseOutdated;
+        mutable size_t                          m_numEvaluatedBones;
+        anim_AnimatorLod                        m_lod;
 
     public:
         anim_Animator(const anim_AnimatorConfig* config);
 
-        void          Trigger(const char* trigger);
-        void          Update(float dt);
-        anim_Skeleton GetAnimatedSkeleton() const;
+        void Trigger(anim_TriggerId trigger);
+        void Trigger(const char* trigger);
+        void Update(float dt);
+        // Evaluated on first use after an update, the pose is owned by the animator and reused every frame.
+        const anim_Pose& GetPose() const;
+        bool             IsPoseOutdated() const;
+        size_t           GetNumEvaluatedBones() const; // Bones sampled by the last evaluation of the pose
+
+        // False while transitioning, since the pose then depends on two clips and the transition's progress.
+        bool GetPoseKey(float timeStep, anim_PoseKey* key) const;
+        // The state with the larger weight and its playback time, which is what the single clip LOD samples.
+        const anim_AnimationState* GetDominantState(float* time) const;
+        const anim_SkeletonDef*    GetSkeleton() const;
+        const anim_AnimatorConfig* GetConfig() const;
+
+        void                    SetLod(const anim_AnimatorLod& lod);
+        const anim_AnimatorLod& GetLod() const;
     };
 } // namespace pge
 
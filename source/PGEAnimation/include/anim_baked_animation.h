@@ -0,0 +1,40 @@
+#ifndef PGE_ANIMATION_ANIM_BAKED_ANIMATION_H
+#define PGE_ANIMATION_ANIM_BAKED_ANIMATION_H
+
+#include "anim_skeleton.h"
+#include <math_aabb.h>
+
+namespace pge
+{
+    // A clip sampled on a uniform grid into skinning palettes for one mesh, so playing it back is a lookup instead of
+    // sampling channels and walking the hierarchy. Meant for background characters, where the memory (frames times
+    // bones times 64 bytes) is worth the evaluation it saves. The last frame falls on the clip's duration.
+    class anim_BakedAnimation {
+        const anim_SkeletonAnimation* m_animation;
+        size_t                        m_numBones;
+        unsigned                      m_numFrames;
+        float                         m_frameRate;
+        std::vector<math_Mat4x4>      m_palettes; // Frame after frame, one matrix per bone
+        math_AABB                     m_boneBounds;
+
+    public:
+        // The offsets hold one matrix per bone of the skeleton, as for anim_ComputeSkinningPalette.
+        anim_BakedAnimation(const anim_SkeletonDef&       skeleton,
+                            const anim_SkeletonAnimation& animation,
+                            const math_Mat4x4*            boneOffsets,
+                            float                         sampleRate = 30.0f);
+
+        const anim_SkeletonAnimation* GetAnimation() const;
+        size_t                        GetBoneCount() const;
+        unsigned                      GetFrameCount() const;
+        size_t                        GetSizeInBytes() const;
+        const math_AABB&              GetBoneBounds() const; // Of the bone positions over all frames
+
+        const math_Mat4x4* GetPalette(unsigned frame) const;
+        // Without interpolation this picks the nearest frame, with it the matrices of the two closest frames are
+        // blended linearly. Times outside the clip are clamped.
+        void Sample(double time, bool interpolate, math_Mat4x4* palette) const;
+    };
+} // namespace pge
+
+#endif
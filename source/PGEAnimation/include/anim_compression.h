@@ -0,0 +1,95 @@
+#ifndef PGE_ANIMATION_ANIM_COMPRESSION_H
+#define PGE_ANIMATION_ANIM_COMPRESSION_H
+
+#include "anim_skeleton.h"
+#include <iostream>
+
+namespace pge
+{
+    // Error bounds are absolute: units for translations and scales, radians for rotations.
+    struct anim_CompressionSettings {
+        float sampleRate; // Keys per second of the uniform grid the clip is resampled on
+        float translationError;
+        float rotationError;
+        float scaleError;
+
+        anim_CompressionSettings(float sampleRate       = 30.0f,
+                                 float translationError = 0.0005f,
+                                 float rotationError    = 0.0005f,
+                                 float scaleError       = 0.0005f)
+            : sampleRate(sampleRate)
+            , translationError(translationError)
+            , rotationError(rotationError)
+            , scaleError(scaleError)
+        {}
+    };
+
+    // A clip resampled on a uniform grid, where every track keeps only the grid frames that linear interpolation
+    // can't reproduce within the error bounds. Constant tracks store a single full precision value. Translations
+    // and scales are 16-bit per component, normalized to the track's range, and rotations are stored as their
+    // three smallest components in 48 bits. All keys and frame numbers live in one 16-bit array.
+    class anim_CompressedAnimation {
+        struct Vec3Track {
+            uint32_t  dataOffset; // Frame numbers, then the quantized values
+            uint32_t  numKeys;    // 1 for a constant track, whose value is rangeMin
+            math_Vec3 rangeMin;
+            math_Vec3 rangeExtent;
+        };
+
+        struct RotationTrack {
+            uint32_t  dataOffset;
+            uint32_t  numKeys;
+            math_Quat constant; // The value of a constant track
+        };
+
+        struct Channel {
+            char          boneName[64];
+            Vec3Track     position;
+            Vec3Track     scale;
+            RotationTrack rotation;
+        };
+
+        std::string           m_name;
+        double                m_duration;
+        float                 m_frameRate; // Grid frames per second, so the last frame falls on the duration
+        unsigned              m_numFrames;
+        std::vector<Channel>  m_channels;
+        std::vector<uint16_t> m_data;
+
+        void CompressVec3Track(const std::vector<math_Vec3>& samples, float maxError, Vec3Track* track);
+        void CompressRotationTrack(const std::vector<math_Quat>& samples, float maxError, RotationTrack* track);
+
+        float    GetFrame(double time) const;
+        unsigned FindKey(const uint16_t* frames, unsigned numKeys, float frame, unsigned* cursor) const;
+
+        math_Vec3 SampleVec3(const Vec3Track& track, float frame, unsigned* cursor) const;
+        math_Quat SampleRotation(const RotationTrack& track, float frame, unsigned* cursor) const;
+
+    public:
+        anim_CompressedAnimation(const anim_SkeletonAnimation& animation, const anim_CompressionSettings& settings = anim_CompressionSettings());
+        anim_CompressedAnimation(std::istream& is);
+
+        const char* GetName() const;
+        double      GetDuration() const;
+        unsigned    GetChannelCount() const;
+        const char* GetBoneName(unsigned channel) const;
+        size_t      GetNumKeys() const;     // Over all tracks
+        size_t      GetSizeInBytes() const; // Of the compressed tracks, as stored in memory and on disk
+
+        // The cursor is optional, and works the same as for the uncompressed channels.
+        void Sample(unsigned            channel,
+                    double              time,
+                    math_Vec3*          position,
+                    math_Quat*          rotation,
+                    math_Vec3*          scale,
+                    anim_ChannelCursor* cursor = nullptr) const;
+
+        // A keyframe clip with the keys that were kept, for code that only plays uncompressed clips
+        anim_SkeletonAnimation Decompress() const;
+
+        friend std::ostream& operator<<(std::ostream& os, const anim_CompressedAnimation& animation);
+        friend std::istream& operator>>(std::istream& is, anim_CompressedAnimation& animation);
+    };
+} // namespace pge
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef PGE_ANIMATION_ANIM_POSE_H
+#define PGE_ANIMATION_ANIM_POSE_H
+
+#include "anim_skeleton.h"
+#include "anim_compression.h"
+#include <math_aabb.h>
+
+namespace pge
+{
+    // ----------------------------------------------
+    // anim_Pose
+    // ----------------------------------------------
+    // The animated state of a skeleton: local translation, rotation and scale per bone, kept in separate arrays,
+    // and the world matrices computed from them. Sized once for its skeleton and meant to be reused every frame.
+    class anim_Pose {
+        const anim_SkeletonDef*  m_skeleton;
+        std::vector<math_Vec3>   m_translations;
+        std::vector<math_Quat>   m_rotations;
+        std::vector<math_Vec3>   m_scales;
+        std::vector<math_Mat4x4> m_world;
+
+    public:
+        explicit anim_Pose(const anim_SkeletonDef* skeleton);
+
+        void SetBindPose();
+
+        // Bones without a channel, or set in skippedBones, keep their current local transform. The binding must have
+        // been made for this pose's skeleton. The cursors, if given, hold one entry per channel of the animation.
+        // Returns the number of bones sampled.
+        size_t Animate(const anim_SkeletonAnimation& animation,
+                       const anim_AnimationBinding&  binding,
+                       double                        time,
+                       anim_ChannelCursor*           cursors      = nullptr,
+                       const uint8_t*                skippedBones = nullptr);
+        size_t Animate(const anim_CompressedAnimation& animation,
+                       const anim_AnimationBinding&    binding,
+                       double                          time,
+                       anim_ChannelCursor*             cursors      = nullptr,
+                       const uint8_t*                  skippedBones = nullptr);
+
+        // Updates the world matrices from the local transforms.
+        void ComputeWorldTransforms();
+
+        const anim_SkeletonDef* GetSkeleton() const;
+        size_t                  GetBoneCount() const;
+
+        math_Vec3*         GetTranslations();
+        math_Quat*         GetRotations();
+        math_Vec3*         GetScales();
+        const math_Vec3*   GetTranslations() const;
+        const math_Quat*   GetRotations() const;
+        const math_Vec3*   GetScales() const;
+        const math_Mat4x4& GetWorldTransform(size_t index) const;
+        const math_Mat4x4* GetWorldTransforms() const;
+    };
+
+    // Blends the local transforms of two poses of the same skeleton into out, which may be either of them.
+    // Rotations are interpolated along the shorter arc and renormalized (nlerp).
+    void anim_BlendPoses(const anim_Pose& from, const anim_Pose& to, float factor, anim_Pose* out);
+
+    // Writes the skinning matrix of every bone, its world transform times its offset from the mesh's bind pose.
+    // The offsets and the palette hold one matrix per bone of the pose.
+    void anim_ComputeSkinningPalette(const anim_Pose& pose, const math_Mat4x4* boneOffsets, math_Mat4x4* palette);
+
+    // Grows the bounds to hold the world position of every bone of the pose.
+    void anim_ExpandBoundsToBones(const anim_Pose& pose, math_AABB* bounds);
+
+    void anim_DebugDraw_Pose(const anim_Pose&   pose,
+                             const math_Mat4x4& modelMatrix = math_Mat4x4::Identity(),
+                             const math_Vec3&   color       = math_Vec3::One(),
+                             float              lineWidth   = 0.01f,
+                             bool               hasDepth    = true);
+} // namespace pge
+
+#endif
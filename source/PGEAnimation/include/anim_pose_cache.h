@@ -0,0 +1,36 @@
+#ifndef PGE_ANIMATION_ANIM_POSE_CACHE_H
+#define PGE_ANIMATION_ANIM_POSE_CACHE_H
+
+#include "anim_animator.h"
+#include <unordered_map>
+
+namespace pge
+{
+    // Shares evaluated poses between animators that play the same clip of the same skeleton at the same quantized
+    // time, like a crowd running one idle cycle. The cache only points at the pose of the first animator with a key,
+    // so it must be cleared whenever animators are updated or destroyed.
+    class anim_PoseCache {
+        struct KeyHash {
+            size_t operator()(const anim_PoseKey& key) const;
+        };
+
+        float                                                        m_timeStep;
+        std::unordered_map<anim_PoseKey, const anim_Pose*, KeyHash> m_poses;
+        size_t                                                       m_numHits;
+        size_t                                                       m_numMisses;
+
+    public:
+        explicit anim_PoseCache(float timeStep = 1.0f / 60);
+
+        void  Clear(); // Also resets the counters
+        float GetTimeStep() const;
+
+        // Evaluates the animator's own pose on a miss, or when it has no key.
+        const anim_Pose& GetPose(const anim_Animator& animator);
+
+        size_t GetNumHits() const;
+        size_t GetNumMisses() const;
+    };
+} // namespace pge
+
+#endif
@@ -2,13 +2,17 @@
 #define PGE_ANIMATION_ANIM_SKELETON_H
 
 #include <math_mat4x4.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 namespace pge
 {
+    class anim_CompressedAnimation;
+
     struct anim_SkeletonBone {
         char        name[64];
-        math_Mat4x4 localTransform;
-        math_Mat4x4 worldTransform;
+        math_Mat4x4 localTransform; // Bind pose, relative to the parent
         int         parentIdx;
     };
 
@@ -22,26 +26,42 @@ namespace pge
         double    time;
     };
 
+    // Per channel, the keys that the previous samples landed on. Sampling starts its search there, so playback that
+    // moves forward costs O(1) per sample instead of a search over all keys.
+    struct anim_ChannelCursor {
+        unsigned position;
+        unsigned scale;
+        unsigned rotation;
+
+        anim_ChannelCursor();
+    };
+
     class anim_SkeletonAnimationChannel {
         char  m_boneName[64];
         void* m_buffer;
 
-        unsigned      m_numPosKeys;
-        anim_KeyVec3* m_positionKeys;
-
-        unsigned      m_numScaleKeys;
-        anim_KeyVec3* m_scaleKeys;
-
-        unsigned      m_numRotKeys;
-        anim_KeyQuat* m_rotationKeys;
-
-        void MakeSkeletonAnimationChannel(const char*         boneName,
-                                          const anim_KeyVec3* posKeys,
-                                          unsigned            numPosKeys,
-                                          const anim_KeyVec3* scaleKeys,
-                                          unsigned            numScaleKeys,
-                                          const anim_KeyQuat* rotKeys,
-                                          unsigned            numRotKeys);
+        // Key times are kept apart from the values, so searching them only touches the times
+        unsigned   m_numPosKeys;
+        float*     m_positionTimes;
+        math_Vec3* m_positions;
+
+        unsigned   m_numScaleKeys;
+        float*     m_scaleTimes;
+        math_Vec3* m_scales;
+
+        unsigned   m_numRotKeys;
+        float*     m_rotationTimes;
+        math_Quat* m_rotations;
+
+        size_t AllocateKeys(unsigned numPosKeys, unsigned numScaleKeys, unsigned numRotKeys);
+        void   MakeSkeletonAnimationChannel(const char*         boneName,
+                                            const anim_KeyVec3* posKeys,
+                                            unsigned            numPosKeys,
+                                            const anim_KeyVec3* scaleKeys,
+                                            unsigned            numScaleKeys,
+                                            const anim_KeyQuat* rotKeys,
+                                            unsigned            numRotKeys);
+        void   CopySkeletonAnimationChannel(const anim_SkeletonAnimationChannel& rhs);
 
     public:
         anim_SkeletonAnimationChannel();
@@ -62,60 +82,83 @@ namespace pge
 
         const char* GetBoneName() const;
 
-        math_Vec3 SamplePosition(double time) const;
-        math_Vec3 SampleScale(double time) const;
-        math_Quat SampleRotation(double time) const;
+        // Without a cursor, every sample does a binary search
+        math_Vec3 SamplePosition(double time, anim_ChannelCursor* cursor = nullptr) const;
+        math_Vec3 SampleScale(double time, anim_ChannelCursor* cursor = nullptr) const;
+        math_Quat SampleRotation(double time, anim_ChannelCursor* cursor = nullptr) const;
 
         friend std::ostream& operator<<(std::ostream& os, const anim_SkeletonAnimationChannel& animation);
         friend std::istream& operator>>(std::istream& is, anim_SkeletonAnimationChannel& animation);
     };
 
+    // Either keyframe channels, or a compressed clip that is sampled as it is played. A compressed clip has no
+    // channels to hand out, so GetChannel(s) return nullptr for it and callers sample through anim_Pose::Animate.
     class anim_SkeletonAnimation {
-        double                                     m_duration;
-        std::vector<anim_SkeletonAnimationChannel> m_channels;
-        std::string                                m_name;
+        double                                          m_duration;
+        std::vector<anim_SkeletonAnimationChannel>      m_channels;
+        std::string                                     m_name;
+        std::shared_ptr<const anim_CompressedAnimation> m_compressed;
 
     public:
         anim_SkeletonAnimation(std::istream& is);
         anim_SkeletonAnimation(const char* name, double duration, const anim_SkeletonAnimationChannel* channels, unsigned numChannels);
+        explicit anim_SkeletonAnimation(std::shared_ptr<const anim_CompressedAnimation> compressed);
         double                               GetDuration() const;
         const anim_SkeletonAnimationChannel* GetChannel(const char* boneName) const;
         const anim_SkeletonAnimationChannel* GetChannels() const;
         unsigned                             GetChannelCount() const;
+        const char*                          GetBoneName(unsigned channel) const;
         const char*                          GetName() const;
+        const anim_CompressedAnimation*      GetCompressed() const;
 
         friend std::ostream& operator<<(std::ostream& os, const anim_SkeletonAnimation& animation);
         friend std::istream& operator>>(std::istream& is, anim_SkeletonAnimation& animation);
     };
 
-    class anim_Skeleton {
+    // ----------------------------------------------
+    // anim_SkeletonDef
+    // ----------------------------------------------
+    // The immutable part of a skeleton: bone names, hierarchy and bind pose. It is shared by every animator that
+    // uses it; the animated state lives in an anim_Pose. Parents always come before their children.
+    class anim_SkeletonDef {
         std::vector<anim_SkeletonBone> m_bones;
-
-        anim_SkeletonBone* FindBone(const char* name);
+        std::vector<math_Vec3>         m_bindTranslations;
+        std::vector<math_Quat>         m_bindRotations;
+        std::vector<math_Vec3>         m_bindScales;
+        std::vector<int>               m_parentIndices;
+        std::vector<uint8_t>           m_leafBones;       // 1 for bones without children
+        std::vector<int>               m_unfactoredBones; // Bones whose bind transform isn't T * S * R
 
     public:
-        anim_Skeleton(anim_SkeletonBone* bones, unsigned numBones);
-        anim_Skeleton(const anim_Skeleton& rhs);
-        anim_Skeleton(const anim_Skeleton&& rhs);
-
-        anim_Skeleton& operator=(const anim_Skeleton& rhs);
-        anim_Skeleton& operator=(anim_Skeleton&& rhs);
-
-        void Transform();
-        void Animate(const anim_SkeletonAnimation& animation, double time);
-        void Animate(const anim_SkeletonAnimation& from, double fromTime, const anim_SkeletonAnimation& to, double toTime, float factor);
+        anim_SkeletonDef(const anim_SkeletonBone* bones, unsigned numBones);
 
         size_t                   GetBoneCount() const;
         const anim_SkeletonBone& GetBone(size_t index) const;
         int                      GetBoneIndex(const char* name) const;
+
+        const math_Vec3* GetBindTranslations() const;
+        const math_Quat* GetBindRotations() const;
+        const math_Vec3* GetBindScales() const;
+        const int*       GetParentIndices() const;
+        const uint8_t*   GetLeafBoneMask() const;
+
+        // Bind transforms with a non-uniform scale applied before the rotation (as imported, T * R * S) can't be
+        // rebuilt from the bind translation, rotation and scale; poses use the bone's local transform instead.
+        const std::vector<int>& GetUnfactoredBones() const;
     };
 
-    void anim_DebugDraw_Skeleton(const anim_Skeleton& skeleton,
-                                 const math_Mat4x4&   modelMatrix = math_Mat4x4::Identity(),
-                                 const math_Vec3&     color       = math_Vec3::One(),
-                                 float                lineWidth   = 0.01f,
-                                 bool                 hasDepth    = true);
+    // Maps the bones of a skeleton to the channels of an animation, so evaluating it never has to compare bone names.
+    class anim_AnimationBinding {
+        std::vector<int> m_boneChannels; // Channel index per bone, -1 if the animation leaves the bone alone
 
+    public:
+        anim_AnimationBinding() = default;
+        anim_AnimationBinding(const anim_SkeletonDef& skeleton, const anim_SkeletonAnimation& animation);
+        anim_AnimationBinding(const anim_SkeletonDef& skeleton, const anim_CompressedAnimation& animation);
+
+        size_t GetBoneCount() const;
+        int    GetChannelIndex(size_t boneIndex) const;
+    };
 } // namespace pge
 
 #endif
\ No newline at end of file
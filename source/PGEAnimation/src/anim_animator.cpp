@@ -1,23 +1,27 @@
 #include "../include/anim_animator.h"
 
 #include <core_assert.h>
+#include <algorithm>
 
 namespace pge
 {
     void
-    anim_AnimatorConfig::Initialize(const anim_Skeleton*        skeleton,
+    anim_AnimatorConfig::Initialize(const anim_SkeletonDef*     skeleton,
                                     const anim_AnimationState*  states,
                                     unsigned int                numStates,
                                     const anim_TransitionParam* transitions,
                                     unsigned int                numTransitions)
     {
         m_states.clear();
+        m_bindings.clear();
         m_transitions.clear();
         m_skeleton = skeleton;
 
         m_states.reserve(numStates);
+        m_bindings.reserve(numStates);
         for (unsigned i = 0; i < numStates; ++i) {
             m_states.emplace_back(states[i]);
+            m_bindings.emplace_back(*skeleton, *states[i].animation);
         }
 
         m_transitions.reserve(numTransitions);
@@ -35,12 +39,28 @@ namespace pge
             transition.from     = &*fromIt;
             transition.to       = &*toIt;
             transition.duration = transParam.duration;
-            transition.trigger  = transParam.trigger;
+            transition.trigger  = anim_HashTrigger(transParam.trigger.c_str());
             m_transitions.emplace_back(transition);
         }
+
+        // Compile the transitions into a table per state, so triggering one only compares ids within its state
+        std::stable_sort(m_transitions.begin(), m_transitions.end(), [](const Transition& lhs, const Transition& rhs) { return lhs.from < rhs.from; });
+        m_firstTransition.assign(numStates + 1, 0);
+        for (const Transition& transition : m_transitions) {
+            ++m_firstTransition[transition.from - &m_states[0] + 1];
+        }
+        for (unsigned i = 0; i < numStates; ++i) {
+            m_firstTransition[i + 1] += m_firstTransition[i];
+            for (unsigned a = m_firstTransition[i]; a < m_firstTransition[i + 1]; ++a) {
+                for (unsigned b = a + 1; b < m_firstTransition[i + 1]; ++b) {
+                    core_AssertWithReason(m_transitions[a].trigger != m_transitions[b].trigger,
+                                          "A state has two transitions with the same trigger, or triggers whose ids collide");
+                }
+            }
+        }
     }
 
-    anim_AnimatorConfig::anim_AnimatorConfig(const anim_Skeleton*        skeleton,
+    anim_AnimatorConfig::anim_AnimatorConfig(const anim_SkeletonDef*     skeleton,
                                              const anim_AnimationState*  states,
                                              unsigned                    numStates,
                                              const anim_TransitionParam* transitions,
@@ -49,47 +69,97 @@ namespace pge
         Initialize(skeleton, states, numStates, transitions, numTransitions);
     }
 
+    const anim_SkeletonDef*
+    anim_AnimatorConfig::GetSkeleton() const
+    {
+        return m_skeleton;
+    }
+
+    unsigned
+    anim_AnimatorConfig::GetStateCount() const
+    {
+        return m_states.size();
+    }
+
+    const anim_AnimationState&
+    anim_AnimatorConfig::GetState(unsigned index) const
+    {
+        core_Assert(index < m_states.size());
+        return m_states[index];
+    }
+
+    const anim_AnimationBinding&
+    anim_AnimatorConfig::GetBinding(const anim_AnimationState* state) const
+    {
+        core_Assert(state >= &m_states[0] && state < &m_states[0] + m_states.size());
+        return m_bindings[state - &m_states[0]];
+    }
+
+    const anim_AnimatorConfig::Transition*
+    anim_AnimatorConfig::FindTransition(const anim_AnimationState* from, anim_TriggerId trigger) const
+    {
+        const size_t stateIdx = from - &m_states[0];
+        for (unsigned i = m_firstTransition[stateIdx]; i < m_firstTransition[stateIdx + 1]; ++i) {
+            if (m_transitions[i].trigger == trigger)
+                return &m_transitions[i];
+        }
+        return nullptr;
+    }
+
+    bool
+    anim_PoseKey::operator==(const anim_PoseKey& rhs) const
+    {
+        return skeleton == rhs.skeleton && animation == rhs.animation && frame == rhs.frame && skipLeafBones == rhs.skipLeafBones;
+    }
+
     anim_Animator::anim_Animator(const anim_AnimatorConfig* config)
         : m_config(config)
         , m_currentTrans(nullptr)
         , m_currentAnimTime(0)
         , m_transitTime(0)
+        , m_pose(config->m_skeleton)
+        , m_blendPose(config->m_skeleton)
+        , m_poseOutdated(true)
+        , m_numEvaluatedBones(0)
     {
         core_Assert(config->m_states.size() > 0);
         m_currentState = &config->m_states[0];
     }
 
     void
-    anim_Animator::Trigger(const char* trigger)
+    anim_Animator::Trigger(anim_TriggerId trigger)
     {
         if (m_currentTrans != nullptr) {
             // If currently transitioning, allow transitions on trigger for destination node
-            for (const auto& transition : m_config->m_transitions) {
-                if (transition.from != m_currentTrans->to)
-                    continue;
-                if (transition.trigger == trigger) {
-                    float prevTransProg = m_transitTime / m_currentTrans->duration;
-                    m_currentTrans      = &transition;
-                    m_transitTime       = m_currentTrans->duration * (1 - prevTransProg);
-                    m_currentState      = m_currentTrans->from;
-                }
+            const anim_AnimatorConfig::Transition* transition = m_config->FindTransition(m_currentTrans->to, trigger);
+            if (transition != nullptr) {
+                float prevTransProg = m_transitTime / m_currentTrans->duration;
+                m_currentTrans      = transition;
+                m_transitTime       = m_currentTrans->duration * (1 - prevTransProg);
+                m_currentState      = m_currentTrans->from;
+                m_poseOutdated      = true;
             }
         } else {
             // If not currently transitioning, check for new transitions on trigger
-            for (const auto& transition : m_config->m_transitions) {
-                if (transition.from != m_currentState)
-                    continue;
-                if (transition.trigger == trigger) {
-                    m_currentTrans = &transition;
-                    m_transitTime  = 0;
-                }
+            const anim_AnimatorConfig::Transition* transition = m_config->FindTransition(m_currentState, trigger);
+            if (transition != nullptr) {
+                m_currentTrans = transition;
+                m_transitTime  = 0;
+                m_poseOutdated = true;
             }
         }
     }
 
+    void
+    anim_Animator::Trigger(const char* trigger)
+    {
+        Trigger(anim_HashTrigger(trigger));
+    }
+
     void
     anim_Animator::Update(float dt)
     {
+        m_poseOutdated = true;
         if (m_currentTrans == nullptr) {
             m_currentAnimTime += dt;
 
@@ -109,17 +179,101 @@ namespace pge
         }
     }
 
-    anim_Skeleton
-    anim_Animator::GetAnimatedSkeleton() const
+    const anim_Pose&
+    anim_Animator::GetPose() const
     {
-        anim_Skeleton animatedSkel = *m_config->m_skeleton;
+        if (!m_poseOutdated)
+            return m_pose;
+
+        const uint8_t* skippedBones = m_lod.skipLeafBones ? m_config->m_skeleton->GetLeafBoneMask() : nullptr;
+        m_pose.SetBindPose();
         if (m_currentTrans == nullptr) {
-            animatedSkel.Animate(*m_currentState->animation, m_currentAnimTime);
+            const anim_SkeletonAnimation& animation = *m_currentState->animation;
+            m_cursors.resize(std::max<size_t>(m_cursors.size(), animation.GetChannelCount()));
+            m_numEvaluatedBones = m_pose.Animate(animation, m_config->GetBinding(m_currentState), m_currentAnimTime, m_cursors.data(), skippedBones);
         } else {
-            float factor = m_transitTime / m_currentTrans->duration;
-            animatedSkel.Animate(*m_currentTrans->from->animation, m_currentAnimTime, *m_currentTrans->to->animation, 0, factor);
+            // The destination is sampled at its first keys, which needs no cursor
+            const anim_AnimationState* from   = m_currentTrans->from;
+            const anim_AnimationState* to     = m_currentTrans->to;
+            float                      factor = m_transitTime / m_currentTrans->duration;
+            m_cursors.resize(std::max<size_t>(m_cursors.size(), from->animation->GetChannelCount()));
+            if (m_lod.singleClip && factor >= 0.5f) {
+                m_numEvaluatedBones = m_pose.Animate(*to->animation, m_config->GetBinding(to), 0, nullptr, skippedBones);
+            } else {
+                m_numEvaluatedBones = m_pose.Animate(*from->animation, m_config->GetBinding(from), m_currentAnimTime, m_cursors.data(), skippedBones);
+            }
+            if (!m_lod.singleClip) {
+                m_blendPose.SetBindPose();
+                m_numEvaluatedBones += m_blendPose.Animate(*to->animation, m_config->GetBinding(to), 0, nullptr, skippedBones);
+                anim_BlendPoses(m_pose, m_blendPose, factor, &m_pose);
+            }
+        }
+        m_pose.ComputeWorldTransforms();
+        m_poseOutdated = false;
+        return m_pose;
+    }
+
+    bool
+    anim_Animator::IsPoseOutdated() const
+    {
+        return m_poseOutdated;
+    }
+
+    size_t
+    anim_Animator::GetNumEvaluatedBones() const
+    {
+        return m_numEvaluatedBones;
+    }
+
+    bool
+    anim_Animator::GetPoseKey(float timeStep, anim_PoseKey* key) const
+    {
+        core_Assert(timeStep > 0);
+        if (m_currentTrans != nullptr)
+            return false;
+
+        key->skeleton      = m_config->m_skeleton;
+        key->animation     = m_currentState->animation;
+        key->frame         = static_cast<uint32_t>(std::max(m_currentAnimTime, 0.0f) / timeStep);
+        key->skipLeafBones = m_lod.skipLeafBones;
+        return true;
+    }
+
+    const anim_AnimationState*
+    anim_Animator::GetDominantState(float* time) const
+    {
+        if (m_currentTrans != nullptr && m_transitTime >= 0.5f * m_currentTrans->duration) {
+            *time = 0;
+            return m_currentTrans->to;
+        }
+        *time = m_currentAnimTime;
+        return m_currentState;
+    }
+
+    const anim_SkeletonDef*
+    anim_Animator::GetSkeleton() const
+    {
+        return m_config->m_skeleton;
+    }
+
+    const anim_AnimatorConfig*
+    anim_Animator::GetConfig() const
+    {
+        return m_config;
+    }
+
+    void
+    anim_Animator::SetLod(const anim_AnimatorLod& lod)
+    {
+        if (lod.skipLeafBones != m_lod.skipLeafBones || lod.singleClip != m_lod.singleClip) {
+            m_lod          = lod;
+            m_poseOutdated = true;
         }
-        animatedSkel.Transform();
-        return animatedSkel;
     }
-} // namespace pge
\ No newline at end of file
+
+    const anim_AnimatorLod&
+    anim_Animator::GetLod() const
+    {
+        return m_lod;
+    }
+} // namespace pge
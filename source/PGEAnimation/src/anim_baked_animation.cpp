@@ -0,0 +1,98 @@
+#include "../include/anim_baked_animation.h"
+#include "../include/anim_pose.h"
+
+#include <core_assert.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace pge
+{
+    anim_BakedAnimation::anim_BakedAnimation(const anim_SkeletonDef&       skeleton,
+                                             const anim_SkeletonAnimation& animation,
+                                             const math_Mat4x4*            boneOffsets,
+                                             float                         sampleRate)
+        : m_animation(&animation)
+        , m_numBones(skeleton.GetBoneCount())
+        , m_numFrames(1)
+        , m_frameRate(0)
+        , m_boneBounds(math_Vec3(FLT_MAX, FLT_MAX, FLT_MAX), math_Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX))
+    {
+        core_Assert(sampleRate > 0);
+        const double duration = animation.GetDuration();
+        if (duration > 0) {
+            m_numFrames = static_cast<unsigned>(std::ceil(duration * sampleRate)) + 1;
+            m_frameRate = static_cast<float>((m_numFrames - 1) / duration);
+        }
+        m_palettes.resize(m_numFrames * m_numBones);
+
+        anim_Pose                       pose(&skeleton);
+        anim_AnimationBinding           binding(skeleton, animation);
+        std::vector<anim_ChannelCursor> cursors(animation.GetChannelCount());
+        for (unsigned frame = 0; frame < m_numFrames; ++frame) {
+            double time = frame + 1 < m_numFrames ? frame / static_cast<double>(m_frameRate) : duration;
+            pose.SetBindPose();
+            pose.Animate(animation, binding, time, cursors.data());
+            pose.ComputeWorldTransforms();
+            anim_ComputeSkinningPalette(pose, boneOffsets, &m_palettes[frame * m_numBones]);
+            anim_ExpandBoundsToBones(pose, &m_boneBounds);
+        }
+    }
+
+    const anim_SkeletonAnimation*
+    anim_BakedAnimation::GetAnimation() const
+    {
+        return m_animation;
+    }
+
+    size_t
+    anim_BakedAnimation::GetBoneCount() const
+    {
+        return m_numBones;
+    }
+
+    unsigned
+    anim_BakedAnimation::GetFrameCount() const
+    {
+        return m_numFrames;
+    }
+
+    size_t
+    anim_BakedAnimation::GetSizeInBytes() const
+    {
+        return m_palettes.size() * sizeof(math_Mat4x4);
+    }
+
+    const math_AABB&
+    anim_BakedAnimation::GetBoneBounds() const
+    {
+        return m_boneBounds;
+    }
+
+    const math_Mat4x4*
+    anim_BakedAnimation::GetPalette(unsigned frame) const
+    {
+        core_Assert(frame < m_numFrames);
+        return &m_palettes[frame * m_numBones];
+    }
+
+    void
+    anim_BakedAnimation::Sample(double time, bool interpolate, math_Mat4x4* palette) const
+    {
+        float    frame = std::min(std::max(static_cast<float>(time * m_frameRate), 0.0f), static_cast<float>(m_numFrames - 1));
+        unsigned first = static_cast<unsigned>(frame);
+        float    t     = frame - first;
+        if (!interpolate || first + 1 == m_numFrames) {
+            unsigned nearest = t < 0.5f ? first : std::min(first + 1, m_numFrames - 1);
+            memcpy(palette, GetPalette(nearest), m_numBones * sizeof(math_Mat4x4));
+            return;
+        }
+
+        const float* from = GetPalette(first)[0].values;
+        const float* to   = GetPalette(first + 1)[0].values;
+        float*       out  = palette[0].values;
+        for (size_t i = 0; i < m_numBones * 16; ++i)
+            out[i] = from[i] + (to[i] - from[i]) * t;
+    }
+} // namespace pge
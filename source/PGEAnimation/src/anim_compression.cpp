@@ -0,0 +1,444 @@
+#include "../include/anim_compression.h"
+
+#include <math_interp.h>
+#include <core_assert.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+
+namespace pge
+{
+    // ----------------------------------------------
+    // Quantization
+    // ----------------------------------------------
+    static const float QUANT_MAX_U16 = 65535.0f;
+    static const float QUANT_MAX_U15 = 32767.0f;
+
+    // The three smallest components of a unit quaternion lie within +-1/sqrt(2)
+    static const float SMALLEST_THREE_RANGE = 0.70710678f;
+
+    static uint16_t
+    QuantizeUnit(float value, float maxValue)
+    {
+        return static_cast<uint16_t>(std::min(std::max(value, 0.0f), 1.0f) * maxValue + 0.5f);
+    }
+
+    static void
+    EncodeVec3(const math_Vec3& value, const math_Vec3& rangeMin, const math_Vec3& rangeExtent, uint16_t* out)
+    {
+        for (size_t i = 0; i < 3; ++i) {
+            out[i] = rangeExtent[i] > 0 ? QuantizeUnit((value[i] - rangeMin[i]) / rangeExtent[i], QUANT_MAX_U16) : 0;
+        }
+    }
+
+    static math_Vec3
+    DecodeVec3(const uint16_t* in, const math_Vec3& rangeMin, const math_Vec3& rangeExtent)
+    {
+        const float scale = 1.0f / QUANT_MAX_U16;
+        return math_Vec3(rangeMin.x + in[0] * scale * rangeExtent.x,
+                         rangeMin.y + in[1] * scale * rangeExtent.y,
+                         rangeMin.z + in[2] * scale * rangeExtent.z);
+    }
+
+    // The index of the largest component goes into the top bits of the first two words
+    static void
+    EncodeRotation(const math_Quat& rotation, uint16_t* out)
+    {
+        const math_Quat q             = math_Normalize(rotation);
+        const float     components[4] = {q.w, q.x, q.y, q.z};
+
+        unsigned largest = 0;
+        for (unsigned i = 1; i < 4; ++i) {
+            if (fabsf(components[i]) > fabsf(components[largest]))
+                largest = i;
+        }
+        // q and -q are the same rotation, so the dropped component can always be made positive
+        const float sign = components[largest] < 0 ? -1.0f : 1.0f;
+        for (unsigned i = 0, j = 0; i < 4; ++i) {
+            if (i == largest)
+                continue;
+            const float normalized = (sign * components[i] / SMALLEST_THREE_RANGE + 1.0f) * 0.5f;
+            out[j++]               = QuantizeUnit(normalized, QUANT_MAX_U15);
+        }
+        out[0] |= static_cast<uint16_t>((largest >> 1) << 15);
+        out[1] |= static_cast<uint16_t>((largest & 1) << 15);
+    }
+
+    static math_Quat
+    DecodeRotation(const uint16_t* in)
+    {
+        const unsigned largest = ((in[0] >> 15) << 1) | (in[1] >> 15);
+        const float    scale   = 2.0f * SMALLEST_THREE_RANGE / QUANT_MAX_U15;
+        const float    a       = (in[0] & 0x7fff) * scale - SMALLEST_THREE_RANGE;
+        const float    b       = (in[1] & 0x7fff) * scale - SMALLEST_THREE_RANGE;
+        const float    c       = (in[2] & 0x7fff) * scale - SMALLEST_THREE_RANGE;
+        const float    d       = sqrtf(std::max(0.0f, 1.0f - a * a - b * b - c * c));
+        switch (largest) {
+            case 0: return math_Quat(d, a, b, c);
+            case 1: return math_Quat(a, d, b, c);
+            case 2: return math_Quat(a, b, d, c);
+            default: return math_Quat(a, b, c, d);
+        }
+    }
+
+    static math_Quat
+    NlerpRotation(const math_Quat& from, const math_Quat& to, float factor)
+    {
+        const math_Quat target = math_Dot(from, to) < 0 ? -to : to;
+        return math_Normalize(math_Lerp(from, target, factor));
+    }
+
+    static float
+    RotationDistance(const math_Quat& a, const math_Quat& b)
+    {
+        return 2.0f * acosf(std::min(1.0f, fabsf(math_Dot(math_Normalize(a), math_Normalize(b)))));
+    }
+
+    // Greedily extends every segment for as long as interpolating between its (decoded) end keys stays within
+    // the error bound at all original samples in between.
+    template <typename T, typename Interpolate, typename Distance>
+    static std::vector<uint16_t>
+    ReduceKeys(const std::vector<T>& samples, const std::vector<T>& decoded, float maxError, Interpolate interpolate, Distance distance)
+    {
+        const unsigned        numFrames = static_cast<unsigned>(samples.size());
+        std::vector<uint16_t> keys      = {0};
+        unsigned              start     = 0;
+        while (start + 1 < numFrames) {
+            unsigned end = start + 1;
+            while (end + 1 < numFrames) {
+                const unsigned candidate = end + 1;
+                bool           fits      = true;
+                for (unsigned f = start + 1; f < candidate && fits; ++f) {
+                    const float factor = float(f - start) / float(candidate - start);
+                    fits               = distance(interpolate(decoded[start], decoded[candidate], factor), samples[f]) <= maxError;
+                }
+                if (!fits)
+                    break;
+                end = candidate;
+            }
+            keys.push_back(static_cast<uint16_t>(end));
+            start = end;
+        }
+        return keys;
+    }
+
+
+    // ----------------------------------------------
+    // anim_CompressedAnimation
+    // ----------------------------------------------
+    anim_CompressedAnimation::anim_CompressedAnimation(const anim_SkeletonAnimation& animation, const anim_CompressionSettings& settings)
+        : m_name(animation.GetName())
+        , m_duration(animation.GetDuration())
+    {
+        core_Assert(settings.sampleRate > 0);
+        core_AssertWithReason(animation.GetCompressed() == nullptr, "The clip is compressed already");
+        m_numFrames = static_cast<unsigned>(ceil(m_duration * settings.sampleRate)) + 1;
+        m_frameRate = m_duration > 0 ? float((m_numFrames - 1) / m_duration) : 0.0f;
+        core_AssertWithReason(m_numFrames <= 65536, "Frame numbers are stored in 16 bits");
+
+        std::vector<math_Vec3> positions(m_numFrames), scales(m_numFrames);
+        std::vector<math_Quat> rotations(m_numFrames);
+        m_channels.resize(animation.GetChannelCount());
+        for (unsigned c = 0; c < animation.GetChannelCount(); ++c) {
+            const anim_SkeletonAnimationChannel& source = animation.GetChannels()[c];
+            anim_ChannelCursor                   cursor;
+            for (unsigned f = 0; f < m_numFrames; ++f) {
+                const double time = m_frameRate > 0 ? std::min(f / double(m_frameRate), m_duration) : 0.0;
+                positions[f]      = source.SamplePosition(time, &cursor);
+                scales[f]         = source.SampleScale(time, &cursor);
+                rotations[f]      = math_Normalize(source.SampleRotation(time, &cursor));
+            }
+
+            Channel& channel = m_channels[c];
+            memset(channel.boneName, 0, sizeof(channel.boneName));
+            strncpy(channel.boneName, source.GetBoneName(), sizeof(channel.boneName) - 1);
+            CompressVec3Track(positions, settings.translationError, &channel.position);
+            CompressVec3Track(scales, settings.scaleError, &channel.scale);
+            CompressRotationTrack(rotations, settings.rotationError, &channel.rotation);
+        }
+    }
+
+    anim_CompressedAnimation::anim_CompressedAnimation(std::istream& is)
+    {
+        is >> *this;
+    }
+
+    void
+    anim_CompressedAnimation::CompressVec3Track(const std::vector<math_Vec3>& samples, float maxError, Vec3Track* track)
+    {
+        math_Vec3 rangeMin = samples[0], rangeMax = samples[0];
+        bool      constant = true;
+        for (const math_Vec3& sample : samples) {
+            for (size_t i = 0; i < 3; ++i) {
+                rangeMin[i] = std::min(rangeMin[i], sample[i]);
+                rangeMax[i] = std::max(rangeMax[i], sample[i]);
+            }
+            constant = constant && math_Length(sample - samples[0]) <= maxError;
+        }
+
+        track->dataOffset = static_cast<uint32_t>(m_data.size());
+        if (constant) {
+            track->numKeys     = 1;
+            track->rangeMin    = samples[0];
+            track->rangeExtent = math_Vec3(0, 0, 0);
+            return;
+        }
+        track->rangeMin    = rangeMin;
+        track->rangeExtent = rangeMax - rangeMin;
+
+        std::vector<math_Vec3> decoded(samples.size());
+        for (size_t f = 0; f < samples.size(); ++f) {
+            uint16_t quantized[3];
+            EncodeVec3(samples[f], track->rangeMin, track->rangeExtent, quantized);
+            decoded[f] = DecodeVec3(quantized, track->rangeMin, track->rangeExtent);
+        }
+        auto lerp     = [](const math_Vec3& a, const math_Vec3& b, float t) { return math_Lerp(a, b, t); };
+        auto distance = [](const math_Vec3& a, const math_Vec3& b) { return math_Length(a - b); };
+        const std::vector<uint16_t> keys = ReduceKeys(samples, decoded, maxError, lerp, distance);
+
+        track->numKeys = static_cast<uint32_t>(keys.size());
+        m_data.insert(m_data.end(), keys.begin(), keys.end());
+        for (uint16_t frame : keys) {
+            uint16_t quantized[3];
+            EncodeVec3(samples[frame], track->rangeMin, track->rangeExtent, quantized);
+            m_data.insert(m_data.end(), quantized, quantized + 3);
+        }
+    }
+
+    void
+    anim_CompressedAnimation::CompressRotationTrack(const std::vector<math_Quat>& samples, float maxError, RotationTrack* track)
+    {
+        bool constant = true;
+        for (const math_Quat& sample : samples) {
+            constant = constant && RotationDistance(sample, samples[0]) <= maxError;
+        }
+
+        track->dataOffset = static_cast<uint32_t>(m_data.size());
+        track->constant   = samples[0];
+        if (constant) {
+            track->numKeys = 1;
+            return;
+        }
+
+        std::vector<math_Quat> decoded(samples.size());
+        for (size_t f = 0; f < samples.size(); ++f) {
+            uint16_t quantized[3];
+            EncodeRotation(samples[f], quantized);
+            decoded[f] = DecodeRotation(quantized);
+        }
+        const std::vector<uint16_t> keys = ReduceKeys(samples, decoded, maxError, NlerpRotation, RotationDistance);
+
+        track->numKeys = static_cast<uint32_t>(keys.size());
+        m_data.insert(m_data.end(), keys.begin(), keys.end());
+        for (uint16_t frame : keys) {
+            uint16_t quantized[3];
+            EncodeRotation(samples[frame], quantized);
+            m_data.insert(m_data.end(), quantized, quantized + 3);
+        }
+    }
+
+    const char*
+    anim_CompressedAnimation::GetName() const
+    {
+        return m_name.c_str();
+    }
+
+    double
+    anim_CompressedAnimation::GetDuration() const
+    {
+        return m_duration;
+    }
+
+    unsigned
+    anim_CompressedAnimation::GetChannelCount() const
+    {
+        return static_cast<unsigned>(m_channels.size());
+    }
+
+    const char*
+    anim_CompressedAnimation::GetBoneName(unsigned channel) const
+    {
+        core_Assert(channel < m_channels.size());
+        return m_channels[channel].boneName;
+    }
+
+    size_t
+    anim_CompressedAnimation::GetNumKeys() const
+    {
+        size_t numKeys = 0;
+        for (const Channel& channel : m_channels) {
+            numKeys += channel.position.numKeys + channel.scale.numKeys + channel.rotation.numKeys;
+        }
+        return numKeys;
+    }
+
+    size_t
+    anim_CompressedAnimation::GetSizeInBytes() const
+    {
+        return m_channels.size() * sizeof(Channel) + m_data.size() * sizeof(uint16_t);
+    }
+
+    float
+    anim_CompressedAnimation::GetFrame(double time) const
+    {
+        const float frame = static_cast<float>(time * m_frameRate);
+        return std::min(std::max(frame, 0.0f), float(m_numFrames - 1));
+    }
+
+    // Returns the key at or before the frame, which always has a next key; the caller handles the last key.
+    unsigned
+    anim_CompressedAnimation::FindKey(const uint16_t* frames, unsigned numKeys, float frame, unsigned* cursor) const
+    {
+        if (cursor != nullptr) {
+            const unsigned key = *cursor;
+            if (key + 1 < numKeys && frames[key] <= frame && frame < frames[key + 1])
+                return key;
+            if (key + 2 < numKeys && frames[key + 1] <= frame && frame < frames[key + 2])
+                return *cursor = key + 1;
+        }
+        const unsigned key = static_cast<unsigned>(std::upper_bound(frames, frames + numKeys, frame) - frames) - 1;
+        if (cursor != nullptr)
+            *cursor = key;
+        return key;
+    }
+
+    math_Vec3
+    anim_CompressedAnimation::SampleVec3(const Vec3Track& track, float frame, unsigned* cursor) const
+    {
+        if (track.numKeys == 1)
+            return track.rangeMin;
+
+        const uint16_t* frames = &m_data[track.dataOffset];
+        const uint16_t* values = frames + track.numKeys;
+        const unsigned  key    = std::min(FindKey(frames, track.numKeys, frame, cursor), track.numKeys - 2);
+        const float     factor = std::min((frame - frames[key]) / float(frames[key + 1] - frames[key]), 1.0f);
+        return math_Lerp(DecodeVec3(values + key * 3, track.rangeMin, track.rangeExtent),
+                         DecodeVec3(values + key * 3 + 3, track.rangeMin, track.rangeExtent),
+                         factor);
+    }
+
+    math_Quat
+    anim_CompressedAnimation::SampleRotation(const RotationTrack& track, float frame, unsigned* cursor) const
+    {
+        if (track.numKeys == 1)
+            return track.constant;
+
+        const uint16_t* frames = &m_data[track.dataOffset];
+        const uint16_t* values = frames + track.numKeys;
+        const unsigned  key    = std::min(FindKey(frames, track.numKeys, frame, cursor), track.numKeys - 2);
+        const float     factor = std::min((frame - frames[key]) / float(frames[key + 1] - frames[key]), 1.0f);
+        return NlerpRotation(DecodeRotation(values + key * 3), DecodeRotation(values + key * 3 + 3), factor);
+    }
+
+    void
+    anim_CompressedAnimation::Sample(unsigned            channel,
+                                     double              time,
+                                     math_Vec3*          position,
+                                     math_Quat*          rotation,
+                                     math_Vec3*          scale,
+                                     anim_ChannelCursor* cursor) const
+    {
+        core_Assert(channel < m_channels.size());
+        const Channel& c     = m_channels[channel];
+        const float    frame = GetFrame(time);
+        *position            = SampleVec3(c.position, frame, cursor != nullptr ? &cursor->position : nullptr);
+        *rotation            = SampleRotation(c.rotation, frame, cursor != nullptr ? &cursor->rotation : nullptr);
+        *scale               = SampleVec3(c.scale, frame, cursor != nullptr ? &cursor->scale : nullptr);
+    }
+
+    anim_SkeletonAnimation
+    anim_CompressedAnimation::Decompress() const
+    {
+        auto frameTime = [this](uint16_t frame) { return m_frameRate > 0 ? std::min(frame / double(m_frameRate), m_duration) : 0.0; };
+
+        std::vector<anim_SkeletonAnimationChannel> channels;
+        channels.reserve(m_channels.size());
+        for (const Channel& channel : m_channels) {
+            std::vector<anim_KeyVec3> keys[2];
+            const Vec3Track*          tracks[2] = {&channel.position, &channel.scale};
+            for (size_t t = 0; t < 2; ++t) {
+                const Vec3Track& track = *tracks[t];
+                keys[t].resize(track.numKeys);
+                if (track.numKeys == 1) {
+                    keys[t][0].time  = 0;
+                    keys[t][0].value = track.rangeMin;
+                    continue;
+                }
+                const uint16_t* frames = &m_data[track.dataOffset];
+                for (uint32_t k = 0; k < track.numKeys; ++k) {
+                    keys[t][k].time  = frameTime(frames[k]);
+                    keys[t][k].value = DecodeVec3(frames + track.numKeys + k * 3, track.rangeMin, track.rangeExtent);
+                }
+            }
+
+            const RotationTrack&      track = channel.rotation;
+            std::vector<anim_KeyQuat> rotationKeys(track.numKeys);
+            if (track.numKeys == 1) {
+                rotationKeys[0].time  = 0;
+                rotationKeys[0].value = track.constant;
+            } else {
+                const uint16_t* frames = &m_data[track.dataOffset];
+                for (uint32_t k = 0; k < track.numKeys; ++k) {
+                    rotationKeys[k].time  = frameTime(frames[k]);
+                    rotationKeys[k].value = DecodeRotation(frames + track.numKeys + k * 3);
+                }
+            }
+
+            channels.emplace_back(channel.boneName,
+                                  keys[0].data(),
+                                  static_cast<unsigned>(keys[0].size()),
+                                  keys[1].data(),
+                                  static_cast<unsigned>(keys[1].size()),
+                                  rotationKeys.data(),
+                                  static_cast<unsigned>(rotationKeys.size()));
+        }
+        return anim_SkeletonAnimation(m_name.c_str(), m_duration, channels.data(), static_cast<unsigned>(channels.size()));
+    }
+
+    std::ostream&
+    operator<<(std::ostream& os, const anim_CompressedAnimation& animation)
+    {
+        unsigned nameLen = animation.m_name.size();
+        os.write((const char*)&nameLen, sizeof(nameLen));
+        os.write(animation.m_name.c_str(), nameLen);
+        os.write((const char*)&animation.m_duration, sizeof(animation.m_duration));
+        os.write((const char*)&animation.m_frameRate, sizeof(animation.m_frameRate));
+        os.write((const char*)&animation.m_numFrames, sizeof(animation.m_numFrames));
+
+        unsigned numChannels = animation.m_channels.size();
+        os.write((const char*)&numChannels, sizeof(numChannels));
+        os.write((const char*)animation.m_channels.data(), numChannels * sizeof(animation.m_channels[0]));
+
+        unsigned dataSize = animation.m_data.size();
+        os.write((const char*)&dataSize, sizeof(dataSize));
+        os.write((const char*)animation.m_data.data(), dataSize * sizeof(animation.m_data[0]));
+        return os;
+    }
+
+    std::istream&
+    operator>>(std::istream& is, anim_CompressedAnimation& animation)
+    {
+        unsigned nameLen = 0;
+        is.read((char*)&nameLen, sizeof(nameLen));
+        std::unique_ptr<char[]> name(new char[nameLen + 1]);
+        is.read((char*)&name[0], nameLen);
+        name[nameLen]    = 0;
+        animation.m_name = name.get();
+
+        is.read((char*)&animation.m_duration, sizeof(animation.m_duration));
+        is.read((char*)&animation.m_frameRate, sizeof(animation.m_frameRate));
+        is.read((char*)&animation.m_numFrames, sizeof(animation.m_numFrames));
+
+        unsigned numChannels = 0;
+        is.read((char*)&numChannels, sizeof(numChannels));
+        animation.m_channels.resize(numChannels);
+        is.read((char*)animation.m_channels.data(), numChannels * sizeof(animation.m_channels[0]));
+
+        unsigned dataSize = 0;
+        is.read((char*)&dataSize, sizeof(dataSize));
+        animation.m_data.resize(dataSize);
+        is.read((char*)animation.m_data.data(), dataSize * sizeof(animation.m_data[0]));
+        return is;
+    }
+} // namespace pge
@@ -0,0 +1,381 @@
+#include "../include/anim_pose.h"
+
+#include <math_interp.h>
+#include <core_assert.h>
+#include <gfx_debug_draw.h>
+#include <algorithm>
+
+// SSE is part of every x64 target; define PGE_ANIMATION_NO_SIMD to force the scalar kernels
+#if !defined(PGE_ANIMATION_NO_SIMD) && (defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#    define ANIM_SIMD_SSE
+#    include <xmmintrin.h>
+#endif
+
+namespace pge
+{
+    static_assert(sizeof(math_Vec3) == 3 * sizeof(float), "Translations and scales are blended as flat float arrays");
+    static_assert(sizeof(math_Quat) == 4 * sizeof(float), "Rotations are loaded as four floats");
+    static_assert(sizeof(math_Mat4x4) == 16 * sizeof(float), "Matrices are loaded as four rows of four floats");
+
+    // ----------------------------------------------
+    // Kernels
+    // ----------------------------------------------
+    // Each kernel processes four elements per iteration and finishes the remainder with the scalar version.
+    static void
+    BlendFloats(const float* from, const float* to, float factor, size_t count, float* out)
+    {
+        size_t i = 0;
+#ifdef ANIM_SIMD_SSE
+        const __m128 t = _mm_set1_ps(factor);
+        for (; i + 4 <= count; i += 4) {
+            const __m128 a = _mm_loadu_ps(from + i);
+            const __m128 b = _mm_loadu_ps(to + i);
+            _mm_storeu_ps(out + i, _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a))));
+        }
+#endif
+        for (; i < count; ++i) {
+            out[i] = from[i] + factor * (to[i] - from[i]);
+        }
+    }
+
+    static void
+    BlendRotations(const math_Quat* from, const math_Quat* to, float factor, size_t count, math_Quat* out)
+    {
+        size_t i = 0;
+#ifdef ANIM_SIMD_SSE
+        const __m128 t        = _mm_set1_ps(factor);
+        const __m128 one      = _mm_set1_ps(1.0f);
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        for (; i + 4 <= count; i += 4) {
+            // Transposed, so each register holds one component (w, x, y, z) of four quaternions
+            __m128 a0 = _mm_loadu_ps(&from[i + 0].w), a1 = _mm_loadu_ps(&from[i + 1].w);
+            __m128 a2 = _mm_loadu_ps(&from[i + 2].w), a3 = _mm_loadu_ps(&from[i + 3].w);
+            __m128 b0 = _mm_loadu_ps(&to[i + 0].w), b1 = _mm_loadu_ps(&to[i + 1].w);
+            __m128 b2 = _mm_loadu_ps(&to[i + 2].w), b3 = _mm_loadu_ps(&to[i + 3].w);
+            _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+            _MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+
+            // Negate the target where it lies in the other hemisphere
+            const __m128 dot  = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a0, b0), _mm_mul_ps(a1, b1)), _mm_add_ps(_mm_mul_ps(a2, b2), _mm_mul_ps(a3, b3)));
+            const __m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, _mm_setzero_ps()), signMask);
+            b0                = _mm_xor_ps(b0, flip);
+            b1                = _mm_xor_ps(b1, flip);
+            b2                = _mm_xor_ps(b2, flip);
+            b3                = _mm_xor_ps(b3, flip);
+
+            __m128 r0 = _mm_add_ps(a0, _mm_mul_ps(t, _mm_sub_ps(b0, a0)));
+            __m128 r1 = _mm_add_ps(a1, _mm_mul_ps(t, _mm_sub_ps(b1, a1)));
+            __m128 r2 = _mm_add_ps(a2, _mm_mul_ps(t, _mm_sub_ps(b2, a2)));
+            __m128 r3 = _mm_add_ps(a3, _mm_mul_ps(t, _mm_sub_ps(b3, a3)));
+
+            const __m128 lengthSq  = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r0, r0), _mm_mul_ps(r1, r1)), _mm_add_ps(_mm_mul_ps(r2, r2), _mm_mul_ps(r3, r3)));
+            const __m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+            r0                     = _mm_mul_ps(r0, invLength);
+            r1                     = _mm_mul_ps(r1, invLength);
+            r2                     = _mm_mul_ps(r2, invLength);
+            r3                     = _mm_mul_ps(r3, invLength);
+
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps(&out[i + 0].w, r0);
+            _mm_storeu_ps(&out[i + 1].w, r1);
+            _mm_storeu_ps(&out[i + 2].w, r2);
+            _mm_storeu_ps(&out[i + 3].w, r3);
+        }
+#endif
+        for (; i < count; ++i) {
+            const math_Quat target = math_Dot(from[i], to[i]) < 0 ? -to[i] : to[i];
+            out[i]                 = math_Normalize(math_Lerp(from[i], target, factor));
+        }
+    }
+
+    // Writes T * S * R for every bone, the same as math_CreateTransformMatrix
+    static void
+    ComposeTransforms(const math_Vec3* translations, const math_Quat* rotations, const math_Vec3* scales, size_t count, math_Mat4x4* out)
+    {
+        size_t i = 0;
+#ifdef ANIM_SIMD_SSE
+        const __m128 one  = _mm_set1_ps(1.0f);
+        const __m128 two  = _mm_set1_ps(2.0f);
+        const __m128 row3 = _mm_setr_ps(0, 0, 0, 1);
+        for (; i + 4 <= count; i += 4) {
+            __m128 w = _mm_loadu_ps(&rotations[i + 0].w), x = _mm_loadu_ps(&rotations[i + 1].w);
+            __m128 y = _mm_loadu_ps(&rotations[i + 2].w), z = _mm_loadu_ps(&rotations[i + 3].w);
+            _MM_TRANSPOSE4_PS(w, x, y, z);
+
+            const __m128 invLength
+                = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(w, w), _mm_mul_ps(x, x)), _mm_add_ps(_mm_mul_ps(y, y), _mm_mul_ps(z, z)))));
+            w = _mm_mul_ps(w, invLength);
+            x = _mm_mul_ps(x, invLength);
+            y = _mm_mul_ps(y, invLength);
+            z = _mm_mul_ps(z, invLength);
+
+            const __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+            const __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+            const __m128 xw = _mm_mul_ps(x, w), yw = _mm_mul_ps(y, w), zw = _mm_mul_ps(z, w);
+
+            const math_Vec3* s  = &scales[i];
+            const math_Vec3* tr = &translations[i];
+            const __m128     sx = _mm_setr_ps(s[0].x, s[1].x, s[2].x, s[3].x);
+            const __m128     sy = _mm_setr_ps(s[0].y, s[1].y, s[2].y, s[3].y);
+            const __m128     sz = _mm_setr_ps(s[0].z, s[1].z, s[2].z, s[3].z);
+
+            // Row r of the upper 3x3 is row r of the rotation scaled by scale[r], the last column is the translation
+            __m128 m00 = _mm_mul_ps(sx, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))));
+            __m128 m01 = _mm_mul_ps(sx, _mm_mul_ps(two, _mm_sub_ps(xy, zw)));
+            __m128 m02 = _mm_mul_ps(sx, _mm_mul_ps(two, _mm_add_ps(xz, yw)));
+            __m128 m03 = _mm_setr_ps(tr[0].x, tr[1].x, tr[2].x, tr[3].x);
+            __m128 m10 = _mm_mul_ps(sy, _mm_mul_ps(two, _mm_add_ps(xy, zw)));
+            __m128 m11 = _mm_mul_ps(sy, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))));
+            __m128 m12 = _mm_mul_ps(sy, _mm_mul_ps(two, _mm_sub_ps(yz, xw)));
+            __m128 m13 = _mm_setr_ps(tr[0].y, tr[1].y, tr[2].y, tr[3].y);
+            __m128 m20 = _mm_mul_ps(sz, _mm_mul_ps(two, _mm_sub_ps(xz, yw)));
+            __m128 m21 = _mm_mul_ps(sz, _mm_mul_ps(two, _mm_add_ps(yz, xw)));
+            __m128 m22 = _mm_mul_ps(sz, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))));
+            __m128 m23 = _mm_setr_ps(tr[0].z, tr[1].z, tr[2].z, tr[3].z);
+
+            // Transposing turns the per-element registers back into one row per bone
+            _MM_TRANSPOSE4_PS(m00, m01, m02, m03);
+            _MM_TRANSPOSE4_PS(m10, m11, m12, m13);
+            _MM_TRANSPOSE4_PS(m20, m21, m22, m23);
+            const __m128 rows[3][4] = {{m00, m01, m02, m03}, {m10, m11, m12, m13}, {m20, m21, m22, m23}};
+            for (size_t b = 0; b < 4; ++b) {
+                float* dst = out[i + b].values;
+                _mm_storeu_ps(dst + 0, rows[0][b]);
+                _mm_storeu_ps(dst + 4, rows[1][b]);
+                _mm_storeu_ps(dst + 8, rows[2][b]);
+                _mm_storeu_ps(dst + 12, row3);
+            }
+        }
+#endif
+        for (; i < count; ++i) {
+            out[i] = math_CreateTransformMatrix(translations[i], rotations[i], scales[i]);
+        }
+    }
+
+    // out = lhs * rhs, where out may be rhs
+    static void
+    MultiplyMatrices(const math_Mat4x4& lhs, const math_Mat4x4& rhs, math_Mat4x4* out)
+    {
+#ifdef ANIM_SIMD_SSE
+        // Each row of the result is a combination of the rows of rhs, weighted by a row of lhs
+        const __m128 r0 = _mm_loadu_ps(rhs.values + 0);
+        const __m128 r1 = _mm_loadu_ps(rhs.values + 4);
+        const __m128 r2 = _mm_loadu_ps(rhs.values + 8);
+        const __m128 r3 = _mm_loadu_ps(rhs.values + 12);
+        for (size_t row = 0; row < 4; ++row) {
+            const float* l = lhs.values + row * 4;
+            __m128       r = _mm_mul_ps(_mm_set1_ps(l[0]), r0);
+            r              = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(l[1]), r1));
+            r              = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(l[2]), r2));
+            r              = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(l[3]), r3));
+            _mm_storeu_ps(out->values + row * 4, r);
+        }
+#else
+        *out = lhs * rhs;
+#endif
+    }
+
+    // Turns local matrices into world matrices in place. Parents come before their children, so a parent's
+    // matrix is already in world space when its children are visited.
+    static void
+    ConcatenateHierarchy(const int* parents, size_t count, math_Mat4x4* matrices)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            const int parentIdx = parents[i];
+            if (parentIdx != -1)
+                MultiplyMatrices(matrices[parentIdx], matrices[i], &matrices[i]);
+        }
+    }
+
+
+    // ----------------------------------------------
+    // anim_Pose
+    // ----------------------------------------------
+    anim_Pose::anim_Pose(const anim_SkeletonDef* skeleton)
+        : m_skeleton(skeleton)
+        , m_translations(skeleton->GetBoneCount())
+        , m_rotations(skeleton->GetBoneCount())
+        , m_scales(skeleton->GetBoneCount())
+        , m_world(skeleton->GetBoneCount())
+    {
+        SetBindPose();
+        ComputeWorldTransforms();
+    }
+
+    void
+    anim_Pose::SetBindPose()
+    {
+        const size_t numBones = m_skeleton->GetBoneCount();
+        std::copy(m_skeleton->GetBindTranslations(), m_skeleton->GetBindTranslations() + numBones, m_translations.begin());
+        std::copy(m_skeleton->GetBindRotations(), m_skeleton->GetBindRotations() + numBones, m_rotations.begin());
+        std::copy(m_skeleton->GetBindScales(), m_skeleton->GetBindScales() + numBones, m_scales.begin());
+    }
+
+    size_t
+    anim_Pose::Animate(const anim_SkeletonAnimation& animation,
+                       const anim_AnimationBinding&  binding,
+                       double                        time,
+                       anim_ChannelCursor*           cursors,
+                       const uint8_t*                skippedBones)
+    {
+        if (animation.GetCompressed() != nullptr)
+            return Animate(*animation.GetCompressed(), binding, time, cursors, skippedBones);
+
+        core_Assert(binding.GetBoneCount() == GetBoneCount());
+        const anim_SkeletonAnimationChannel* channels   = animation.GetChannels();
+        size_t                               numSampled = 0;
+        for (size_t i = 0; i < GetBoneCount(); ++i) {
+            const int channelIdx = binding.GetChannelIndex(i);
+            if (channelIdx == -1 || (skippedBones != nullptr && skippedBones[i]))
+                continue;
+
+            const anim_SkeletonAnimationChannel& channel = channels[channelIdx];
+            anim_ChannelCursor*                  cursor  = cursors != nullptr ? &cursors[channelIdx] : nullptr;
+            m_translations[i]                            = channel.SamplePosition(time, cursor);
+            m_rotations[i]                               = channel.SampleRotation(time, cursor);
+            m_scales[i]                                  = channel.SampleScale(time, cursor);
+            ++numSampled;
+        }
+        return numSampled;
+    }
+
+    size_t
+    anim_Pose::Animate(const anim_CompressedAnimation& animation,
+                       const anim_AnimationBinding&    binding,
+                       double                          time,
+                       anim_ChannelCursor*             cursors,
+                       const uint8_t*                  skippedBones)
+    {
+        core_Assert(binding.GetBoneCount() == GetBoneCount());
+        size_t numSampled = 0;
+        for (size_t i = 0; i < GetBoneCount(); ++i) {
+            const int channelIdx = binding.GetChannelIndex(i);
+            if (channelIdx == -1 || (skippedBones != nullptr && skippedBones[i]))
+                continue;
+
+            anim_ChannelCursor* cursor = cursors != nullptr ? &cursors[channelIdx] : nullptr;
+            animation.Sample(channelIdx, time, &m_translations[i], &m_rotations[i], &m_scales[i], cursor);
+            ++numSampled;
+        }
+        return numSampled;
+    }
+
+    void
+    anim_Pose::ComputeWorldTransforms()
+    {
+        ComposeTransforms(m_translations.data(), m_rotations.data(), m_scales.data(), GetBoneCount(), m_world.data());
+        for (int i : m_skeleton->GetUnfactoredBones()) {
+            if (m_translations[i] == m_skeleton->GetBindTranslations()[i] && m_rotations[i] == m_skeleton->GetBindRotations()[i]
+                && m_scales[i] == m_skeleton->GetBindScales()[i])
+                m_world[i] = m_skeleton->GetBone(i).localTransform;
+        }
+        ConcatenateHierarchy(m_skeleton->GetParentIndices(), GetBoneCount(), m_world.data());
+    }
+
+    const anim_SkeletonDef*
+    anim_Pose::GetSkeleton() const
+    {
+        return m_skeleton;
+    }
+
+    size_t
+    anim_Pose::GetBoneCount() const
+    {
+        return m_world.size();
+    }
+
+    math_Vec3*
+    anim_Pose::GetTranslations()
+    {
+        return m_translations.data();
+    }
+
+    math_Quat*
+    anim_Pose::GetRotations()
+    {
+        return m_rotations.data();
+    }
+
+    math_Vec3*
+    anim_Pose::GetScales()
+    {
+        return m_scales.data();
+    }
+
+    const math_Vec3*
+    anim_Pose::GetTranslations() const
+    {
+        return m_translations.data();
+    }
+
+    const math_Quat*
+    anim_Pose::GetRotations() const
+    {
+        return m_rotations.data();
+    }
+
+    const math_Vec3*
+    anim_Pose::GetScales() const
+    {
+        return m_scales.data();
+    }
+
+    const math_Mat4x4&
+    anim_Pose::GetWorldTransform(size_t index) const
+    {
+        core_Assert(index < m_world.size());
+        return m_world[index];
+    }
+
+    const math_Mat4x4*
+    anim_Pose::GetWorldTransforms() const
+    {
+        return m_world.data();
+    }
+
+
+    void
+    anim_BlendPoses(const anim_Pose& from, const anim_Pose& to, float factor, anim_Pose* out)
+    {
+        core_Assert(from.GetSkeleton() == to.GetSkeleton() && from.GetSkeleton() == out->GetSkeleton());
+        const size_t numBones = from.GetBoneCount();
+        BlendFloats(&from.GetTranslations()->x, &to.GetTranslations()->x, factor, numBones * 3, &out->GetTranslations()->x);
+        BlendRotations(from.GetRotations(), to.GetRotations(), factor, numBones, out->GetRotations());
+        BlendFloats(&from.GetScales()->x, &to.GetScales()->x, factor, numBones * 3, &out->GetScales()->x);
+    }
+
+    void
+    anim_ComputeSkinningPalette(const anim_Pose& pose, const math_Mat4x4* boneOffsets, math_Mat4x4* palette)
+    {
+        for (size_t i = 0; i < pose.GetBoneCount(); ++i) {
+            MultiplyMatrices(pose.GetWorldTransform(i), boneOffsets[i], &palette[i]);
+        }
+    }
+
+    void
+    anim_ExpandBoundsToBones(const anim_Pose& pose, math_AABB* bounds)
+    {
+        for (size_t i = 0; i < pose.GetBoneCount(); ++i) {
+            const math_Mat4x4& world = pose.GetWorldTransform(i);
+            for (int j = 0; j < 3; ++j) {
+                bounds->min[j] = std::min(bounds->min[j], world[j][3]);
+                bounds->max[j] = std::max(bounds->max[j], world[j][3]);
+            }
+        }
+    }
+
+    void
+    anim_DebugDraw_Pose(const anim_Pose& pose, const math_Mat4x4& modelMatrix, const math_Vec3& color, float lineWidth, bool hasDepth)
+    {
+        for (unsigned i = 0; i < pose.GetBoneCount(); ++i) {
+            math_Vec3 p1 = (modelMatrix * pose.GetWorldTransform(i) * math_Vec4(0.f, 0.f, 0.f, 1.f)).xyz;
+            gfx_DebugDraw_Point(p1, color, lineWidth, hasDepth);
+
+            const int parentIdx = pose.GetSkeleton()->GetBone(i).parentIdx;
+            if (parentIdx != -1) {
+                math_Vec3 p2 = (modelMatrix * pose.GetWorldTransform(parentIdx) * math_Vec4(0.f, 0.f, 0.f, 1.f)).xyz;
+                gfx_DebugDraw_Line(p1, p2, color, lineWidth, hasDepth);
+            }
+        }
+    }
+} // namespace pge
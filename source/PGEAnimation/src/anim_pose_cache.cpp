@@ -0,0 +1,70 @@
+#include "../include/anim_pose_cache.h"
+
+#include <core_assert.h>
+#include <functional>
+
+namespace pge
+{
+    size_t
+    anim_PoseCache::KeyHash::operator()(const anim_PoseKey& key) const
+    {
+        size_t hash = std::hash<const void*>()(key.skeleton);
+        hash ^= std::hash<const void*>()(key.animation) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        hash ^= std::hash<uint32_t>()(key.frame * 2 + (key.skipLeafBones ? 1 : 0)) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        return hash;
+    }
+
+    anim_PoseCache::anim_PoseCache(float timeStep)
+        : m_timeStep(timeStep)
+        , m_numHits(0)
+        , m_numMisses(0)
+    {
+        core_Assert(timeStep > 0);
+    }
+
+    void
+    anim_PoseCache::Clear()
+    {
+        m_poses.clear();
+        m_numHits   = 0;
+        m_numMisses = 0;
+    }
+
+    float
+    anim_PoseCache::GetTimeStep() const
+    {
+        return m_timeStep;
+    }
+
+    const anim_Pose&
+    anim_PoseCache::GetPose(const anim_Animator& animator)
+    {
+        anim_PoseKey key;
+        if (!animator.GetPoseKey(m_timeStep, &key)) {
+            ++m_numMisses;
+            return animator.GetPose();
+        }
+
+        auto it = m_poses.find(key);
+        if (it != m_poses.end()) {
+            ++m_numHits;
+            return *it->second;
+        }
+        ++m_numMisses;
+        const anim_Pose& pose = animator.GetPose();
+        m_poses.emplace(key, &pose);
+        return pose;
+    }
+
+    size_t
+    anim_PoseCache::GetNumHits() const
+    {
+        return m_numHits;
+    }
+
+    size_t
+    anim_PoseCache::GetNumMisses() const
+    {
+        return m_numMisses;
+    }
+} // namespace pge
@@ -1,8 +1,9 @@
 #include "../include/anim_skeleton.h"
+#include "../include/anim_compression.h"
 
 #include <math_interp.h>
 #include <core_assert.h>
-#include <gfx_debug_draw.h>
+#include <algorithm>
 #include <memory>
 #include <iostream>
 
@@ -11,42 +12,112 @@ namespace pge
     // ============================
     // Static helper functions
     // ============================
-    template <typename TKey, typename TValue>
+    // Returns the last key at or before time, which must lie inside the key range. The keys at and right after the
+    // cursor are checked first, so advancing playback rarely needs the binary search.
+    static unsigned
+    FindKey(const float* times, unsigned keyCount, float time, unsigned cursor)
+    {
+        if (cursor + 1 < keyCount && times[cursor] <= time) {
+            if (time < times[cursor + 1])
+                return cursor;
+            if (cursor + 2 < keyCount && time < times[cursor + 2])
+                return cursor + 1;
+        }
+        return static_cast<unsigned>(std::upper_bound(times, times + keyCount, time) - times) - 1;
+    }
+
+    static math_Vec3
+    Interpolate(const math_Vec3& from, const math_Vec3& to, float factor)
+    {
+        return math_Lerp(from, to, factor);
+    }
+
+    // Normalized lerp along the shorter arc
+    static math_Quat
+    Interpolate(const math_Quat& from, const math_Quat& to, float factor)
+    {
+        const math_Quat target = math_Dot(from, to) < 0 ? -to : to;
+        return math_Normalize(math_Lerp(from, target, factor));
+    }
+
+    template <typename TValue>
     static TValue
-    Sample(const TKey* keys, unsigned keyCount, double time)
+    Sample(const float* times, const TValue* values, unsigned keyCount, double time, unsigned* cursor)
     {
         core_Assert(keyCount > 0);
-        if (keyCount == 1) {
-            return keys[0].value;
+        const float t = static_cast<float>(time);
+        if (t <= times[0]) {
+            return values[0];
+        } else if (t >= times[keyCount - 1]) {
+            return values[keyCount - 1];
         }
 
-        bool hasUpperBound = false;
-        TKey lowerBound, upperBound;
+        const unsigned key   = FindKey(times, keyCount, t, *cursor);
+        const float    ratio = (t - times[key]) / (times[key + 1] - times[key]);
+        *cursor              = key;
+        return Interpolate(values[key], values[key + 1], ratio);
+    }
+
+    template <typename TKey, typename TValue>
+    static void
+    SplitKeys(const TKey* keys, unsigned keyCount, float* times, TValue* values)
+    {
         for (unsigned i = 0; i < keyCount; ++i) {
-            const TKey& key = keys[i];
-            if (math_FloatEqual(key.time, time)) {
-                return key.value;
-            } else if (key.time < time) {
-                lowerBound = key;
-            } else if (key.time > time) {
-                upperBound    = key;
-                hasUpperBound = true;
-                break;
-            }
-        }
-        if (!hasUpperBound) {
-            return lowerBound.value;
+            core_AssertWithReason(i == 0 || keys[i - 1].time <= keys[i].time, "Keys must be sorted by time");
+            times[i]  = static_cast<float>(keys[i].time);
+            values[i] = keys[i].value;
         }
+    }
 
-        double lowerOffset = time - lowerBound.time;
-        double ratio       = lowerOffset / (upperBound.time - lowerBound.time);
-        return math_Lerp(lowerBound.value, upperBound.value, (float)ratio);
+    template <typename TKey, typename TValue>
+    static void
+    WriteKeys(std::ostream& os, const float* times, const TValue* values, unsigned keyCount)
+    {
+        // Keeps the interleaved layout of the file format
+        for (unsigned i = 0; i < keyCount; ++i) {
+            TKey key;
+            memset(&key, 0, sizeof(key));
+            key.value = values[i];
+            key.time  = times[i];
+            os.write((const char*)&key, sizeof(key));
+        }
     }
 
 
     // ============================
     // anim_SkeletonAnimationChannel
     // ============================
+    anim_ChannelCursor::anim_ChannelCursor()
+        : position(0)
+        , scale(0)
+        , rotation(0)
+    {}
+
+    size_t
+    anim_SkeletonAnimationChannel::AllocateKeys(unsigned numPosKeys, unsigned numScaleKeys, unsigned numRotKeys)
+    {
+        m_numPosKeys   = numPosKeys;
+        m_numScaleKeys = numScaleKeys;
+        m_numRotKeys   = numRotKeys;
+
+        const unsigned numKeys = numPosKeys + numScaleKeys + numRotKeys;
+        const size_t   size
+            = sizeof(float) * numKeys + sizeof(math_Vec3) * numPosKeys + sizeof(math_Vec3) * numScaleKeys + sizeof(math_Quat) * numRotKeys;
+        if (m_buffer != nullptr) {
+            free(m_buffer);
+        }
+        m_buffer = malloc(size);
+
+        // The times of all three tracks come first, followed by the values
+        m_positionTimes = reinterpret_cast<float*>(m_buffer);
+        m_scaleTimes    = m_positionTimes + numPosKeys;
+        m_rotationTimes = m_scaleTimes + numScaleKeys;
+        m_positions     = reinterpret_cast<math_Vec3*>(m_rotationTimes + numRotKeys);
+        m_scales        = m_positions + numPosKeys;
+        m_rotations     = reinterpret_cast<math_Quat*>(m_scales + numScaleKeys);
+        return size;
+    }
+
     void
     anim_SkeletonAnimationChannel::MakeSkeletonAnimationChannel(const char*         boneName,
                                                                 const anim_KeyVec3* posKeys,
@@ -57,23 +128,22 @@ namespace pge
                                                                 unsigned            numRotKeys)
     {
         core_Assert(strlen(boneName) <= sizeof(m_boneName));
-        m_numPosKeys   = numPosKeys;
-        m_numScaleKeys = numScaleKeys;
-        m_numRotKeys   = numRotKeys;
-
         strcpy_s(m_boneName, boneName);
 
-        if (m_buffer != nullptr) {
-            free(m_buffer);
-        }
-        m_buffer       = malloc(sizeof(anim_KeyVec3) * numPosKeys + sizeof(anim_KeyVec3) * numScaleKeys + sizeof(anim_KeyQuat) * numRotKeys);
-        m_positionKeys = reinterpret_cast<anim_KeyVec3*>(m_buffer);
-        m_scaleKeys    = reinterpret_cast<anim_KeyVec3*>(m_positionKeys + numPosKeys);
-        m_rotationKeys = reinterpret_cast<anim_KeyQuat*>(m_scaleKeys + numScaleKeys);
+        AllocateKeys(numPosKeys, numScaleKeys, numRotKeys);
+        SplitKeys(posKeys, numPosKeys, m_positionTimes, m_positions);
+        SplitKeys(scaleKeys, numScaleKeys, m_scaleTimes, m_scales);
+        SplitKeys(rotKeys, numRotKeys, m_rotationTimes, m_rotations);
+    }
 
-        memcpy(m_positionKeys, posKeys, sizeof(anim_KeyVec3) * numPosKeys);
-        memcpy(m_scaleKeys, scaleKeys, sizeof(anim_KeyVec3) * numScaleKeys);
-        memcpy(m_rotationKeys, rotKeys, sizeof(anim_KeyQuat) * numRotKeys);
+    void
+    anim_SkeletonAnimationChannel::CopySkeletonAnimationChannel(const anim_SkeletonAnimationChannel& rhs)
+    {
+        if (this == &rhs)
+            return;
+        strcpy_s(m_boneName, rhs.m_boneName);
+        const size_t size = AllocateKeys(rhs.m_numPosKeys, rhs.m_numScaleKeys, rhs.m_numRotKeys);
+        memcpy(m_buffer, rhs.m_buffer, size);
     }
 
 
@@ -82,14 +152,9 @@ namespace pge
     {}
 
     anim_SkeletonAnimationChannel::anim_SkeletonAnimationChannel(const anim_SkeletonAnimationChannel& rhs)
+        : m_buffer(nullptr)
     {
-        MakeSkeletonAnimationChannel(rhs.m_boneName,
-                                     rhs.m_positionKeys,
-                                     rhs.m_numPosKeys,
-                                     rhs.m_scaleKeys,
-                                     rhs.m_numScaleKeys,
-                                     rhs.m_rotationKeys,
-                                     rhs.m_numRotKeys);
+        CopySkeletonAnimationChannel(rhs);
     }
 
     anim_SkeletonAnimationChannel::anim_SkeletonAnimationChannel(anim_SkeletonAnimationChannel&& rhs)
@@ -101,21 +166,18 @@ namespace pge
     anim_SkeletonAnimationChannel&
     anim_SkeletonAnimationChannel::operator=(const anim_SkeletonAnimationChannel& rhs)
     {
-        MakeSkeletonAnimationChannel(rhs.m_boneName,
-                                     rhs.m_positionKeys,
-                                     rhs.m_numPosKeys,
-                                     rhs.m_scaleKeys,
-                                     rhs.m_numScaleKeys,
-                                     rhs.m_rotationKeys,
-                                     rhs.m_numRotKeys);
+        CopySkeletonAnimationChannel(rhs);
         return *this;
     }
 
     anim_SkeletonAnimationChannel&
     anim_SkeletonAnimationChannel::operator=(anim_SkeletonAnimationChannel&& rhs)
     {
-        memcpy(this, &rhs, sizeof(rhs));
-        memset(&rhs, 0, sizeof(rhs));
+        if (this != &rhs) {
+            free(m_buffer);
+            memcpy(this, &rhs, sizeof(rhs));
+            memset(&rhs, 0, sizeof(rhs));
+        }
         return *this;
     }
 
@@ -143,21 +205,24 @@ namespace pge
     }
 
     math_Vec3
-    anim_SkeletonAnimationChannel::SamplePosition(double time) const
+    anim_SkeletonAnimationChannel::SamplePosition(double time, anim_ChannelCursor* cursor) const
     {
-        return Sample<anim_KeyVec3, math_Vec3>(m_positionKeys, m_numPosKeys, time);
+        unsigned key = 0;
+        return Sample(m_positionTimes, m_positions, m_numPosKeys, time, cursor != nullptr ? &cursor->position : &key);
     }
 
     math_Vec3
-    anim_SkeletonAnimationChannel::SampleScale(double time) const
+    anim_SkeletonAnimationChannel::SampleScale(double time, anim_ChannelCursor* cursor) const
     {
-        return Sample<anim_KeyVec3, math_Vec3>(m_scaleKeys, m_numScaleKeys, time);
+        unsigned key = 0;
+        return Sample(m_scaleTimes, m_scales, m_numScaleKeys, time, cursor != nullptr ? &cursor->scale : &key);
     }
 
     math_Quat
-    anim_SkeletonAnimationChannel::SampleRotation(double time) const
+    anim_SkeletonAnimationChannel::SampleRotation(double time, anim_ChannelCursor* cursor) const
     {
-        return Sample<anim_KeyQuat, math_Quat>(m_rotationKeys, m_numRotKeys, time);
+        unsigned key = 0;
+        return Sample(m_rotationTimes, m_rotations, m_numRotKeys, time, cursor != nullptr ? &cursor->rotation : &key);
     }
 
 
@@ -182,6 +247,12 @@ namespace pge
         }
     }
 
+    anim_SkeletonAnimation::anim_SkeletonAnimation(std::shared_ptr<const anim_CompressedAnimation> compressed)
+        : m_duration(compressed->GetDuration())
+        , m_name(compressed->GetName())
+        , m_compressed(std::move(compressed))
+    {}
+
     double
     anim_SkeletonAnimation::GetDuration() const
     {
@@ -202,13 +273,20 @@ namespace pge
     const anim_SkeletonAnimationChannel*
     anim_SkeletonAnimation::GetChannels() const
     {
-        return &m_channels[0];
+        return m_channels.empty() ? nullptr : m_channels.data();
     }
 
     unsigned
     anim_SkeletonAnimation::GetChannelCount() const
     {
-        return m_channels.size();
+        return m_compressed ? m_compressed->GetChannelCount() : m_channels.size();
+    }
+
+    const char*
+    anim_SkeletonAnimation::GetBoneName(unsigned channel) const
+    {
+        core_Assert(channel < GetChannelCount());
+        return m_compressed ? m_compressed->GetBoneName(channel) : m_channels[channel].GetBoneName();
     }
 
     const char*
@@ -217,6 +295,12 @@ namespace pge
         return m_name.c_str();
     }
 
+    const anim_CompressedAnimation*
+    anim_SkeletonAnimation::GetCompressed() const
+    {
+        return m_compressed.get();
+    }
+
 
     std::ostream&
     operator<<(std::ostream& os, const anim_SkeletonAnimationChannel& channel)
@@ -227,13 +311,13 @@ namespace pge
         os.write((const char*)boneName, nameSz);
 
         os.write((const char*)&channel.m_numPosKeys, sizeof(channel.m_numPosKeys));
-        os.write((const char*)&channel.m_positionKeys[0], sizeof(channel.m_positionKeys[0]) * channel.m_numPosKeys);
+        WriteKeys<anim_KeyVec3>(os, channel.m_positionTimes, channel.m_positions, channel.m_numPosKeys);
 
         os.write((const char*)&channel.m_numScaleKeys, sizeof(channel.m_numScaleKeys));
-        os.write((const char*)&channel.m_scaleKeys[0], sizeof(channel.m_scaleKeys[0]) * channel.m_numScaleKeys);
+        WriteKeys<anim_KeyVec3>(os, channel.m_scaleTimes, channel.m_scales, channel.m_numScaleKeys);
 
         os.write((const char*)&channel.m_numRotKeys, sizeof(channel.m_numRotKeys));
-        os.write((const char*)&channel.m_rotationKeys[0], sizeof(channel.m_rotationKeys[0]) * channel.m_numRotKeys);
+        WriteKeys<anim_KeyQuat>(os, channel.m_rotationTimes, channel.m_rotations, channel.m_numRotKeys);
 
         return os;
     }
@@ -259,7 +343,7 @@ namespace pge
 
         decltype(channel.m_numRotKeys) numRotKeys = 0;
         is.read((char*)&numRotKeys, sizeof(numRotKeys));
-        std::unique_ptr<anim_KeyQuat[]> rotationKeys(new anim_KeyQuat[numScaleKeys]);
+        std::unique_ptr<anim_KeyQuat[]> rotationKeys(new anim_KeyQuat[numRotKeys]);
         is.read((char*)&rotationKeys[0], sizeof(rotationKeys[0]) * numRotKeys);
 
         channel
@@ -272,6 +356,10 @@ namespace pge
     std::ostream&
     operator<<(std::ostream& os, const anim_SkeletonAnimation& animation)
     {
+        // Compressed clips are written as the keyframe clip they decompress to
+        if (animation.m_compressed)
+            return os << animation.m_compressed->Decompress();
+
         unsigned nameLen = animation.m_name.size();
         os.write((const char*)&nameLen, sizeof(nameLen));
         os.write(animation.m_name.c_str(), nameLen);
@@ -301,168 +389,179 @@ namespace pge
         for (unsigned i = 0; i < animation.m_channels.size(); ++i) {
             is >> animation.m_channels[i];
         }
+        animation.m_compressed.reset();
         return is;
     }
 
 
     // ============================
-    // anim_Skeleton
+    // anim_SkeletonDef
     // ============================
-    anim_SkeletonBone*
-    anim_Skeleton::FindBone(const char* name)
-    {
-        auto it = std::find_if(m_bones.begin(), m_bones.end(), [&](const anim_SkeletonBone& bone) { return strcmp(bone.name, name) == 0; });
-        if (it == m_bones.end()) {
-            return nullptr;
-        } else {
-            return &*it;
+    // The rows of a rotation that were scaled by the given (non-negative) scale. An axis scaled to zero has no
+    // direction of its own, so it's completed from the other two; with more than one, the rotation is unknown.
+    static math_Mat4x4
+    UnscaleRotationRows(const math_Mat4x4& matrix, const math_Vec3& scale)
+    {
+        math_Mat4x4 rotMatrix;
+        int         numFlat  = 0;
+        size_t      flatAxis = 0;
+        for (size_t i = 0; i < 3; ++i) {
+            const math_Vec3 row(matrix[i][0], matrix[i][1], matrix[i][2]);
+            if (math_FloatEqual(scale[i], 0)) {
+                numFlat++;
+                flatAxis = i;
+            } else {
+                rotMatrix[i] = math_Vec4(row / scale[i], 0);
+            }
+        }
+        if (numFlat == 0)
+            return rotMatrix;
+        if (numFlat == 1) {
+            const math_Vec3 a(rotMatrix[(flatAxis + 1) % 3][0], rotMatrix[(flatAxis + 1) % 3][1], rotMatrix[(flatAxis + 1) % 3][2]);
+            const math_Vec3 b(rotMatrix[(flatAxis + 2) % 3][0], rotMatrix[(flatAxis + 2) % 3][1], rotMatrix[(flatAxis + 2) % 3][2]);
+            const math_Vec3 axis = math_Cross(a, b);
+            if (!math_FloatEqual(math_Length(axis), 0)) {
+                rotMatrix[flatAxis] = math_Vec4(math_Normalize(axis), 0);
+                return rotMatrix;
+            }
         }
+        return math_Mat4x4();
     }
 
-    anim_Skeleton::anim_Skeleton(anim_SkeletonBone* bones, unsigned numBones)
-    {
-        m_bones.reserve(numBones);
-        for (unsigned i = 0; i < numBones; ++i)
-            m_bones.emplace_back(bones[i]);
+    // Poses compose T * S * R, so the rows of the upper 3x3 are read as the rows of the rotation, scaled. A bind
+    // transform in another order still decomposes, but is only reproduced if its scale is uniform.
+    static void
+    DecomposeBoneTransform(const math_Mat4x4& transform, math_Vec3* translation, math_Quat* rotation, math_Vec3* scale)
+    {
+        *translation = math_Vec3(transform[0][3], transform[1][3], transform[2][3]);
+
+        for (size_t i = 0; i < 3; ++i)
+            (*scale)[i] = math_Length(math_Vec3(transform[i][0], transform[i][1], transform[i][2]));
+        math_Mat4x4     rotMatrix = UnscaleRotationRows(transform, *scale);
+        const math_Vec3 r0(rotMatrix[0][0], rotMatrix[0][1], rotMatrix[0][2]);
+        const math_Vec3 r1(rotMatrix[1][0], rotMatrix[1][1], rotMatrix[1][2]);
+        const math_Vec3 r2(rotMatrix[2][0], rotMatrix[2][1], rotMatrix[2][2]);
+        if (math_Dot(math_Cross(r0, r1), r2) < 0) {
+            rotMatrix *= -1.f;
+            *scale *= -1.f;
+        }
+        *rotation = math_QuatFromMatrix(rotMatrix);
+    }
+
+    anim_SkeletonDef::anim_SkeletonDef(const anim_SkeletonBone* bones, unsigned numBones)
+        : m_bones(bones, bones + numBones)
+        , m_bindTranslations(numBones)
+        , m_bindRotations(numBones)
+        , m_bindScales(numBones)
+        , m_parentIndices(numBones)
+        , m_leafBones(numBones, 1)
+    {
+        for (unsigned i = 0; i < numBones; ++i) {
+            core_AssertWithReason(bones[i].parentIdx < static_cast<int>(i), "Parent bones must come before their children");
+            m_parentIndices[i] = bones[i].parentIdx;
+            if (bones[i].parentIdx != -1)
+                m_leafBones[bones[i].parentIdx] = 0;
+            DecomposeBoneTransform(bones[i].localTransform, &m_bindTranslations[i], &m_bindRotations[i], &m_bindScales[i]);
+            if (math_CreateTransformMatrix(m_bindTranslations[i], m_bindRotations[i], m_bindScales[i]) != bones[i].localTransform)
+                m_unfactoredBones.push_back(static_cast<int>(i));
+        }
     }
 
-    anim_Skeleton::anim_Skeleton(const anim_Skeleton& rhs)
-        : m_bones(rhs.m_bones)
-    {}
-
-    anim_Skeleton::anim_Skeleton(const anim_Skeleton&& rhs)
-        : m_bones(std::move(rhs.m_bones))
-    {}
-
-    anim_Skeleton&
-    anim_Skeleton::operator=(const anim_Skeleton& rhs)
+    size_t
+    anim_SkeletonDef::GetBoneCount() const
     {
-        m_bones = rhs.m_bones;
-        return *this;
+        return m_bones.size();
     }
 
-    anim_Skeleton&
-    anim_Skeleton::operator=(anim_Skeleton&& rhs)
+    const anim_SkeletonBone&
+    anim_SkeletonDef::GetBone(size_t index) const
     {
-        m_bones = std::move(rhs.m_bones);
-        return *this;
+        core_Assert(index < m_bones.size());
+        return m_bones[index];
     }
 
-    void
-    anim_Skeleton::Transform()
+    int
+    anim_SkeletonDef::GetBoneIndex(const char* name) const
     {
-        for (auto& bone : m_bones) {
-            if (bone.parentIdx != -1) {
-                bone.worldTransform = GetBone(bone.parentIdx).worldTransform * bone.localTransform;
-            } else {
-                bone.worldTransform = bone.localTransform;
-            }
+        for (size_t i = 0; i < m_bones.size(); ++i) {
+            if (strcmp(m_bones[i].name, name) == 0)
+                return static_cast<int>(i);
         }
+        core_AssertWithReason(false, "Bone does not exist!");
+        return -1;
     }
 
-    static void
-    AnimateBone(anim_SkeletonBone* bone, const anim_SkeletonAnimationChannel& channel, double time)
+    const math_Vec3*
+    anim_SkeletonDef::GetBindTranslations() const
     {
-        math_Vec3 position   = channel.SamplePosition(time);
-        math_Vec3 scale      = channel.SampleScale(time);
-        math_Quat rotation   = channel.SampleRotation(time);
-        bone->localTransform = math_CreateTransformMatrix(position, rotation, scale);
+        return m_bindTranslations.data();
     }
 
-    static void
-    AnimateBone(anim_SkeletonBone*                   bone,
-                const anim_SkeletonAnimationChannel& channelFrom,
-                double                               timeFrom,
-                const anim_SkeletonAnimationChannel& channelTo,
-                double                               timeTo,
-                float                                factor)
+    const math_Quat*
+    anim_SkeletonDef::GetBindRotations() const
     {
-        math_Vec3 posFrom   = channelFrom.SamplePosition(timeFrom);
-        math_Vec3 scaleFrom = channelFrom.SampleScale(timeFrom);
-        math_Quat rotFrom   = channelFrom.SampleRotation(timeFrom);
-
-        math_Vec3 posTo   = channelTo.SamplePosition(timeTo);
-        math_Vec3 scaleTo = channelTo.SampleScale(timeTo);
-        math_Quat rotTo   = channelTo.SampleRotation(timeTo);
-
-        math_Vec3 position = math_Lerp(posFrom, posTo, factor);
-        math_Vec3 scale    = math_Lerp(scaleFrom, scaleTo, factor);
-        math_Quat rotation = math_Lerp(rotFrom, rotTo, factor);
-
-        bone->localTransform = math_CreateTransformMatrix(position, rotation, scale);
+        return m_bindRotations.data();
     }
 
-    void
-    anim_Skeleton::Animate(const anim_SkeletonAnimation& animation, double time)
+    const math_Vec3*
+    anim_SkeletonDef::GetBindScales() const
     {
-        unsigned                             channelCount = animation.GetChannelCount();
-        const anim_SkeletonAnimationChannel* channels     = animation.GetChannels();
-        for (unsigned i = 0; i < channelCount; ++i) {
-            const anim_SkeletonAnimationChannel& channel = channels[i];
-
-            anim_SkeletonBone* bone = FindBone(channel.GetBoneName());
-            core_Assert(bone != nullptr);
-            AnimateBone(bone, channel, time);
-        }
+        return m_bindScales.data();
     }
 
-    void
-    anim_Skeleton::Animate(const anim_SkeletonAnimation& from, double fromTime, const anim_SkeletonAnimation& to, double toTime, float factor)
-    {
-        for (auto& bone : m_bones) {
-            const anim_SkeletonAnimationChannel* fromChannel = from.GetChannel(bone.name);
-            const anim_SkeletonAnimationChannel* toChannel   = to.GetChannel(bone.name);
-
-            if (fromChannel == nullptr && toChannel == nullptr) {
-                continue;
-            } else if (fromChannel != nullptr && toChannel == nullptr) {
-                AnimateBone(&bone, *fromChannel, fromTime, *fromChannel, 0, factor);
-            } else if (fromChannel == nullptr && toChannel != nullptr) {
-                AnimateBone(&bone, *toChannel, 0, *toChannel, toTime, factor);
-            } else if (fromChannel != nullptr && toChannel != nullptr) {
-                AnimateBone(&bone, *fromChannel, fromTime, *toChannel, toTime, factor);
-            }
-        }
+    const int*
+    anim_SkeletonDef::GetParentIndices() const
+    {
+        return m_parentIndices.data();
     }
 
-    size_t
-    anim_Skeleton::GetBoneCount() const
+    const uint8_t*
+    anim_SkeletonDef::GetLeafBoneMask() const
     {
-        return m_bones.size();
+        return m_leafBones.data();
     }
 
-    const anim_SkeletonBone&
-    anim_Skeleton::GetBone(size_t index) const
+    const std::vector<int>&
+    anim_SkeletonDef::GetUnfactoredBones() const
     {
-        core_Assert(index < m_bones.size());
-        return m_bones[index];
+        return m_unfactoredBones;
     }
 
-    int
-    anim_Skeleton::GetBoneIndex(const char* name) const
+
+    // ============================
+    // anim_AnimationBinding
+    // ============================
+    anim_AnimationBinding::anim_AnimationBinding(const anim_SkeletonDef& skeleton, const anim_SkeletonAnimation& animation)
+        : m_boneChannels(skeleton.GetBoneCount(), -1)
     {
-        for (size_t i = 0; i < m_bones.size(); ++i) {
-            if (strcmp(m_bones[i].name, name) == 0)
-                return static_cast<int>(i);
+        for (unsigned i = 0; i < animation.GetChannelCount(); ++i) {
+            const int boneIdx = skeleton.GetBoneIndex(animation.GetBoneName(i));
+            if (boneIdx != -1) {
+                m_boneChannels[boneIdx] = static_cast<int>(i);
+            }
         }
-        core_AssertWithReason(false, "Bone does not exist!");
-        return -1;
     }
 
-    void
-    anim_DebugDraw_Skeleton(const anim_Skeleton& skeleton, const math_Mat4x4& modelMatrix, const math_Vec3& color, float lineWidth, bool hasDepth)
+    anim_AnimationBinding::anim_AnimationBinding(const anim_SkeletonDef& skeleton, const anim_CompressedAnimation& animation)
+        : m_boneChannels(skeleton.GetBoneCount(), -1)
     {
-        for (unsigned i = 0; i < skeleton.GetBoneCount(); ++i) {
-            const anim_SkeletonBone& bone = skeleton.GetBone(i);
-
-            math_Vec3 p1 = (modelMatrix * bone.worldTransform * math_Vec4(0.f, 0.f, 0.f, 1.f)).xyz;
-            gfx_DebugDraw_Point(p1, color, lineWidth, hasDepth);
-
-            if (bone.parentIdx != -1) {
-                math_Mat4x4 parentTransform = skeleton.GetBone(bone.parentIdx).worldTransform;
-                math_Vec3   p2              = (modelMatrix * parentTransform * math_Vec4(0.f, 0.f, 0.f, 1.f)).xyz;
-                gfx_DebugDraw_Line(p1, p2, color, lineWidth, hasDepth);
+        for (unsigned i = 0; i < animation.GetChannelCount(); ++i) {
+            const int boneIdx = skeleton.GetBoneIndex(animation.GetBoneName(i));
+            if (boneIdx != -1) {
+                m_boneChannels[boneIdx] = static_cast<int>(i);
             }
         }
     }
+
+    size_t
+    anim_AnimationBinding::GetBoneCount() const
+    {
+        return m_boneChannels.size();
+    }
+
+    int
+    anim_AnimationBinding::GetChannelIndex(size_t boneIndex) const
+    {
+        return m_boneChannels[boneIndex];
+    }
 } // namespace pge
\ No newline at end of file
@@ -0,0 +1,113 @@
+#ifndef PGE_CORE_CORE_JOB_SYSTEM_H
+#define PGE_CORE_CORE_JOB_SYSTEM_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace pge
+{
+    // Counts the unfinished jobs of a batch; waiting on it acts as a fence for everything that depends on the batch.
+    struct core_JobCounter {
+        std::atomic<int> value;
+
+        core_JobCounter();
+    };
+
+    using core_JobFunction = void (*)(void* data);
+    struct core_Job {
+        core_JobFunction function;
+        void*            data;
+        core_JobCounter* counter;
+    };
+
+    // ----------------------------------------------
+    // core_WorkStealingQueue
+    // ----------------------------------------------
+    // Fixed-size Chase-Lev deque. Only the owning thread may Push and Pop (LIFO), any thread may Steal (FIFO).
+    class core_WorkStealingQueue {
+        std::atomic<int64_t>                 m_top;
+        std::atomic<int64_t>                 m_bottom;
+        std::vector<std::atomic<core_Job*>> m_buffer;
+        int64_t                              m_mask;
+
+    public:
+        explicit core_WorkStealingQueue(size_t capacity); // Must be a power of two
+
+        bool      Push(core_Job* job); // Fails if the queue is full
+        core_Job* Pop();
+        core_Job* Steal();
+        size_t    Size() const;
+    };
+
+    // ----------------------------------------------
+    // core_JobSystem
+    // ----------------------------------------------
+    // Runs jobs on a pool of workers that each own a queue and steal from the others when theirs runs dry.
+    // The thread that creates the system is worker 0; it (and jobs themselves) can submit work and help out while waiting.
+    class core_JobSystem {
+        struct Worker;
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        struct Scheduler;
+        std::unique_ptr<Scheduler> m_scheduler;
+
+        core_JobSystem(const core_JobSystem& other) = delete;
+        core_JobSystem& operator=(const core_JobSystem& rhs) = delete;
+
+        void      WorkerMain(size_t workerIndex);
+        core_Job* FindJob(size_t workerIndex);
+        void      Execute(core_Job* job);
+        size_t    GetCurrentWorker() const;
+
+    public:
+        explicit core_JobSystem(size_t numWorkers = 0); // 0 uses one worker per hardware thread
+        ~core_JobSystem();
+
+        size_t GetNumWorkers() const;
+
+        // The jobs must stay alive until their counter has reached zero.
+        void Run(core_Job* jobs, size_t numJobs, core_JobCounter* counter);
+        void Wait(core_JobCounter* counter);
+    };
+
+    // Calls function(rangeBegin, rangeEnd) on subranges of [begin, end) of at most grainSize indices, and returns
+    // when all of them are done. A grainSize of 0 splits the range into a few ranges per worker.
+    template <typename Function>
+    void
+    core_ParallelFor(core_JobSystem* jobSystem, size_t begin, size_t end, size_t grainSize, const Function& function)
+    {
+        if (begin >= end)
+            return;
+        const size_t count = end - begin;
+        if (grainSize == 0) {
+            const size_t numRanges = jobSystem->GetNumWorkers() * 4;
+            grainSize              = (count + numRanges - 1) / numRanges;
+        }
+
+        struct Range {
+            const Function* function;
+            size_t          begin;
+            size_t          end;
+        };
+        const size_t          numRanges = (count + grainSize - 1) / grainSize;
+        std::vector<Range>    ranges(numRanges);
+        std::vector<core_Job> jobs(numRanges);
+        for (size_t i = 0; i < numRanges; ++i) {
+            ranges[i].function = &function;
+            ranges[i].begin    = begin + i * grainSize;
+            ranges[i].end      = ranges[i].begin + grainSize < end ? ranges[i].begin + grainSize : end;
+            jobs[i].function   = [](void* data) {
+                const Range* range = static_cast<const Range*>(data);
+                (*range->function)(range->begin, range->end);
+            };
+            jobs[i].data = &ranges[i];
+        }
+
+        core_JobCounter counter;
+        jobSystem->Run(jobs.data(), jobs.size(), &counter);
+        jobSystem->Wait(&counter);
+    }
+} // namespace pge
+
+#endif
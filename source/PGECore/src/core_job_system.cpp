@@ -0,0 +1,255 @@
+#include "../include/core_job_system.h"
+#include "../include/core_assert.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace pge
+{
+    core_JobCounter::core_JobCounter()
+        : value(0)
+    {}
+
+    // ----------------------------------------------
+    // core_WorkStealingQueue
+    // ----------------------------------------------
+    // Follows "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al.), without growing the buffer.
+    core_WorkStealingQueue::core_WorkStealingQueue(size_t capacity)
+        : m_top(0)
+        , m_bottom(0)
+        , m_buffer(capacity)
+        , m_mask(static_cast<int64_t>(capacity) - 1)
+    {
+        core_Assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+    }
+
+    bool
+    core_WorkStealingQueue::Push(core_Job* job)
+    {
+        const int64_t b = m_bottom.load(std::memory_order_relaxed);
+        const int64_t t = m_top.load(std::memory_order_acquire);
+        if (b - t > m_mask)
+            return false;
+        m_buffer[b & m_mask].store(job, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    core_Job*
+    core_WorkStealingQueue::Pop()
+    {
+        const int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+        if (t > b) {
+            // Empty
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        core_Job* job = m_buffer[b & m_mask].load(std::memory_order_relaxed);
+        if (t == b) {
+            // Last job, race the thieves for it
+            if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                job = nullptr;
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    core_Job*
+    core_WorkStealingQueue::Steal()
+    {
+        int64_t t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t b = m_bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+
+        core_Job* job = m_buffer[t & m_mask].load(std::memory_order_relaxed);
+        if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr; // Lost to the owner or another thief
+        return job;
+    }
+
+    size_t
+    core_WorkStealingQueue::Size() const
+    {
+        const int64_t b = m_bottom.load(std::memory_order_relaxed);
+        const int64_t t = m_top.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+    // ----------------------------------------------
+    // core_JobSystem
+    // ----------------------------------------------
+    static const size_t JOB_QUEUE_CAPACITY = 4096;
+
+    struct core_JobSystem::Worker {
+        core_WorkStealingQueue queue;
+        std::thread            thread;
+        uint32_t               random; // Picks the victims to steal from
+
+        Worker(uint32_t seed)
+            : queue(JOB_QUEUE_CAPACITY)
+            , random(seed)
+        {}
+    };
+
+    // Idle workers sleep until jobs are queued
+    struct core_JobSystem::Scheduler {
+        std::mutex              mutex;
+        std::condition_variable wake;
+        std::atomic<int>        numQueued;
+        bool                    quit;
+
+        Scheduler()
+            : numQueued(0)
+            , quit(false)
+        {}
+    };
+
+    struct WorkerBinding {
+        const core_JobSystem* system;
+        size_t                index;
+    };
+    static thread_local WorkerBinding s_currentWorker = {nullptr, 0};
+
+    core_JobSystem::core_JobSystem(size_t numWorkers)
+        : m_scheduler(new Scheduler)
+    {
+        if (numWorkers == 0) {
+            numWorkers = std::thread::hardware_concurrency();
+        }
+        numWorkers = numWorkers == 0 ? 1 : numWorkers;
+        for (size_t i = 0; i < numWorkers; ++i) {
+            m_workers.emplace_back(new Worker(static_cast<uint32_t>(i * 2654435761u + 1)));
+        }
+
+        core_AssertWithReason(s_currentWorker.system == nullptr, "A thread can only be worker 0 of one job system at a time");
+        s_currentWorker = {this, 0};
+        for (size_t i = 1; i < numWorkers; ++i) {
+            m_workers[i]->thread = std::thread(&core_JobSystem::WorkerMain, this, i);
+        }
+    }
+
+    core_JobSystem::~core_JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_scheduler->mutex);
+            m_scheduler->quit = true;
+        }
+        m_scheduler->wake.notify_all();
+        for (size_t i = 1; i < m_workers.size(); ++i) {
+            m_workers[i]->thread.join();
+        }
+        s_currentWorker = {nullptr, 0};
+    }
+
+    size_t
+    core_JobSystem::GetNumWorkers() const
+    {
+        return m_workers.size();
+    }
+
+    size_t
+    core_JobSystem::GetCurrentWorker() const
+    {
+        core_AssertWithReason(s_currentWorker.system == this, "Jobs can only be submitted from the job system's own threads");
+        return s_currentWorker.index;
+    }
+
+    void
+    core_JobSystem::Run(core_Job* jobs, size_t numJobs, core_JobCounter* counter)
+    {
+        core_Assert(counter != nullptr);
+        Worker& worker = *m_workers[GetCurrentWorker()];
+        counter->value.fetch_add(static_cast<int>(numJobs), std::memory_order_relaxed);
+
+        size_t numQueued = 0;
+        for (size_t i = 0; i < numJobs; ++i) {
+            jobs[i].counter = counter;
+            if (worker.queue.Push(&jobs[i])) {
+                ++numQueued;
+            } else {
+                Execute(&jobs[i]); // Queue is full, run it right away instead
+            }
+        }
+
+        if (numQueued > 0) {
+            m_scheduler->numQueued.fetch_add(static_cast<int>(numQueued), std::memory_order_release);
+            { std::lock_guard<std::mutex> lock(m_scheduler->mutex); }
+            if (numQueued == 1) {
+                m_scheduler->wake.notify_one();
+            } else {
+                m_scheduler->wake.notify_all();
+            }
+        }
+    }
+
+    void
+    core_JobSystem::Wait(core_JobCounter* counter)
+    {
+        const size_t workerIndex = GetCurrentWorker();
+        while (counter->value.load(std::memory_order_acquire) > 0) {
+            core_Job* job = FindJob(workerIndex);
+            if (job != nullptr) {
+                Execute(job);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    core_Job*
+    core_JobSystem::FindJob(size_t workerIndex)
+    {
+        Worker&   worker = *m_workers[workerIndex];
+        core_Job* job    = worker.queue.Pop();
+        if (job == nullptr && m_workers.size() > 1) {
+            // Start at a random victim, then try all others once
+            worker.random ^= worker.random << 13;
+            worker.random ^= worker.random >> 17;
+            worker.random ^= worker.random << 5;
+            const size_t first = worker.random % m_workers.size();
+            for (size_t i = 0; i < m_workers.size() && job == nullptr; ++i) {
+                const size_t victim = (first + i) % m_workers.size();
+                if (victim != workerIndex) {
+                    job = m_workers[victim]->queue.Steal();
+                }
+            }
+        }
+        if (job != nullptr) {
+            m_scheduler->numQueued.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    void
+    core_JobSystem::Execute(core_Job* job)
+    {
+        core_JobCounter* counter = job->counter;
+        job->function(job->data);
+        counter->value.fetch_sub(1, std::memory_order_release);
+    }
+
+    void
+    core_JobSystem::WorkerMain(size_t workerIndex)
+    {
+        s_currentWorker = {this, workerIndex};
+        for (;;) {
+            core_Job* job = FindJob(workerIndex);
+            if (job != nullptr) {
+                Execute(job);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_scheduler->mutex);
+            m_scheduler->wake.wait(lock, [this] { return m_scheduler->quit || m_scheduler->numQueued.load(std::memory_order_acquire) > 0; });
+            if (m_scheduler->quit)
+                return;
+        }
+    }
+} // namespace pge
@@ -1,8 +1,10 @@
 #include "../include/core_log.h"
 #include <chrono>
-#include <sstream>
-#include <iomanip>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <memory>
 
 #ifdef _WIN32
 #    include <Windows.h>
@@ -20,14 +22,22 @@ namespace pge
         tm time{};
         localtime_s(&time, &t);
 
-        // Format the string to match the form [dd/mm|hh:mm:ss - tag] %message%
-        std::stringstream ss;
-        ss << "[" << std::setfill('0') << std::setw(2) << time.tm_mday << "/" << std::setw(2) << (time.tm_mon + 1) << "|" << std::setw(2)
-           << time.tm_hour << ":" << std::setw(2) << time.tm_min << ":" << std::setw(2) << time.tm_sec << " - " << tag << "] " << message << "\n";
-        auto formatted_message = ss.str();
-        std::cout << formatted_message << std::flush;
+        // Format the string to match the form [dd/mm|hh:mm:ss - tag] %message%, on the stack unless it's long
+        const char* lineFormat = "[%02d/%02d|%02d:%02d:%02d - %s] %s\n";
+        char        stackBuffer[512];
+        const int   length = snprintf(stackBuffer, sizeof(stackBuffer), lineFormat, time.tm_mday, time.tm_mon + 1, time.tm_hour, time.tm_min, time.tm_sec, tag, message);
+
+        std::unique_ptr<char[]> heapBuffer;
+        const char*             formatted_message = stackBuffer;
+        if (length >= static_cast<int>(sizeof(stackBuffer))) {
+            heapBuffer = std::unique_ptr<char[]>(new char[length + 1]);
+            snprintf(&heapBuffer[0], length + 1, lineFormat, time.tm_mday, time.tm_mon + 1, time.tm_hour, time.tm_min, time.tm_sec, tag, message);
+            formatted_message = heapBuffer.get();
+        }
+        std::cout.write(formatted_message, length);
+        std::cout.flush();
 #ifdef _WIN32
-        OutputDebugString(formatted_message.c_str());
+        OutputDebugString(formatted_message);
 #endif
 #undef ERROR
         core_LogRecord::RecordType recordType;
@@ -38,16 +48,24 @@ namespace pge
         else if (strcmp(tag, "ERROR") == 0)
             recordType = core_LogRecord::RecordType::ERROR;
 
-        s_records.push_back(core_LogRecord(recordType, formatted_message));
+        s_records.push_back(core_LogRecord(recordType, std::string(formatted_message, length)));
     }
 
     static void
     LogMessageFormatted(const char* tag, const char* format, va_list list)
     {
-        char         dummy;
-        const size_t bufferSize = vsnprintf(&dummy, 1, format, list) + 1;
-        auto         buffer     = std::unique_ptr<char[]>(new char[bufferSize]);
-        vsnprintf(&buffer[0], bufferSize, format, list);
+        // Most messages fit on the stack, only go to the heap for long ones
+        char    stackBuffer[512];
+        va_list copy;
+        va_copy(copy, list);
+        const int length = vsnprintf(stackBuffer, sizeof(stackBuffer), format, copy);
+        va_end(copy);
+        if (length < static_cast<int>(sizeof(stackBuffer))) {
+            LogMessage(tag, stackBuffer);
+            return;
+        }
+        auto buffer = std::unique_ptr<char[]>(new char[length + 1]);
+        vsnprintf(&buffer[0], length + 1, format, list);
         LogMessage(tag, buffer.get());
     }
 
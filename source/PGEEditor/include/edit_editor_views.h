@@ -87,6 +87,7 @@ namespace pge
             inline const math_Mat4x4& GetProjection() const { return m_cameraManager.GetProjectionMatrix(CAM_ENTITY); }
             inline void UpdateFPS() { m_cameraManager.UpdateFPS(CAM_ENTITY); }
             inline const float GetAspect() { return m_cameraManager.GetPerspective(CAM_ENTITY).aspect; }
+            inline math_Vec3 GetPosition() const { return m_transformManager.GetWorldPosition(m_transformManager.GetTransformId(CAM_ENTITY)); }
             // clang-format on
         } m_editCamera;
 
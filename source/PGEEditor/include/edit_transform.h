@@ -61,19 +61,20 @@ namespace pge
         Create(const game_Entity& entity, const math_Quat& initialRot, const math_Quat& newRot, game_TransformManager* tm);
     };
 
+    // Holds on to entities, since transform ids change when reparenting.
     class edit_CommandSetParent : public edit_Command {
-        game_TransformId       m_transform;
-        game_TransformId       m_originalParent;
-        game_TransformId       m_newParent;
+        game_Entity            m_entity;
+        game_Entity            m_originalParent;
+        game_Entity            m_newParent;
         game_TransformManager* m_tmanager;
 
     public:
-        edit_CommandSetParent(const game_TransformId& transform, const game_TransformId& parent, game_TransformManager* tm);
+        edit_CommandSetParent(const game_Entity& entity, const game_Entity& parent, game_TransformManager* tm);
         virtual void Do() override;
         virtual void Undo() override;
 
         static std::unique_ptr<edit_Command>
-        Create(const game_TransformId& transform, const game_TransformId& parent, game_TransformManager* tm);
+        Create(const game_Entity& entity, const game_Entity& parent, game_TransformManager* tm);
     };
 
 
@@ -29,12 +29,13 @@ namespace pge
     {
         gfx_RenderTarget_ClearMainRTV(m_graphicsAdapter);
         m_world->GarbageCollect();
+        m_world->BeginFrame();
 
         edit_BeginFrame();
         gfx_DebugDraw_Clear();
 
         HandleShortcuts();
-        m_world->GetAnimationManager()->Update(1.0f / 60.0f);
+        m_world->GetAnimationManager()->Update(1.0f / 60.0f, *m_world->GetMeshManager(), *m_world->GetTransformManager());
 
         edit_DrawMainMenuBar(m_world.get(), &m_commandStack);
 
@@ -288,6 +288,7 @@ namespace pge
         m_editCamera.UpdateFPS();
         const math_Mat4x4 view = m_editCamera.GetView();
         const math_Mat4x4 proj = m_editCamera.GetProjection();
+        m_world->GetAnimationManager()->SetViewpoint(m_editCamera.GetPosition());
 
         // TODO: Actual Play/Edit mode toggle functionality
         //    probably through edit_Editor
@@ -388,7 +389,7 @@ namespace pge
             // No cycles allowed.
             return;
         }
-        cstack->Do(edit_CommandSetParent::Create(srcTransform, destTransform, world->GetTransformManager()));
+        cstack->Do(edit_CommandSetParent::Create(droppedEntity, targetEntity, world->GetTransformManager()));
     }
 
     static void
@@ -412,11 +413,11 @@ namespace pge
                                              std::vector<game_Entity>* entitiesRemove,
                                              bool                      isLeaf)
     {
-        std::string        name  = world->GetEntityManager()->GetName(entity);
+        const char*        name  = world->GetEntityManager()->GetName(entity, world->GetFrameArena());
         ImGuiTreeNodeFlags flags = 0;
         flags |= isLeaf ? (ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen) : 0;
         flags |= (entity == *selectedEntity) ? ImGuiTreeNodeFlags_Selected : 0;
-        bool isOpen = ImGui::TreeNodeEx(reinterpret_cast<void*>(entity.id), flags, "%s", name.c_str());
+        bool isOpen = ImGui::TreeNodeEx(reinterpret_cast<void*>(entity.id), flags, "%s", name);
 
         if (ImGui::BeginDragDropSource()) {
             ImGui::SetDragDropPayload("_TREENODE", (void*)&entity, sizeof(entity));
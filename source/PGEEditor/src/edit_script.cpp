@@ -73,6 +73,8 @@ namespace pge
             std::ofstream file(scriptPaths[nextIdx]);
             std::string   text = textEditor.GetText();
             file.write(text.c_str(), text.size());
+            file.close();
+            m_scriptManager->ReloadScript(scriptPaths[nextIdx]);
         }
 
         ImGui::SameLine();
@@ -108,29 +108,37 @@ namespace pge
     // ---------------------------------
     // edit_CommandSetParent
     // ---------------------------------
-    edit_CommandSetParent::edit_CommandSetParent(const game_TransformId& transform, const game_TransformId& newParent, game_TransformManager* tm)
-        : m_transform(transform)
+    edit_CommandSetParent::edit_CommandSetParent(const game_Entity& entity, const game_Entity& newParent, game_TransformManager* tm)
+        : m_entity(entity)
         , m_newParent(newParent)
         , m_tmanager(tm)
     {}
 
+    static game_TransformId
+    FindParentTransform(game_TransformManager* tm, const game_Entity& parent)
+    {
+        return parent == game_EntityId_Invalid ? game_TransformId_Invalid : tm->GetTransformId(parent);
+    }
+
     void
     edit_CommandSetParent::Do()
     {
-        m_originalParent = m_tmanager->GetParent(m_transform);
-        m_tmanager->SetParent(m_transform, m_newParent);
+        game_TransformId tid      = m_tmanager->GetTransformId(m_entity);
+        game_TransformId parentId = m_tmanager->GetParent(tid);
+        m_originalParent          = parentId == game_TransformId_Invalid ? game_Entity() : m_tmanager->GetEntity(parentId);
+        m_tmanager->SetParent(tid, FindParentTransform(m_tmanager, m_newParent));
     }
 
     void
     edit_CommandSetParent::Undo()
     {
-        m_tmanager->SetParent(m_transform, m_originalParent);
+        m_tmanager->SetParent(m_tmanager->GetTransformId(m_entity), FindParentTransform(m_tmanager, m_originalParent));
     }
 
     std::unique_ptr<edit_Command>
-    edit_CommandSetParent::Create(const game_TransformId& transform, const game_TransformId& parent, game_TransformManager* tm)
+    edit_CommandSetParent::Create(const game_Entity& entity, const game_Entity& parent, game_TransformManager* tm)
     {
-        return std::unique_ptr<edit_Command>(new edit_CommandSetParent(transform, parent, tm));
+        return std::unique_ptr<edit_Command>(new edit_CommandSetParent(entity, parent, tm));
     }
 
 
@@ -2,17 +2,63 @@
 #define PGE_GAME_GAME_ANIMATION_H
 
 #include "game_entity.h"
+#include "game_component_pool.h"
 #include <res_animator.h>
-#include <vector>
-#include <unordered_map>
+#include <anim_pose_cache.h>
+#include <anim_baked_animation.h>
+#include <map>
+#include <memory>
+#include <tuple>
 
 namespace pge
 {
+    class game_MeshManager;
+    class game_TransformManager;
+    class res_Mesh;
+
+    // Animators further from the viewpoint than the previous tier's distance use this tier
+    struct game_AnimationLodTier {
+        float            maxDistance;
+        unsigned         updateInterval; // Advance every n-th update, by the time of all updates since the last
+        anim_AnimatorLod lod;
+    };
+
+    struct game_AnimationStats {
+        size_t numAnimators;
+        size_t numUpdatedAnimators;
+        size_t numEvaluatedBones;
+        size_t numSharedPoses;    // Updated animators that reused the pose of another
+        size_t numBakedAnimators; // Updated animators that looked up a baked palette
+        size_t bakedBytes;        // Of all clips baked so far
+    };
+
     class game_AnimationManager {
-        std::vector<game_Entity>                m_entities;
-        std::vector<anim_Animator>              m_animators;
-        std::unordered_map<game_Entity, size_t> m_entityMap;
-        std::vector<size_t>                     m_freeList;
+        struct AnimatorComponent {
+            anim_Animator            animator;
+            std::vector<math_Mat4x4> palette;      // Skinning matrices of the last update, read by every render pass
+            math_AABB                bounds;       // Of the mesh skinned by the palette, in model space
+            game_Entity              paletteOwner; // Whose palette and bounds it shows, itself unless it shares a pose
+            float                    pendingTime;  // Accumulated while throttled
+            const res_Mesh*          bakedMesh;    // The mesh its clips were baked for, null if it isn't baked
+        };
+        using PaletteKey = std::pair<const anim_Pose*, const res_Mesh*>;
+        using BakeKey    = std::tuple<const res_Mesh*, const anim_SkeletonDef*, const anim_SkeletonAnimation*>;
+        using BakedClip  = std::unique_ptr<anim_BakedAnimation>;
+
+        game_ComponentPool<AnimatorComponent> m_animators;
+        std::vector<game_AnimationLodTier>    m_lodTiers;
+        math_Vec3                             m_viewpoint;
+        unsigned                              m_updateIndex;
+        game_AnimationStats                   m_stats;
+        bool                                  m_sharePoses;
+        anim_PoseCache                        m_poseCache;
+        std::map<PaletteKey, unsigned>        m_sharedPalettes; // The animator that computed each palette this update
+        std::map<BakeKey, BakedClip>          m_bakedAnimations; // Per mesh, kept as long as the manager
+        size_t                                m_bakedBytes;
+
+        const game_AnimationLodTier& SelectLodTier(const game_TransformManager& transformManager, const game_Entity& entity) const;
+        void                         BakeAnimations(const anim_AnimatorConfig& config, const res_Mesh* mesh);
+        const AnimatorComponent*     FindPaletteOwner(const AnimatorComponent& component) const;
 
     public:
         game_AnimationManager(size_t capacity);
@@ -25,10 +71,35 @@ namespace pge
         bool HasAnimator(const game_Entity& entity) const;
         void SetAnimator(const game_Entity& entity, const res_AnimatorConfig* config);
 
-        anim_Skeleton GetAnimatedSkeleton(const game_Entity& entity) const;
-        void          Update(float dt);
-        void          Trigger(const char* trigger);
-        void          Trigger(const game_Entity& entity, const char* trigger);
+        const anim_Pose& GetAnimatedPose(const game_Entity& entity) const;
+        // Empty until the first update after the animator was created, or when the entity has no skinned mesh.
+        // Animators that share a pose return the palette of the one that computed it.
+        const std::vector<math_Mat4x4>& GetSkinningPalette(const game_Entity& entity) const;
+        // The mesh's bind pose bounds grown to hold the bones posed by the palette, valid while it isn't empty.
+        const math_AABB& GetSkinnedBounds(const game_Entity& entity) const;
+
+        // Tiers are sorted by distance; animators beyond the last tier's distance use the last tier.
+        void SetLodTiers(const game_AnimationLodTier* tiers, size_t numTiers);
+        void SetViewpoint(const math_Vec3& position);
+        // Off by default. Animators playing the same clip within the same time step then share one pose, and one
+        // palette per mesh, which suits crowds. The model matrix is applied by the renderer, so it can differ.
+        void SetPoseSharing(bool enabled, float timeStep = 1.0f / 60);
+        // Off by default. Bakes every clip of the entity's animator into palettes for the mesh, here and whenever the
+        // animator is replaced, so updates only look them up. Baked palettes are used while the entity shows that
+        // mesh. Transitions switch clips halfway instead of blending. A null mesh turns baking off.
+        void SetBaked(const game_Entity& entity, const res_Mesh* mesh);
+
+        // Advances the animators that are due for their LOD tier, then evaluates their pose and skinning palette
+        // once for all passes of the frame.
+        void Update(float dt, const game_MeshManager& meshManager, const game_TransformManager& transformManager);
+        // Trigger ids are anim_HashTrigger of the trigger's name; the name overloads hash it once per call.
+        void Trigger(anim_TriggerId trigger);
+        void Trigger(const game_Entity& entity, anim_TriggerId trigger);
+        void Trigger(const game_Entity* entities, size_t numEntities, anim_TriggerId trigger);
+        void Trigger(const char* trigger);
+        void Trigger(const game_Entity& entity, const char* trigger);
+
+        const game_AnimationStats& GetStats() const; // Of the last update
     };
 } // namespace pge
 
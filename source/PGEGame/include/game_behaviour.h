@@ -21,6 +21,7 @@ namespace pge
         game_BehaviourManager();
         void CreateBehaviour(const game_Entity& entity, std::unique_ptr<game_Behaviour> behaviour);
         void DestroyBehaviour(const game_Entity& entity);
+        bool HasBehaviour(const game_Entity& entity) const;
         void GarbageCollect(const game_EntityManager& entityManager);
 
         void Update(float delta);
@@ -2,10 +2,10 @@
 #define PGE_GAME_GAME_CAMERA_H
 
 #include "game_entity.h"
+#include "game_component_pool.h"
 #include "game_transform.h"
 #include <math_mat4x4.h>
 #include <math_vec2.h>
-#include <unordered_map>
 
 namespace pge
 {
@@ -21,9 +21,9 @@ namespace pge
             math_Mat4x4          projectionMatrix;
             game_PerspectiveInfo perspective;
         };
-        std::unordered_map<game_Entity, Camera> m_cameras;
-        game_TransformManager*                  m_tmanager;
-        game_Entity                             m_activeCamera;
+        game_ComponentPool<Camera> m_cameras;
+        game_TransformManager*     m_tmanager;
+        game_Entity                m_activeCamera;
 
     public:
         game_CameraManager(game_TransformManager* tmanager);
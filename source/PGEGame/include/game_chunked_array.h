@@ -0,0 +1,200 @@
+#ifndef PGE_GAME_GAME_CHUNKED_ARRAY_H
+#define PGE_GAME_GAME_CHUNKED_ARRAY_H
+
+#include <core_assert.h>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace pge
+{
+    // Array that grows by allocating fixed-size chunks of ChunkSize elements. Growing never moves or copies
+    // existing elements, so their addresses stay valid until they are removed.
+    template <typename T, size_t ChunkSize = 256>
+    class game_ChunkedArray {
+        static_assert(ChunkSize > 0 && (ChunkSize & (ChunkSize - 1)) == 0, "ChunkSize must be a power of two");
+
+        struct Chunk {
+            alignas(T) unsigned char data[sizeof(T) * ChunkSize];
+        };
+        std::vector<std::unique_ptr<Chunk>> m_chunks;
+        size_t                              m_size;
+
+        T*
+        Slot(size_t index) const
+        {
+            return reinterpret_cast<T*>(m_chunks[index / ChunkSize]->data) + index % ChunkSize;
+        }
+
+    public:
+        template <typename Array, typename Value>
+        class Iterator {
+            Array* m_array;
+            size_t m_index;
+
+        public:
+            Iterator(Array* array, size_t index)
+                : m_array(array)
+                , m_index(index)
+            {}
+
+            Value&
+            operator*() const
+            {
+                return (*m_array)[m_index];
+            }
+
+            Value*
+            operator->() const
+            {
+                return &(*m_array)[m_index];
+            }
+
+            Iterator&
+            operator++()
+            {
+                ++m_index;
+                return *this;
+            }
+
+            bool
+            operator==(const Iterator& rhs) const
+            {
+                return m_index == rhs.m_index;
+            }
+
+            bool
+            operator!=(const Iterator& rhs) const
+            {
+                return m_index != rhs.m_index;
+            }
+        };
+        using iterator       = Iterator<game_ChunkedArray, T>;
+        using const_iterator = Iterator<const game_ChunkedArray, const T>;
+
+        game_ChunkedArray()
+            : m_size(0)
+        {}
+
+        ~game_ChunkedArray()
+        {
+            Clear();
+        }
+
+        game_ChunkedArray(const game_ChunkedArray& other) = delete;
+        game_ChunkedArray& operator=(const game_ChunkedArray& rhs) = delete;
+
+        void
+        Reserve(size_t capacity)
+        {
+            while (Capacity() < capacity) {
+                m_chunks.emplace_back(new Chunk);
+            }
+        }
+
+        void
+        Resize(size_t size)
+        {
+            Reserve(size);
+            while (m_size < size)
+                PushBack(T());
+            while (m_size > size)
+                PopBack();
+        }
+
+        void
+        Clear()
+        {
+            while (m_size > 0)
+                PopBack();
+        }
+
+        T&
+        PushBack(const T& value)
+        {
+            Reserve(m_size + 1);
+            return *new (Slot(m_size++)) T(value);
+        }
+
+        T&
+        PushBack(T&& value)
+        {
+            Reserve(m_size + 1);
+            return *new (Slot(m_size++)) T(std::move(value));
+        }
+
+        void
+        PopBack()
+        {
+            core_Assert(m_size > 0);
+            Slot(--m_size)->~T();
+        }
+
+        size_t
+        Size() const
+        {
+            return m_size;
+        }
+
+        size_t
+        Capacity() const
+        {
+            return m_chunks.size() * ChunkSize;
+        }
+
+        T&
+        Back()
+        {
+            core_Assert(m_size > 0);
+            return *Slot(m_size - 1);
+        }
+
+        T&
+        operator[](size_t index)
+        {
+            core_Assert(index < m_size);
+            return *Slot(index);
+        }
+
+        const T&
+        operator[](size_t index) const
+        {
+            core_Assert(index < m_size);
+            return *Slot(index);
+        }
+
+        // Elements [index, index + n) are contiguous as long as they don't cross a multiple of ChunkSize.
+        static constexpr size_t
+        GetChunkSize()
+        {
+            return ChunkSize;
+        }
+
+        iterator
+        begin()
+        {
+            return iterator(this, 0);
+        }
+
+        iterator
+        end()
+        {
+            return iterator(this, m_size);
+        }
+
+        const_iterator
+        begin() const
+        {
+            return const_iterator(this, 0);
+        }
+
+        const_iterator
+        end() const
+        {
+            return const_iterator(this, m_size);
+        }
+    };
+} // namespace pge
+
+#endif
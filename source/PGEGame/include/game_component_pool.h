@@ -0,0 +1,173 @@
+#ifndef PGE_GAME_GAME_COMPONENT_POOL_H
+#define PGE_GAME_GAME_COMPONENT_POOL_H
+
+#include "game_entity.h"
+#include "game_chunked_array.h"
+#include <core_assert.h>
+#include <vector>
+
+namespace pge
+{
+    // Maps entities onto densely packed ids. The sparse array is indexed by the entity index, and
+    // the dense entity it points to is compared as a whole to reject stale generations.
+    class game_EntitySparseSet {
+        std::vector<unsigned>    m_sparse;
+        std::vector<game_Entity> m_dense;
+
+    public:
+        static constexpr unsigned InvalidId = -1;
+
+        void Reserve(size_t capacity);
+        void Clear();
+
+        // The entity's index must not have a slot, not even for an older generation of the entity
+        unsigned Insert(const game_Entity& entity);
+        void     Remove(unsigned id);
+        void     Swap(unsigned a, unsigned b);
+
+        bool               Has(const game_Entity& entity) const;
+        unsigned           Find(const game_Entity& entity) const;
+        unsigned           FindAnyGeneration(const game_Entity& entity) const; // Also finds older generations
+        unsigned           GetId(const game_Entity& entity) const;
+        const game_Entity& GetEntity(unsigned id) const;
+        const game_Entity* GetEntities() const;
+        size_t             Size() const;
+    };
+
+    // Components of type T stored densely (in chunks), indexed by their entity through a sparse set.
+    // Removal swaps the last component into the freed slot, so ids are only stable until the next removal.
+    // Growing never moves components, so their addresses are stable until removal as well.
+    template <typename T>
+    class game_ComponentPool {
+        game_EntitySparseSet m_entities;
+        game_ChunkedArray<T> m_components;
+
+    public:
+        static constexpr unsigned InvalidId = game_EntitySparseSet::InvalidId;
+
+        explicit game_ComponentPool(size_t capacity = 0)
+        {
+            Reserve(capacity);
+        }
+
+        void
+        Reserve(size_t capacity)
+        {
+            m_entities.Reserve(capacity);
+            m_components.Reserve(capacity);
+        }
+
+        void
+        Clear()
+        {
+            m_entities.Clear();
+            m_components.Clear();
+        }
+
+        // An older generation of the entity that wasn't garbage collected yet loses its component
+        unsigned
+        Insert(const game_Entity& entity, const T& component = T())
+        {
+            unsigned staleId = m_entities.FindAnyGeneration(entity);
+            if (staleId != InvalidId) {
+                Remove(staleId);
+            }
+            unsigned id = m_entities.Insert(entity);
+            m_components.PushBack(component);
+            return id;
+        }
+
+        void
+        Remove(unsigned id)
+        {
+            core_Assert(id < m_components.Size());
+            if (id != m_components.Size() - 1) {
+                m_components[id] = std::move(m_components.Back());
+            }
+            m_components.PopBack();
+            m_entities.Remove(id);
+        }
+
+        bool
+        Has(const game_Entity& entity) const
+        {
+            return m_entities.Has(entity);
+        }
+
+        unsigned
+        Find(const game_Entity& entity) const
+        {
+            return m_entities.Find(entity);
+        }
+
+        unsigned
+        FindAnyGeneration(const game_Entity& entity) const
+        {
+            return m_entities.FindAnyGeneration(entity);
+        }
+
+        unsigned
+        GetId(const game_Entity& entity) const
+        {
+            return m_entities.GetId(entity);
+        }
+
+        const game_Entity&
+        GetEntity(unsigned id) const
+        {
+            return m_entities.GetEntity(id);
+        }
+
+        const game_Entity*
+        GetEntities() const
+        {
+            return m_entities.GetEntities();
+        }
+
+        size_t
+        Size() const
+        {
+            return m_components.Size();
+        }
+
+        T&
+        operator[](unsigned id)
+        {
+            core_Assert(id < m_components.Size());
+            return m_components[id];
+        }
+
+        const T&
+        operator[](unsigned id) const
+        {
+            core_Assert(id < m_components.Size());
+            return m_components[id];
+        }
+
+        typename game_ChunkedArray<T>::iterator
+        begin()
+        {
+            return m_components.begin();
+        }
+
+        typename game_ChunkedArray<T>::iterator
+        end()
+        {
+            return m_components.end();
+        }
+
+        typename game_ChunkedArray<T>::const_iterator
+        begin() const
+        {
+            return m_components.begin();
+        }
+
+        typename game_ChunkedArray<T>::const_iterator
+        end() const
+        {
+            return m_components.end();
+        }
+    };
+} // namespace pge
+
+#endif
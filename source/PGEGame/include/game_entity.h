@@ -49,10 +49,15 @@ namespace std
 
 namespace pge
 {
+    class mem_FrameArena;
+
     class game_EntityManager {
         std::vector<unsigned>                        m_generation;
         std::vector<unsigned>                        m_freeIndices;
+        std::vector<unsigned>                        m_freeSlots; // Position of each free index in m_freeIndices
+        std::vector<unsigned long long>              m_aliveMask; // One bit per index, set while it is in use
         std::unordered_map<game_Entity, std::string> m_names;
+        std::vector<game_Entity>                     m_destroyed;
 
     public:
         class game_EntityIterator : public std::iterator<std::forward_iterator_tag, game_Entity> {
@@ -80,8 +85,14 @@ namespace pge
         void        DestroyEntity(const game_Entity& entity);
         bool        IsEntityAlive(const game_Entity& entity) const;
 
+        // Entities destroyed since the last clear; the world drains these to clean up their components
+        const std::vector<game_Entity>& GetDestroyedEntities() const;
+        void                            ClearDestroyedEntities();
+
         std::string GetName(const game_Entity& entity) const;
         void        SetName(const game_Entity& entity, const char* name);
+        // Avoids the string copy; generated names live in the arena, so the result is only valid for this frame.
+        const char* GetName(const game_Entity& entity, mem_FrameArena* arena) const;
 
         game_EntityIterator begin() const;
         game_EntityIterator end() const;
@@ -91,6 +102,13 @@ namespace pge
 
         friend std::ostream& operator<<(std::ostream& os, const game_EntityManager& em);
         friend std::istream& operator>>(std::istream& is, game_EntityManager& em);
+
+    private:
+        unsigned AddIndex();
+        void     AllocateIndex(unsigned idx);
+        void     FreeIndex(unsigned idx);
+        bool     IsIndexAlive(unsigned idx) const;
+        unsigned NextAliveIndex(unsigned idx) const;
     };
 
 
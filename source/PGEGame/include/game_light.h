@@ -2,11 +2,10 @@
 #define PGE_GAME_GAME_LIGHT_H
 
 #include "game_entity.h"
+#include "game_component_pool.h"
 #include "game_transform.h"
 #include <math_vec2.h>
 #include <math_vec3.h>
-#include <unordered_map>
-#include <memory>
 
 namespace pge
 {
@@ -33,13 +32,8 @@ namespace pge
     class game_LightManager {
         game_TransformManager* m_transformManager;
 
-        std::unordered_map<game_Entity, game_DirectionalLightId> m_dirLightMap;
-        std::unique_ptr<game_DirectionalLight[]>                 m_dirLights;
-        size_t                                                   m_numDirLights;
-
-        std::unordered_map<game_Entity, game_PointLightId> m_pointLightMap;
-        std::unique_ptr<game_PointLight[]>                 m_pointLights;
-        size_t                                             m_numPointLights;
+        game_ComponentPool<game_DirectionalLight> m_dirLights;
+        game_ComponentPool<game_PointLight>       m_pointLights;
 
     public:
         explicit game_LightManager(game_TransformManager* tmanager, size_t capacity);
@@ -50,7 +44,7 @@ namespace pge
         bool                         HasDirectionalLight(const game_Entity& entity) const;
         game_DirectionalLightId      GetDirectionalLightId(const game_Entity& entity) const;
         game_DirectionalLight        GetDirectionalLight(const game_DirectionalLightId& id) const;
-        const game_DirectionalLight* GetDirectionalLights(size_t* count) const;
+        size_t                       GetNumDirectionalLights() const;
         void                         SetDirectionalLight(const game_DirectionalLightId& id, const game_DirectionalLight& light);
 
         void                   CreatePointLight(const game_Entity& entity, const game_PointLight& light);
@@ -58,7 +52,7 @@ namespace pge
         bool                   HasPointLight(const game_Entity& entity) const;
         game_PointLightId      GetPointLightId(const game_Entity& entity) const;
         game_PointLight        GetPointLight(const game_PointLightId& id) const;
-        const game_PointLight* GetPointLights(size_t* count) const;
+        size_t                 GetNumPointLights() const;
         void                   SetPointLight(const game_PointLightId& id, const game_PointLight& light);
 
         bool HasLight(const game_Entity& entity) const;
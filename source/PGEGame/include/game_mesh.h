@@ -2,31 +2,54 @@
 #define PGE_GAME_GAME_STATIC_MESH_H
 
 #include "game_entity.h"
+#include "game_component_pool.h"
 #include "game_transform.h"
 #include "game_renderer.h"
 #include "game_animation.h"
+#include "game_spatial_index.h"
 
 #include <math_raycasting.h>
+#include <math_frustum.h>
 #include <gfx_graphics_device.h>
 #include <gfx_buffer.h>
 #include <res_mesh.h>
 #include <res_material.h>
 #include <res_resource_manager.h>
-#include <unordered_map>
 
 namespace pge
 {
     using game_MeshId                         = unsigned;
     static const unsigned game_MeshId_Invalid = -1;
+
+    struct game_CullingStats {
+        size_t numVisible;
+        size_t numCulled;
+    };
+
     class game_MeshManager {
-        struct MeshEntity {
-            game_Entity         entity;
+        struct MeshComponent {
             const res_Mesh*     mesh;
             const res_Material* material;
         };
-        std::vector<MeshEntity>                      m_meshes;
-        std::unordered_map<game_Entity, game_MeshId> m_entityMap;
-        res_ResourceManager*                         m_resources;
+        game_ComponentPool<MeshComponent> m_meshes;
+        res_ResourceManager*              m_resources;
+
+        // Scratch space for culling, reused by every pass
+        mutable std::vector<game_MeshId> m_drawCandidates;
+        mutable std::vector<math_Mat4x4> m_drawModelMatrices;
+        mutable std::vector<math_AABB>   m_drawBounds;
+        mutable std::vector<uint8_t>     m_drawVisible;
+        mutable game_CullingStats        m_cullingStats[3]; // Per game_RenderPass
+        mutable game_RenderQueue         m_renderQueue;
+        mutable game_RenderQueueStats    m_renderQueueStats[3]; // Per game_RenderPass
+
+        game_SpatialIndex        m_spatialIndex; // World bounds of the meshes, as of the last UpdateSpatialIndex
+        std::vector<game_Entity> m_staleBounds;  // Mesh changed since the last UpdateSpatialIndex
+        std::vector<game_Entity> m_movedEntities;
+
+        // Scratch space for picking
+        mutable std::vector<game_Entity>                   m_pickEntities;
+        mutable std::vector<std::pair<float, game_Entity>> m_pickCandidates; // By distance to their bounds
 
     public:
         game_MeshManager(size_t capacity, res_ResourceManager* resources);
@@ -47,12 +70,24 @@ namespace pge
         const res_Mesh*     GetMesh(const game_MeshId& id) const;
         const res_Material* GetMaterial(const game_MeshId& id) const;
 
-        void        DrawMeshes(game_Renderer*               renderer,
-                               const game_TransformManager& tm,
-                               const game_AnimationManager& am,
-                               const game_EntityManager&    em,
-                               const game_RenderPass&       pass) const;
-        game_Entity RaycastSelect(const game_TransformManager& tm, const math_Ray& ray, const math_Mat4x4& viewProj, float* distanceOut) const;
+        // Only submits the meshes whose world bounds intersect the frustum of the renderer's current camera, which
+        // is the light's for the shadow map. They are drawn sorted by effect, material, mesh and depth. The bounds of
+        // meshes that aren't skinned come from the spatial index, so UpdateSpatialIndex has to run first.
+        void                         DrawMeshes(game_Renderer*               renderer,
+                                                const game_TransformManager& tm,
+                                                const game_AnimationManager& am,
+                                                const game_EntityManager&    em,
+                                                const game_RenderPass&       pass) const;
+        const game_CullingStats&     GetCullingStats(const game_RenderPass& pass) const;     // Of the last draw of the pass
+        const game_RenderQueueStats& GetRenderQueueStats(const game_RenderPass& pass) const; // Of the last draw of the pass
+
+        // Re-indexes the world bounds of meshes that moved or changed, call after updating the world transforms.
+        void                     UpdateSpatialIndex(game_TransformManager& tm);
+        const game_SpatialIndex& GetSpatialIndex() const;
+        // The mesh whose triangles the ray hits first. Candidates come from the spatial index, so meshes moved since
+        // the last UpdateSpatialIndex are tested where they were. Skinned meshes are hit by their bounds, as their
+        // triangles only match the bind pose.
+        game_Entity RaycastSelect(const game_TransformManager& tm, const math_Ray& ray, float* distanceOut) const;
 
         void SerializeEntity(std::ostream& os, const game_Entity& entity) const;
         void InsertSerializedEntity(std::istream& is, const game_Entity& entity);
@@ -0,0 +1,106 @@
+#ifndef PGE_GAME_GAME_RENDER_QUEUE_H
+#define PGE_GAME_GAME_RENDER_QUEUE_H
+
+#include <math_mat4x4.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace pge
+{
+    enum class game_RenderPass
+    {
+        DEPTH,
+        SHADOW,
+        LIGHTING
+    };
+
+    class res_Effect;
+    class res_Material;
+    class res_Mesh;
+
+    struct game_RenderCommand {
+        game_RenderPass     pass;
+        const res_Effect*   effect;   // The one the pass binds for this draw
+        const res_Material* material; // Null when the pass doesn't use it
+        const res_Mesh*     mesh;
+        math_Mat4x4         modelMatrix;
+        const math_Mat4x4*  palette; // Skinned meshes only, must stay valid until the queue is drawn
+        size_t              numBones;
+        bool                instanced; // May share an instanced draw with the commands binding the same state
+    };
+
+    // What a command binds that the command before it in sorted order didn't
+    enum game_RenderStateChange : uint8_t
+    {
+        game_RenderStateChange_Effect   = 1 << 0,
+        game_RenderStateChange_Material = 1 << 1,
+        game_RenderStateChange_Mesh     = 1 << 2,
+        game_RenderStateChange_Skinning = 1 << 3, // Switched between skinned and static meshes
+    };
+
+    struct game_RenderQueueStats {
+        size_t numCommands;
+        size_t numEffectChanges;
+        size_t numMaterialChanges;
+        size_t numMeshChanges;
+        size_t numBatches; // Draw calls, after merging instanced commands
+    };
+
+    // A range of sorted commands drawn with one draw call
+    struct game_RenderBatch {
+        size_t first;
+        size_t count;
+    };
+
+    // Collects the draws of a frame and orders them by a 64-bit key, so draws sharing an effect, material and mesh
+    // follow each other and only the state that differs from the previous draw needs to be bound. Keys hold, from
+    // the highest bits down: the pass, skinned or not, the effect, material and mesh (as small ids the queue assigns
+    // the first time it sees them), and the depth, so draws sharing all state go front to back.
+    class game_RenderQueue {
+        struct SortItem {
+            uint64_t key;
+            uint32_t command;
+        };
+
+        std::vector<game_RenderCommand> m_commands;
+        std::vector<SortItem>           m_sorted;
+        std::vector<SortItem>           m_sortScratch;
+        std::vector<uint8_t>            m_stateChanges; // In sorted order
+        std::vector<game_RenderBatch>   m_batches;
+        game_RenderQueueStats           m_stats;
+
+        // Kept across frames, so the keys of a resource stay the same, until Clear finds all ids of a kind in use
+        using ResourceIds = std::unordered_map<const void*, uint32_t>;
+        ResourceIds m_effectIds;
+        ResourceIds m_materialIds;
+        ResourceIds m_meshIds;
+
+        static uint32_t GetResourceId(ResourceIds* ids, const void* resource, unsigned numBits);
+        static void     RecycleResourceIds(ResourceIds* ids, unsigned numBits);
+        void            RadixSort();
+
+    public:
+        static constexpr size_t MAX_BATCH_SIZE = 512;
+
+        game_RenderQueue();
+
+        void Clear();
+        // The depth is in [0, 1], as in clip space, and is clamped to it.
+        void Submit(const game_RenderCommand& command, float depth);
+        // Sorts the commands, finds the state changes between them, and merges runs of instanced commands that change
+        // no state into batches.
+        void Sort();
+
+        // In sorted order, after Sort
+        size_t                       Size() const;
+        const game_RenderCommand&    GetCommand(size_t index) const;
+        uint64_t                     GetKey(size_t index) const;
+        uint8_t                      GetStateChanges(size_t index) const;
+        const game_RenderQueueStats& GetStats() const;
+        size_t                       GetNumBatches() const;
+        const game_RenderBatch&      GetBatch(size_t index) const;
+    };
+} // namespace pge
+
+#endif
@@ -5,21 +5,17 @@
 #include <gfx_graphics_device.h>
 #include <gfx_buffer.h>
 #include <gfx_render_target.h>
-#include <anim_skeleton.h>
 #include <res_resource_manager.h>
 
 #include "game_light.h"
 #include "game_camera.h"
+#include "game_render_queue.h"
+
+#include <unordered_map>
+#include <vector>
 
 namespace pge
 {
-    enum class game_RenderPass
-    {
-        DEPTH,
-        SHADOW,
-        LIGHTING
-    };
-
     class game_TransformManager;
     class game_EntityManager;
     class game_MeshManager;
@@ -67,6 +63,14 @@ namespace pge
         } m_cbLightTransformsData;
         gfx_ConstantBuffer m_cbLightTransforms;
 
+        static const unsigned MAX_INSTANCES = game_RenderQueue::MAX_BATCH_SIZE;
+        struct InstanceTransform {
+            math_Mat4x4 modelMatrix;
+            math_Mat4x4 normalMatrix;
+        };
+        std::vector<InstanceTransform> m_instanceTransformsData;
+        gfx_StructuredBuffer           m_instanceTransforms;
+
 
         gfx_RenderTarget m_shadowMap;
         gfx_RenderTarget m_viewShadows;
@@ -76,10 +80,14 @@ namespace pge
         const res_Effect* m_multisampleFX;
         const res_Mesh    m_screenMesh;
 
+        // The variants of effects that take their transforms from m_instanceTransforms, by the effect they replace
+        std::unordered_map<const res_Effect*, const res_Effect*> m_instancedFX;
+
     public:
         game_Renderer(gfx_GraphicsAdapter* graphicsAdapter, gfx_GraphicsDevice* graphicsDevice, res_ResourceManager* resources);
 
-        void SetCamera(const math_Mat4x4& cameraView, const math_Mat4x4& cameraProj);
+        void        SetCamera(const math_Mat4x4& cameraView, const math_Mat4x4& cameraProj);
+        math_Mat4x4 GetCameraViewProjection() const;
 
         void UpdateLights(const game_LightManager&     lmanager,
                           const game_TransformManager& tmanager,
@@ -93,9 +101,23 @@ namespace pge
         void DrawSkeletalMesh(const res_Mesh*        mesh,
                               const res_Material*    material,
                               const math_Mat4x4&     modelMatrix,
-                              const anim_Skeleton&   skeleton,
+                              const math_Mat4x4*     palette,
+                              size_t                 numBones,
                               const game_RenderPass& pass);
 
+        // The command for drawing a mesh in the pass, with the effect and material the pass binds for it. The palette
+        // is null for static meshes, which are instanced when the effect has an instanced variant.
+        game_RenderCommand CreateRenderCommand(const res_Mesh*        mesh,
+                                               const res_Material*    material,
+                                               const math_Mat4x4&     modelMatrix,
+                                               const math_Mat4x4*     palette,
+                                               size_t                 numBones,
+                                               const game_RenderPass& pass) const;
+        float              GetCameraDepth(const math_Vec3& worldPosition) const; // In [0, 1] when in view
+        // Draws a sorted queue, only binding the state that differs from the previous draw, and each batch with one
+        // instanced draw.
+        void DrawQueue(const game_RenderQueue& queue);
+
         void DrawRenderToView(const gfx_RenderTarget* rt, const res_Effect* effect);
     };
 } // namespace pge
@@ -2,9 +2,9 @@
 #define PGE_GAME_GAME_SCRIPT_H
 
 #include "game_entity.h"
+#include "game_component_pool.h"
 #include <memory>
 #include <string>
-#include <unordered_map>
 
 namespace pge
 {
@@ -15,13 +15,12 @@ namespace pge
         std::unique_ptr<ScriptAPIImpl> m_apiImpl;
 
         struct ScriptComponent {
-            game_Entity entity;
             std::string path;
+            int         envRef;    // Registry ref to the script's environment table
+            int         updateRef; // Registry ref to the script's onUpdate function
             // TODO: Parameters (and maybe the script itself should be a static resource)
         };
-        std::unordered_map<game_Entity, game_ScriptId> m_entityMap;
-        std::unique_ptr<ScriptComponent[]>             m_scripts;
-        size_t                                         m_numScripts;
+        game_ComponentPool<ScriptComponent> m_scripts;
 
     public:
         explicit game_ScriptManager(size_t capacity);
@@ -35,10 +34,15 @@ namespace pge
         void          SetScript(const game_ScriptId& id, const char* path);
         void          DestroyScript(const game_ScriptId& id);
 
+        void ReloadScript(const char* path);
         void UpdateScripts();
 
         void SerializeEntity(std::ostream& os, const game_Entity& entity) const;
         void InsertSerializedEntity(std::istream& is, const game_Entity& entity);
+
+    private:
+        void LoadScript(ScriptComponent* script);
+        void UnloadScript(ScriptComponent* script);
     };
 } // namespace pge
 
@@ -0,0 +1,73 @@
+#ifndef PGE_GAME_GAME_SPATIAL_INDEX_H
+#define PGE_GAME_GAME_SPATIAL_INDEX_H
+
+#include "game_entity.h"
+#include "game_component_pool.h"
+#include <math_raycasting.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace pge
+{
+    // World-space bounds of entities in a hashed uniform grid, for picking and proximity queries. An entity is
+    // listed in every cell its bounds overlap; ones that would span too many cells are kept in a separate list that
+    // every query tests. Queries return every entity whose bounds pass the test once, in no particular order.
+    // Queries are not thread-safe: they mark the entities they visit.
+    class game_SpatialIndex {
+        struct CellRange {
+            int min[3];
+            int max[3];
+        };
+
+        struct Item {
+            math_AABB        bounds;
+            CellRange        cells;
+            bool             oversized;
+            mutable uint32_t queryStamp; // Of the last query that tested it
+        };
+
+        using Cell = std::vector<game_Entity>;
+
+        float                              m_cellSize;
+        game_ComponentPool<Item>           m_items;
+        std::unordered_map<uint64_t, Cell> m_cells;
+        Cell                               m_oversized;
+        CellRange                          m_occupied; // Spans every cell that held an item since the last Clear
+        mutable uint32_t                   m_queryStamp;
+
+        CellRange GetCellRange(const math_AABB& bounds) const;
+        void      Link(const game_Entity& entity, const Item& item);
+        void      Unlink(const game_Entity& entity, const Item& item);
+        void      BeginQuery() const;
+        bool      Visit(const game_Entity& entity) const; // False if the current query tested it already
+
+        template <typename Test>
+        void VisitCells(const CellRange& range, const Test& test, std::vector<game_Entity>* result) const;
+        // Walks the cells along the ray up to maxDistance, in order; stops early when onCell returns false.
+        template <typename OnCell>
+        void WalkRay(const math_Ray& ray, float maxDistance, const OnCell& onCell) const;
+
+    public:
+        explicit game_SpatialIndex(float cellSize = 4.0f);
+
+        void   Clear();
+        size_t Size() const;
+
+        // Inserts the entity, or moves it if it is already indexed.
+        void Update(const game_Entity& entity, const math_AABB& bounds);
+        void Remove(const game_Entity& entity); // Does nothing if the entity isn't indexed
+        bool Has(const game_Entity& entity) const;
+
+        const math_AABB& GetBounds(const game_Entity& entity) const;
+
+        // The entity whose bounds the ray enters first, or game_EntityId_Invalid. The distance is along the ray.
+        game_Entity Raycast(const math_Ray& ray, float* distanceOut) const;
+        // Results are appended to the vector.
+        void QueryRay(const math_Ray& ray, float maxDistance, std::vector<game_Entity>* result) const;
+        void QueryAABB(const math_AABB& box, std::vector<game_Entity>* result) const;
+        void QuerySphere(const math_Vec3& center, float radius, std::vector<game_Entity>* result) const;
+    };
+} // namespace pge
+
+#endif
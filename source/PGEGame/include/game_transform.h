@@ -2,37 +2,61 @@
 #define PGE_GAME_GAME_TRANSFORM_H
 
 #include "game_entity.h"
+#include "game_component_pool.h"
+#include "game_chunked_array.h"
 #include <math_mat4x4.h>
-#include <unordered_map>
+#include <vector>
 
 namespace pge
 {
     using game_TransformId                         = unsigned;
     static const unsigned game_TransformId_Invalid = -1;
 
-    struct LocalTransformData;
-    class game_TransformManager {
-        std::unordered_map<game_Entity, game_TransformId> m_entityMap;
-
-        size_t m_capacity;
-        void*  m_buffer;
-
-        game_Entity*        m_entity;
-        LocalTransformData* m_localData;
-        math_Mat4x4*        m_local;
-        math_Mat4x4*        m_world;
-        game_TransformId*   m_parent;
-        game_TransformId*   m_firstChild;
-        game_TransformId*   m_next;
-        game_TransformId*   m_prev;
+    struct LocalTransformData {
+        math_Vec3 position;
+        math_Quat rotation;
+        math_Vec3 scale;
+    };
 
-        void                   AllocateBuffers(size_t capacity);
+    // Transforms are stored sorted by depth in the hierarchy (roots first), so every parent precedes its children.
+    // Keeping that order means transform ids change on CreateTransform, SetParent and DestroyTransform; hold on to entities instead.
+    class game_TransformManager {
+        game_EntitySparseSet m_entities;
+
+        // Each buffer grows in chunks, so adding transforms never copies the existing ones
+        template <typename T>
+        using Buffer = game_ChunkedArray<T, 1024>;
+
+        Buffer<LocalTransformData>  m_localData;
+        Buffer<math_Mat4x4>         m_local;
+        mutable Buffer<math_Mat4x4> m_world;
+        mutable Buffer<math_Quat>   m_worldRotation; // Cached decomposition of m_world
+        mutable Buffer<math_Vec3>   m_worldScale;
+        Buffer<game_TransformId>    m_parent;
+        Buffer<game_TransformId>    m_firstChild;
+        Buffer<game_TransformId>    m_next;
+        Buffer<game_TransformId>    m_prev;
+        Buffer<unsigned>            m_depth;
+        mutable Buffer<bool>        m_dirty; // Local matrix changed since the world matrix was last computed
+
+        std::vector<size_t>      m_levelEnd; // One past the last transform of each depth level
+        std::vector<game_Entity> m_subtree;  // Scratch space for moving subtrees between levels
+        mutable size_t           m_dirtyCount;
+        size_t                   m_firstDirty; // No dirty transform precedes it (when m_dirtyCount > 0)
+
+        bool                             m_trackMoved;
+        mutable std::vector<game_Entity> m_movedEntities; // World matrix set since the last TakeMovedEntities
+
+        void                   ResizeBuffers(size_t numTransforms);
         game_TransformManager& operator=(const game_TransformManager& rhs) = delete;
 
     public:
         explicit game_TransformManager(size_t capacity);
         ~game_TransformManager();
 
+        void   Reserve(size_t capacity);
+        size_t GetNumTransforms() const;
+
         game_TransformId CreateTransform(const game_Entity& entity,
                                          const math_Vec3&   position = math_Vec3::Zero(),
                                          const math_Quat&   rotation = math_Quat(),
@@ -41,8 +65,17 @@ namespace pge
         void             DestroyTransform(const game_TransformId& id);
         void             GarbageCollect(const game_EntityManager& entityManager);
 
+        // Recomputes the world matrices of all transforms whose local matrix (or an ancestor's) changed.
+        // Setters only mark transforms dirty; world getters resolve lazily when called in between.
+        void UpdateWorldTransforms();
+        // Swaps in the entities whose world matrix was set or whose transform was destroyed since the last call, for
+        // systems that keep world-space data such as bounds. Entities can be listed more than once. Tracking starts
+        // with the first call.
+        void TakeMovedEntities(std::vector<game_Entity>* moved);
+
         bool             HasTransform(const game_Entity& entity) const;
         game_TransformId GetTransformId(const game_Entity& entity) const;
+        game_TransformId FindTransformId(const game_Entity& entity) const; // game_TransformId_Invalid if it has none
 
         void Translate(const game_TransformId& id, const math_Vec3& translation);
         void Rotate(const game_TransformId& id, const math_Vec3& axis, float degrees);
@@ -80,8 +113,21 @@ namespace pge
         friend std::istream& operator>>(std::istream& is, game_TransformManager& tm);
 
     private:
-        void Transform(const game_TransformId& id, const math_Mat4x4& parent);
-        void SetLocal(const game_TransformId& id, const math_Mat4x4& matrix);
+        void             Transform(const game_TransformId& id, const math_Mat4x4& parent) const;
+        void             SetWorld(const game_TransformId& id, const math_Mat4x4& world) const;
+        void             SetLocal(const game_TransformId& id, const math_Mat4x4& matrix);
+        void             MarkDirty(const game_TransformId& id);
+        game_TransformId FindDirtyRoot(game_TransformId id) const;
+        void             ResolveWorld(const game_TransformId& id) const;
+        void             UpdateWorldRange(size_t begin, size_t end);
+
+        void             Link(const game_TransformId& child, const game_TransformId& parent);
+        void             Unlink(const game_TransformId& child);
+        void             MoveSlot(const game_TransformId& from, const game_TransformId& to);
+        void             SwapTransforms(const game_TransformId& a, const game_TransformId& b);
+        game_TransformId MoveToDepth(game_TransformId id, unsigned depth);
+        void             TrimLevels();
+        void             SortByDepth();
     };
 } // namespace pge
 
@@ -10,12 +10,26 @@
 #include "game_script.h"
 #include "game_behaviour.h"
 #include "game_renderer.h"
+#include <mem_frame_arena.h>
 
 namespace pge
 {
     class gfx_GraphicsAdapter;
     class gfx_GraphicsDevice;
     using game_SerializedEntity = std::unique_ptr<char[]>;
+
+    // Number of components each manager reserves up front. All of them grow on demand, so this only avoids reallocations.
+    struct game_WorldCapacity {
+        size_t transforms;
+        size_t meshes;
+        size_t animators;
+        size_t lights;
+        size_t scripts;
+        size_t frameArenaBytes; // Per frame; the world keeps two frames of transient allocations alive
+
+        explicit game_WorldCapacity(size_t numEntities = 128);
+    };
+
     class game_World {
         game_EntityManager    m_entityManager;
         game_TransformManager m_transformManager;
@@ -26,11 +40,17 @@ namespace pge
         game_BehaviourManager m_behaviourManager;
         game_CameraManager    m_cameraManager;
         game_Renderer         m_renderer;
+        mem_FrameArena        m_frameArena;
 
     public:
-        game_World(gfx_GraphicsAdapter* graphicsAdapter, gfx_GraphicsDevice* graphicsDevice, res_ResourceManager* resources);
+        game_World(gfx_GraphicsAdapter*      graphicsAdapter,
+                   gfx_GraphicsDevice*       graphicsDevice,
+                   res_ResourceManager*      resources,
+                   const game_WorldCapacity& capacity = game_WorldCapacity());
         void GarbageCollect();
         void Update();
+        // Recycles the transient allocations of the frame before last.
+        void BeginFrame();
 
         void Draw(const math_Mat4x4& view, const math_Mat4x4& proj, const game_RenderPass& pass = game_RenderPass::LIGHTING, bool withDebug = true);
         void Draw();
@@ -47,6 +67,7 @@ namespace pge
         game_BehaviourManager* GetBehaviourManager();
         game_CameraManager*    GetCameraManager();
         game_Renderer*         GetRenderer();
+        mem_FrameArena*        GetFrameArena();
 
         const game_EntityManager*    GetEntityManager() const;
         const game_TransformManager* GetTransformManager() const;
@@ -1,51 +1,64 @@
 #include "../include/game_animation.h"
+#include "../include/game_mesh.h"
+#include "../include/game_transform.h"
+#include <algorithm>
+#include <cfloat>
 
 namespace pge
 {
-    game_AnimationManager::game_AnimationManager(size_t capacity)
+    // Tuned for a top-down camera, where most characters cover little of the screen
+    static const game_AnimationLodTier DEFAULT_LOD_TIERS[] = {
+        {20.0f, 1, anim_AnimatorLod()},
+        {40.0f, 2, anim_AnimatorLod(true, false)},
+        {FLT_MAX, 4, anim_AnimatorLod(true, true)},
+    };
+
+    static math_AABB
+    UnionAABB(const math_AABB& a, const math_AABB& b)
     {
-        m_animators.reserve(capacity);
-        m_entities.reserve(capacity);
+        math_AABB result = a;
+        for (int j = 0; j < 3; ++j) {
+            result.min[j] = std::min(result.min[j], b.min[j]);
+            result.max[j] = std::max(result.max[j], b.max[j]);
+        }
+        return result;
     }
 
+    static const std::vector<math_Mat4x4> EMPTY_PALETTE;
+
+    game_AnimationManager::game_AnimationManager(size_t capacity)
+        : m_animators(capacity)
+        , m_lodTiers(std::begin(DEFAULT_LOD_TIERS), std::end(DEFAULT_LOD_TIERS))
+        , m_viewpoint(0, 0, 0)
+        , m_updateIndex(0)
+        , m_stats()
+        , m_sharePoses(false)
+        , m_poseCache()
+        , m_bakedBytes(0)
+    {}
+
     game_AnimationManager::~game_AnimationManager() {}
 
     void
     game_AnimationManager::CreateAnimator(const game_Entity& entity, const res_AnimatorConfig* config)
     {
-        if (!m_freeList.empty()) {
-            size_t idx = m_freeList.back();
-            m_freeList.pop_back();
-            m_entityMap[entity] = idx;
-            m_entities[idx]     = entity;
-            m_animators[idx]    = anim_Animator(config->GetConfig());
-        } else {
-            m_entities.push_back(entity);
-            m_animators.push_back(anim_Animator(config->GetConfig()));
-            size_t idx          = m_animators.size() - 1;
-            m_entityMap[entity] = idx;
-        }
+        core_Assert(!HasAnimator(entity));
+        m_animators.Insert(entity, AnimatorComponent{anim_Animator(config->GetConfig()), {}, math_AABB(), entity, 0, nullptr});
     }
 
     void
     game_AnimationManager::DestroyAnimator(const game_Entity& entity)
     {
         core_Assert(HasAnimator(entity));
-        size_t idx = m_entityMap.at(entity);
-        m_entityMap.erase(m_entityMap.find(entity));
-        m_freeList.push_back(idx);
+        m_animators.Remove(m_animators.GetId(entity));
     }
 
     void
     game_AnimationManager::GarbageCollect(const game_EntityManager& entityManager)
     {
-        for (size_t aliveStreak = 0; m_entityMap.size() > 0 && aliveStreak < 4;) {
-            unsigned randIdx = rand() % m_entityMap.size();
-            if (!entityManager.IsEntityAlive(m_entities[randIdx])) {
-                DestroyAnimator(randIdx);
-                aliveStreak = 0;
-            } else {
-                aliveStreak++;
+        for (const game_Entity& entity : entityManager.GetDestroyedEntities()) {
+            if (!entityManager.IsEntityAlive(entity) && HasAnimator(entity)) {
+                DestroyAnimator(entity);
             }
         }
     }
@@ -53,7 +66,7 @@ namespace pge
     bool
     game_AnimationManager::HasAnimator(const game_Entity& entity) const
     {
-        return m_entityMap.find(entity) != m_entityMap.end();
+        return m_animators.Has(entity);
     }
 
     void
@@ -62,40 +75,228 @@ namespace pge
         if (!HasAnimator(entity)) {
             CreateAnimator(entity, config);
         } else {
-            size_t idx       = m_entityMap.at(entity);
-            m_animators[idx] = anim_Animator(config->GetConfig());
+            AnimatorComponent& component = m_animators[m_animators.GetId(entity)];
+            component.animator           = anim_Animator(config->GetConfig());
+            component.palette.clear();
+            component.paletteOwner = entity;
+            component.pendingTime  = 0;
+            if (component.bakedMesh != nullptr)
+                BakeAnimations(*config->GetConfig(), component.bakedMesh);
         }
     }
 
-    anim_Skeleton
-    game_AnimationManager::GetAnimatedSkeleton(const game_Entity& entity) const
+    const anim_Pose&
+    game_AnimationManager::GetAnimatedPose(const game_Entity& entity) const
+    {
+        core_Assert(HasAnimator(entity));
+        return m_animators[m_animators.GetId(entity)].animator.GetPose();
+    }
+
+    const std::vector<math_Mat4x4>&
+    game_AnimationManager::GetSkinningPalette(const game_Entity& entity) const
+    {
+        core_Assert(HasAnimator(entity));
+        const AnimatorComponent* owner = FindPaletteOwner(m_animators[m_animators.GetId(entity)]);
+        return owner != nullptr ? owner->palette : EMPTY_PALETTE;
+    }
+
+    const math_AABB&
+    game_AnimationManager::GetSkinnedBounds(const game_Entity& entity) const
     {
         core_Assert(HasAnimator(entity));
-        size_t idx = m_entityMap.at(entity);
-        return m_animators.at(idx).GetAnimatedSkeleton();
+        const AnimatorComponent& component = m_animators[m_animators.GetId(entity)];
+        const AnimatorComponent* owner     = FindPaletteOwner(component);
+        return owner != nullptr ? owner->bounds : component.bounds;
+    }
+
+    // Follows shared palettes to the animator that computed it, null if that animator was destroyed since. An
+    // animator only starts sharing with one that owns its palette, so this never loops.
+    const game_AnimationManager::AnimatorComponent*
+    game_AnimationManager::FindPaletteOwner(const AnimatorComponent& component) const
+    {
+        const AnimatorComponent* current = &component;
+        for (;;) {
+            const unsigned ownerId = m_animators.Find(current->paletteOwner);
+            if (ownerId == game_ComponentPool<AnimatorComponent>::InvalidId)
+                return nullptr;
+            if (&m_animators[ownerId] == current)
+                return current;
+            current = &m_animators[ownerId];
+        }
+    }
+
+    const game_AnimationLodTier&
+    game_AnimationManager::SelectLodTier(const game_TransformManager& transformManager, const game_Entity& entity) const
+    {
+        const game_TransformId tid = transformManager.FindTransformId(entity);
+        if (tid == game_TransformId_Invalid)
+            return m_lodTiers.front();
+
+        const float distance = math_Length(transformManager.GetWorldPosition(tid) - m_viewpoint);
+        for (const game_AnimationLodTier& tier : m_lodTiers) {
+            if (distance < tier.maxDistance)
+                return tier;
+        }
+        return m_lodTiers.back();
     }
 
     void
-    game_AnimationManager::Update(float dt)
+    game_AnimationManager::SetLodTiers(const game_AnimationLodTier* tiers, size_t numTiers)
     {
-        for (auto& animator : m_animators) {
-            animator.Update(dt);
+        core_Assert(numTiers > 0);
+        for (size_t i = 0; i < numTiers; ++i) {
+            core_Assert(tiers[i].updateInterval > 0);
+            core_AssertWithReason(i == 0 || tiers[i - 1].maxDistance <= tiers[i].maxDistance, "LOD tiers must be sorted by distance");
         }
+        m_lodTiers.assign(tiers, tiers + numTiers);
     }
 
     void
-    game_AnimationManager::Trigger(const char* trigger)
+    game_AnimationManager::SetViewpoint(const math_Vec3& position)
+    {
+        m_viewpoint = position;
+    }
+
+    void
+    game_AnimationManager::SetPoseSharing(bool enabled, float timeStep)
     {
-        for (auto& animator : m_animators) {
-            animator.Trigger(trigger);
+        m_sharePoses = enabled;
+        m_poseCache  = anim_PoseCache(timeStep);
+    }
+
+    void
+    game_AnimationManager::SetBaked(const game_Entity& entity, const res_Mesh* mesh)
+    {
+        core_Assert(HasAnimator(entity));
+        AnimatorComponent& component = m_animators[m_animators.GetId(entity)];
+        if (mesh != nullptr) {
+            core_AssertWithReason(mesh->GetBoneOffsetMatrices().size() >= component.animator.GetSkeleton()->GetBoneCount(),
+                                  "The mesh is not skinned to the animator's skeleton");
+            BakeAnimations(*component.animator.GetConfig(), mesh);
         }
+        component.bakedMesh = mesh;
     }
 
     void
-    game_AnimationManager::Trigger(const game_Entity& entity, const char* trigger)
+    game_AnimationManager::BakeAnimations(const anim_AnimatorConfig& config, const res_Mesh* mesh)
+    {
+        for (unsigned i = 0; i < config.GetStateCount(); ++i) {
+            const anim_SkeletonAnimation* animation = config.GetState(i).animation;
+            BakedClip&                    baked     = m_bakedAnimations[BakeKey(mesh, config.GetSkeleton(), animation)];
+            if (baked == nullptr) {
+                baked.reset(new anim_BakedAnimation(*config.GetSkeleton(), *animation, mesh->GetBoneOffsetMatrices().data()));
+                m_bakedBytes += baked->GetSizeInBytes();
+            }
+        }
+    }
+
+    void
+    game_AnimationManager::Update(float dt, const game_MeshManager& meshManager, const game_TransformManager& transformManager)
+    {
+        m_stats = game_AnimationStats();
+        ++m_updateIndex;
+        m_poseCache.Clear();
+        m_sharedPalettes.clear();
+        for (unsigned id = 0; id < m_animators.Size(); ++id) {
+            AnimatorComponent&           component = m_animators[id];
+            const game_Entity&           entity    = m_animators.GetEntity(id);
+            const game_AnimationLodTier& tier      = SelectLodTier(transformManager, entity);
+            ++m_stats.numAnimators;
+
+            // Offset by id, so throttled animators don't all come due on the same update
+            component.pendingTime += dt;
+            const bool               isDue = (m_updateIndex + id) % tier.updateInterval == 0;
+            const AnimatorComponent* owner = FindPaletteOwner(component);
+            if (!isDue && owner != nullptr && !owner->palette.empty())
+                continue;
+
+            component.animator.SetLod(tier.lod);
+            component.animator.Update(component.pendingTime);
+            component.pendingTime = 0;
+
+            const res_Mesh* mesh = meshManager.HasMesh(entity) ? meshManager.GetMesh(meshManager.GetMeshId(entity)) : nullptr;
+            if (component.bakedMesh != nullptr && component.bakedMesh == mesh) {
+                float                      time;
+                const anim_AnimationState* state = component.animator.GetDominantState(&time);
+                const anim_BakedAnimation& baked = *m_bakedAnimations.at(BakeKey(mesh, component.animator.GetSkeleton(), state->animation));
+                component.palette.resize(baked.GetBoneCount());
+                component.paletteOwner = entity;
+                baked.Sample(time, true, component.palette.data());
+                component.bounds = UnionAABB(mesh->GetAABB(), baked.GetBoneBounds());
+                ++m_stats.numUpdatedAnimators;
+                ++m_stats.numBakedAnimators;
+                continue;
+            }
+
+            const size_t     numHits = m_poseCache.GetNumHits();
+            const anim_Pose& pose    = m_sharePoses ? m_poseCache.GetPose(component.animator) : component.animator.GetPose();
+            ++m_stats.numUpdatedAnimators;
+            if (m_poseCache.GetNumHits() != numHits)
+                ++m_stats.numSharedPoses;
+            else
+                m_stats.numEvaluatedBones += component.animator.GetNumEvaluatedBones();
+            if (mesh == nullptr || mesh->GetBoneOffsetMatrices().size() < pose.GetBoneCount()) {
+                component.palette.clear();
+                component.paletteOwner = entity;
+                continue;
+            }
+
+            if (m_sharePoses) {
+                auto shared = m_sharedPalettes.emplace(std::make_pair(&pose, mesh), id);
+                if (!shared.second) {
+                    // Identical characters skin with the one palette instead of each copying it
+                    component.palette.clear();
+                    component.paletteOwner = m_animators.GetEntity(shared.first->second);
+                    continue;
+                }
+            }
+            component.paletteOwner = entity;
+            component.palette.resize(pose.GetBoneCount());
+            anim_ComputeSkinningPalette(pose, mesh->GetBoneOffsetMatrices().data(), component.palette.data());
+            component.bounds = mesh->GetAABB();
+            anim_ExpandBoundsToBones(pose, &component.bounds);
+        }
+        m_stats.bakedBytes = m_bakedBytes;
+    }
+
+    void
+    game_AnimationManager::Trigger(anim_TriggerId trigger)
+    {
+        for (auto& component : m_animators) {
+            component.animator.Trigger(trigger);
+        }
+    }
+
+    void
+    game_AnimationManager::Trigger(const game_Entity& entity, anim_TriggerId trigger)
     {
         core_Assert(HasAnimator(entity));
-        size_t idx = m_entityMap.at(entity);
-        m_animators.at(idx).Trigger(trigger);
+        m_animators[m_animators.GetId(entity)].animator.Trigger(trigger);
+    }
+
+    void
+    game_AnimationManager::Trigger(const game_Entity* entities, size_t numEntities, anim_TriggerId trigger)
+    {
+        for (size_t i = 0; i < numEntities; ++i) {
+            Trigger(entities[i], trigger);
+        }
+    }
+
+    void
+    game_AnimationManager::Trigger(const char* trigger)
+    {
+        Trigger(anim_HashTrigger(trigger));
+    }
+
+    void
+    game_AnimationManager::Trigger(const game_Entity& entity, const char* trigger)
+    {
+        Trigger(entity, anim_HashTrigger(trigger));
+    }
+
+    const game_AnimationStats&
+    game_AnimationManager::GetStats() const
+    {
+        return m_stats;
     }
 } // namespace pge
\ No newline at end of file
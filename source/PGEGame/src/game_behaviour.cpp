@@ -16,9 +16,21 @@ namespace pge
         m_behaviours.erase(m_behaviours.find(entity));
     }
 
+    bool
+    game_BehaviourManager::HasBehaviour(const game_Entity& entity) const
+    {
+        return m_behaviours.find(entity) != m_behaviours.end();
+    }
+
     void
     game_BehaviourManager::GarbageCollect(const game_EntityManager& entityManager)
-    {}
+    {
+        for (const game_Entity& entity : entityManager.GetDestroyedEntities()) {
+            if (!entityManager.IsEntityAlive(entity) && HasBehaviour(entity)) {
+                DestroyBehaviour(entity);
+            }
+        }
+    }
 
     void
     game_BehaviourManager::Update(float delta)
@@ -18,7 +18,7 @@ namespace pge
     game_CameraManager::CreateCamera(const game_Entity& entity)
     {
         core_Assert(!HasCamera(entity));
-        m_cameras[entity] = Camera{math_Mat4x4()};
+        m_cameras.Insert(entity, Camera{math_Mat4x4()});
         if (!m_tmanager->HasTransform(entity)) {
             m_tmanager->CreateTransform(entity);
         }
@@ -46,23 +46,21 @@ namespace pge
     game_CameraManager::DestroyCamera(const game_Entity& camera)
     {
         core_Assert(HasCamera(camera));
-        m_cameras.erase(m_cameras.find(camera));
+        m_cameras.Remove(m_cameras.GetId(camera));
     }
 
     bool
     game_CameraManager::HasCamera(const game_Entity& entity) const
     {
-        return m_cameras.find(entity) != m_cameras.end();
+        return m_cameras.Has(entity);
     }
 
     void
     game_CameraManager::GarbageCollect(const game_EntityManager& entityManager)
     {
-        for (auto it = m_cameras.begin(); it != m_cameras.end();) {
-            if (!entityManager.IsEntityAlive(it->first)) {
-                it = m_cameras.erase(it);
-            } else {
-                ++it;
+        for (const game_Entity& entity : entityManager.GetDestroyedEntities()) {
+            if (!entityManager.IsEntityAlive(entity) && HasCamera(entity)) {
+                DestroyCamera(entity);
             }
         }
     }
@@ -71,8 +69,9 @@ namespace pge
     game_CameraManager::SetPerspective(const game_Entity& camera, const game_PerspectiveInfo& perspective)
     {
         core_Assert(HasCamera(camera));
-        m_cameras.at(camera).projectionMatrix = math_PerspectiveFovRH(perspective.fov, perspective.aspect, perspective.nearClip, perspective.farClip);
-        m_cameras.at(camera).perspective      = perspective;
+        Camera& cam          = m_cameras[m_cameras.GetId(camera)];
+        cam.projectionMatrix = math_PerspectiveFovRH(perspective.fov, perspective.aspect, perspective.nearClip, perspective.farClip);
+        cam.perspective      = perspective;
     }
 
     math_Mat4x4
@@ -89,14 +88,14 @@ namespace pge
     game_CameraManager::GetProjectionMatrix(const game_Entity& camera) const
     {
         core_Assert(HasCamera(camera));
-        return m_cameras.at(camera).projectionMatrix;
+        return m_cameras[m_cameras.GetId(camera)].projectionMatrix;
     }
 
     const game_PerspectiveInfo&
     game_CameraManager::GetPerspective(const game_Entity& camera) const
     {
         core_Assert(HasCamera(camera));
-        return m_cameras.at(camera).perspective;
+        return m_cameras[m_cameras.GetId(camera)].perspective;
     }
 
     void
@@ -140,8 +139,8 @@ namespace pge
         game_Entity closestEntity(game_EntityId_Invalid);
         float       closestDepth = std::numeric_limits<float>::max();
 
-        for (const auto& kv : m_cameras) {
-            const auto& camera = kv.first;
+        for (unsigned i = 0; i < m_cameras.Size(); ++i) {
+            const game_Entity& camera = m_cameras.GetEntity(i);
 
             math_Vec3 worldPos = m_tmanager->GetWorldPosition(m_tmanager->GetTransformId(camera));
             math_Vec4 viewPos  = view * math_Vec4(worldPos, 1);
@@ -225,7 +224,7 @@ namespace pge
     {
         if (!HasCamera(entity))
             return;
-        const Camera& camera = m_cameras.at(entity);
+        const Camera& camera = m_cameras[m_cameras.GetId(entity)];
         os.write((const char*)&camera.perspective, sizeof(camera.perspective));
     }
 
@@ -244,11 +243,12 @@ namespace pge
     std::ostream&
     operator<<(std::ostream& os, const game_CameraManager& cm)
     {
-        auto numCameras = static_cast<unsigned>(cm.m_cameras.size());
+        auto numCameras = static_cast<unsigned>(cm.m_cameras.Size());
         os.write((const char*)&numCameras, sizeof(numCameras));
-        for (const auto& kv : cm.m_cameras) {
-            os.write((const char*)&kv.first, sizeof(kv.first));
-            cm.SerializeEntity(os, kv.first);
+        for (unsigned i = 0; i < numCameras; ++i) {
+            const game_Entity& entity = cm.m_cameras.GetEntity(i);
+            os.write((const char*)&entity, sizeof(entity));
+            cm.SerializeEntity(os, entity);
         }
         return os;
     }
@@ -0,0 +1,106 @@
+#include "../include/game_component_pool.h"
+
+namespace pge
+{
+    void
+    game_EntitySparseSet::Reserve(size_t capacity)
+    {
+        m_dense.reserve(capacity);
+    }
+
+    void
+    game_EntitySparseSet::Clear()
+    {
+        m_sparse.clear();
+        m_dense.clear();
+    }
+
+    unsigned
+    game_EntitySparseSet::Insert(const game_Entity& entity)
+    {
+        core_AssertWithReason(FindAnyGeneration(entity) == InvalidId,
+                              "An older generation of the entity still has a slot, it must be removed before its index is reused.");
+        unsigned idx = entity.GetIndex();
+        if (idx >= m_sparse.size()) {
+            m_sparse.resize(idx + 1, InvalidId);
+        }
+        unsigned id   = m_dense.size();
+        m_sparse[idx] = id;
+        m_dense.push_back(entity);
+        return id;
+    }
+
+    void
+    game_EntitySparseSet::Remove(unsigned id)
+    {
+        core_Assert(id < m_dense.size());
+        unsigned lastId = m_dense.size() - 1;
+        if (id != lastId) {
+            Swap(id, lastId);
+        }
+        m_sparse[m_dense.back().GetIndex()] = InvalidId;
+        m_dense.pop_back();
+    }
+
+    void
+    game_EntitySparseSet::Swap(unsigned a, unsigned b)
+    {
+        core_Assert(a < m_dense.size() && b < m_dense.size());
+        std::swap(m_dense[a], m_dense[b]);
+        m_sparse[m_dense[a].GetIndex()] = a;
+        m_sparse[m_dense[b].GetIndex()] = b;
+    }
+
+    bool
+    game_EntitySparseSet::Has(const game_Entity& entity) const
+    {
+        return Find(entity) != InvalidId;
+    }
+
+    unsigned
+    game_EntitySparseSet::Find(const game_Entity& entity) const
+    {
+        unsigned idx = entity.GetIndex();
+        if (idx >= m_sparse.size())
+            return InvalidId;
+        unsigned id = m_sparse[idx];
+        return (id < m_dense.size() && m_dense[id] == entity) ? id : InvalidId;
+    }
+
+    unsigned
+    game_EntitySparseSet::FindAnyGeneration(const game_Entity& entity) const
+    {
+        unsigned idx = entity.GetIndex();
+        if (idx >= m_sparse.size())
+            return InvalidId;
+        unsigned id = m_sparse[idx];
+        return (id < m_dense.size() && m_dense[id].GetIndex() == idx) ? id : InvalidId;
+    }
+
+    unsigned
+    game_EntitySparseSet::GetId(const game_Entity& entity) const
+    {
+        unsigned id = Find(entity);
+        core_Assert(id != InvalidId);
+        return id;
+    }
+
+    const game_Entity&
+    game_EntitySparseSet::GetEntity(unsigned id) const
+    {
+        core_Assert(id < m_dense.size());
+        return m_dense[id];
+    }
+
+    const game_Entity*
+    game_EntitySparseSet::GetEntities() const
+    {
+        return m_dense.data();
+    }
+
+    size_t
+    game_EntitySparseSet::Size() const
+    {
+        return m_dense.size();
+    }
+} // namespace pge
@@ -1,8 +1,14 @@
 #include "../include/game_entity.h"
 #include <core_assert.h>
+#include <mem_frame_arena.h>
+#include <cstdio>
 #include <iostream>
 #include <sstream>
 
+#ifdef _MSC_VER
+#    include <intrin.h>
+#endif
+
 namespace pge
 {
     static const unsigned EntityIndexBits = 22;
@@ -13,6 +19,21 @@ namespace pge
 
     static const unsigned MinimumFreeIndices = 1024;
 
+    static const unsigned AliveMaskBits = 64;
+
+    static unsigned
+    LowestSetBit(unsigned long long mask)
+    {
+        core_Assert(mask != 0);
+#ifdef _MSC_VER
+        unsigned long bit;
+        _BitScanForward64(&bit, mask);
+        return bit;
+#else
+        return __builtin_ctzll(mask);
+#endif
+    }
+
     // -------------------------------------------------------
     // game_Entity
     // -------------------------------------------------------
@@ -59,11 +80,7 @@ namespace pge
     game_EntityManager::game_EntityIterator&
     game_EntityManager::game_EntityIterator::operator++()
     {
-        auto nextIdx = m_idx + 1;
-        while (std::find(m_manager->m_freeIndices.begin(), m_manager->m_freeIndices.end(), nextIdx) != m_manager->m_freeIndices.end()) {
-            nextIdx++;
-        }
-        m_idx = nextIdx;
+        m_idx = m_manager->NextAliveIndex(m_idx + 1);
         return *this;
     }
 
@@ -95,10 +112,8 @@ namespace pge
     game_EntityManager::game_EntityManager() = default;
     game_EntityManager::game_EntityManager(const game_Entity* entities, size_t numEntities)
     {
-        m_generation.reserve(numEntities);
         for (size_t i = 0; i < numEntities; ++i) {
-            const game_Entity& entity       = entities[i];
-            m_generation[entity.GetIndex()] = entity.GetGeneration();
+            CreateEntity(entities[i]);
         }
     }
 
@@ -108,12 +123,10 @@ namespace pge
         unsigned idx;
         if (m_freeIndices.size() > MinimumFreeIndices) {
             idx = m_freeIndices.back();
-            m_freeIndices.pop_back();
         } else {
-            m_generation.push_back(0);
-            idx = m_generation.size() - 1;
-            core_Assert(idx < (1 << EntityIndexBits));
+            idx = AddIndex();
         }
+        AllocateIndex(idx);
         return game_Entity(idx, m_generation[idx]);
     }
 
@@ -128,12 +141,13 @@ namespace pge
     void
     game_EntityManager::CreateEntity(const game_Entity& entity)
     {
-        core_Assert(!IsEntityAlive(entity));
-        auto it = std::find(m_freeIndices.begin(), m_freeIndices.end(), entity.GetIndex());
-        if (it != m_freeIndices.end()) {
-            m_freeIndices.erase(it);
+        unsigned idx = entity.GetIndex();
+        while (idx >= m_generation.size()) {
+            AddIndex();
         }
-        m_generation[entity.GetIndex()] = entity.GetGeneration();
+        core_Assert(!IsIndexAlive(idx));
+        AllocateIndex(idx);
+        m_generation[idx] = entity.GetGeneration();
     }
 
     void
@@ -147,9 +161,11 @@ namespace pge
     void
     game_EntityManager::DestroyEntity(const game_Entity& entity)
     {
+        core_Assert(IsEntityAlive(entity));
         unsigned idx = entity.GetIndex();
         m_generation[idx]++;
-        m_freeIndices.push_back(idx);
+        FreeIndex(idx);
+        m_destroyed.push_back(entity);
 
         auto it = m_names.find(entity);
         if (it != m_names.end()) {
@@ -160,7 +176,20 @@ namespace pge
     bool
     game_EntityManager::IsEntityAlive(const game_Entity& entity) const
     {
-        return m_generation[entity.GetIndex()] == entity.GetGeneration();
+        unsigned idx = entity.GetIndex();
+        return idx < m_generation.size() && IsIndexAlive(idx) && m_generation[idx] == entity.GetGeneration();
+    }
+
+    const std::vector<game_Entity>&
+    game_EntityManager::GetDestroyedEntities() const
+    {
+        return m_destroyed;
+    }
+
+    void
+    game_EntityManager::ClearDestroyedEntities()
+    {
+        m_destroyed.clear();
     }
 
     std::string
@@ -177,6 +206,20 @@ namespace pge
         }
     }
 
+    const char*
+    game_EntityManager::GetName(const game_Entity& entity, mem_FrameArena* arena) const
+    {
+        core_Assert(IsEntityAlive(entity));
+        auto it = m_names.find(entity);
+        if (it != m_names.end())
+            return it->second.c_str();
+
+        const size_t bufferSize = sizeof("Entity [4294967295]");
+        char*        name       = static_cast<char*>(arena->Allocate(bufferSize, 1));
+        snprintf(name, bufferSize, "Entity [%u]", entity.id);
+        return name;
+    }
+
     void
     game_EntityManager::SetName(const game_Entity& entity, const char* name)
     {
@@ -187,11 +230,7 @@ namespace pge
     game_EntityManager::game_EntityIterator
     game_EntityManager::begin() const
     {
-        unsigned idx = 0;
-        while (std::find(m_freeIndices.begin(), m_freeIndices.end(), idx) != m_freeIndices.end()) {
-            ++idx;
-        }
-        return game_EntityIterator(this, idx);
+        return game_EntityIterator(this, NextAliveIndex(0));
     }
 
     game_EntityManager::game_EntityIterator
@@ -229,14 +268,10 @@ namespace pge
     {
         unsigned numEntities = em.m_generation.size() - em.m_freeIndices.size();
         os.write((const char*)&numEntities, sizeof(numEntities));
-        for (size_t i = 0; i < em.m_generation.size(); ++i) {
-            // If i is in m_freeIndices, then that entity was deleted
-            if (std::find(em.m_freeIndices.begin(), em.m_freeIndices.end(), i) != em.m_freeIndices.end())
-                continue;
-            const game_Entity entity(i, em.m_generation[i]);
+        for (const game_Entity& entity : em) {
             os.write((const char*)&entity.id, sizeof(game_EntityId));
-            
-            const std::string& name = em.m_names.at(entity);
+
+            const std::string& name    = em.m_names.at(entity);
             unsigned           nameLen = name.size();
             os.write((const char*)&nameLen, sizeof(nameLen));
             os.write(name.c_str(), nameLen);
@@ -249,12 +284,16 @@ namespace pge
     {
         em.m_generation.clear();
         em.m_freeIndices.clear();
+        em.m_freeSlots.clear();
+        em.m_aliveMask.clear();
+        em.m_names.clear();
+        em.m_destroyed.clear();
         unsigned numEntities = 0;
         is.read((char*)&numEntities, sizeof(numEntities));
         if (numEntities == 0)
             return is;
 
-        em.m_generation.resize(numEntities);
+        em.m_generation.reserve(numEntities);
         for (size_t i = 0; i < numEntities; ++i) {
             game_EntityId entityId = 0;
             is.read((char*)&entityId, sizeof(entityId));
@@ -267,13 +306,69 @@ namespace pge
             name[nameLen] = '\0';
 
             game_Entity entity(entityId);
-            while (entity.GetIndex() >= em.m_generation.size()) {
-                em.m_generation.push_back(0);
-                em.m_freeIndices.push_back(em.m_generation.size() - 1);
-            }
-            em.m_generation[entity.GetIndex()] = entity.GetGeneration();
+            em.CreateEntity(entity);
             em.SetName(entity, name.get());
         }
         return is;
     }
-} // namespace pge
\ No newline at end of file
+
+    // Appends a new (free) index
+    unsigned
+    game_EntityManager::AddIndex()
+    {
+        unsigned idx = m_generation.size();
+        core_Assert(idx < (1 << EntityIndexBits));
+        m_generation.push_back(0);
+        m_freeSlots.push_back(m_freeIndices.size());
+        m_freeIndices.push_back(idx);
+        if (idx / AliveMaskBits >= m_aliveMask.size()) {
+            m_aliveMask.push_back(0);
+        }
+        return idx;
+    }
+
+    // Takes a free index off the free-list in O(1) by swapping it with the last free index
+    void
+    game_EntityManager::AllocateIndex(unsigned idx)
+    {
+        core_Assert(!IsIndexAlive(idx));
+        unsigned slot    = m_freeSlots[idx];
+        unsigned lastIdx = m_freeIndices.back();
+        m_freeIndices[slot]  = lastIdx;
+        m_freeSlots[lastIdx] = slot;
+        m_freeIndices.pop_back();
+        m_aliveMask[idx / AliveMaskBits] |= 1ull << (idx % AliveMaskBits);
+    }
+
+    void
+    game_EntityManager::FreeIndex(unsigned idx)
+    {
+        core_Assert(IsIndexAlive(idx));
+        m_freeSlots[idx] = m_freeIndices.size();
+        m_freeIndices.push_back(idx);
+        m_aliveMask[idx / AliveMaskBits] &= ~(1ull << (idx % AliveMaskBits));
+    }
+
+    bool
+    game_EntityManager::IsIndexAlive(unsigned idx) const
+    {
+        return (m_aliveMask[idx / AliveMaskBits] >> (idx % AliveMaskBits)) & 1;
+    }
+
+    // Returns the first alive index at or after idx, or the number of indices if there is none
+    unsigned
+    game_EntityManager::NextAliveIndex(unsigned idx) const
+    {
+        size_t wordIdx = idx / AliveMaskBits;
+        if (wordIdx >= m_aliveMask.size())
+            return m_generation.size();
+
+        unsigned long long word = m_aliveMask[wordIdx] & (~0ull << (idx % AliveMaskBits));
+        while (word == 0) {
+            if (++wordIdx == m_aliveMask.size())
+                return m_generation.size();
+            word = m_aliveMask[wordIdx];
+        }
+        return wordIdx * AliveMaskBits + LowestSetBit(word);
+    }
+} // namespace pge
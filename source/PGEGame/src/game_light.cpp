@@ -7,31 +7,21 @@ namespace pge
 {
     game_LightManager::game_LightManager(game_TransformManager* tmanager, size_t capacity)
         : m_transformManager(tmanager)
-        , m_dirLights(new game_DirectionalLight[capacity])
-        , m_numDirLights(0)
-        , m_pointLights(new game_PointLight[capacity])
-        , m_numPointLights(0)
+        , m_dirLights(capacity)
+        , m_pointLights(capacity)
     {}
 
     void
     game_LightManager::GarbageCollect(const game_EntityManager& entityManager)
     {
-        for (size_t aliveStreak = 0; m_numDirLights > 0 && aliveStreak < 4;) {
-            unsigned randIdx = rand() % m_numDirLights;
-            if (!entityManager.IsEntityAlive(m_dirLights[randIdx].entity)) {
-                DestroyDirectionalLight(randIdx);
-                aliveStreak = 0;
-            } else {
-                aliveStreak++;
+        for (const game_Entity& entity : entityManager.GetDestroyedEntities()) {
+            if (entityManager.IsEntityAlive(entity))
+                continue;
+            if (HasDirectionalLight(entity)) {
+                DestroyDirectionalLight(GetDirectionalLightId(entity));
             }
-        }
-        for (size_t aliveStreak = 0; m_numPointLights > 0 && aliveStreak < 4;) {
-            unsigned randIdx = rand() % m_numPointLights;
-            if (!entityManager.IsEntityAlive(m_pointLights[randIdx].entity)) {
-                DestroyPointLight(randIdx);
-                aliveStreak = 0;
-            } else {
-                aliveStreak++;
+            if (HasPointLight(entity)) {
+                DestroyPointLight(GetPointLightId(entity));
             }
         }
     }
@@ -43,57 +33,46 @@ namespace pge
         if (!m_transformManager->HasTransform(entity)) {
             m_transformManager->CreateTransform(entity);
         }
-        game_DirectionalLightId lid = m_numDirLights++;
-        m_dirLightMap.insert(std::make_pair(entity, lid));
-        m_dirLights[lid]        = light;
-        m_dirLights[lid].entity = entity;
+        game_DirectionalLightId lid = m_dirLights.Insert(entity, light);
+        m_dirLights[lid].entity     = entity;
     }
 
     void
     game_LightManager::DestroyDirectionalLight(const game_DirectionalLightId& id)
     {
-        core_Assert(id < m_numDirLights);
-        game_Entity       entity = m_dirLights[id].entity;
-        game_PointLightId lastId = m_numDirLights - 1;
-        m_dirLightMap.erase(m_dirLightMap.find(entity));
-        if (id != lastId) {
-            m_dirLights[id]           = m_dirLights[lastId];
-            game_Entity lastEntity    = m_dirLights[lastId].entity;
-            m_dirLightMap[lastEntity] = id;
-        }
-        m_numDirLights--;
+        core_Assert(id < m_dirLights.Size());
+        m_dirLights.Remove(id);
     }
 
     bool
     game_LightManager::HasDirectionalLight(const game_Entity& entity) const
     {
-        return m_dirLightMap.find(entity) != m_dirLightMap.end();
+        return m_dirLights.Has(entity);
     }
 
     game_DirectionalLightId
     game_LightManager::GetDirectionalLightId(const game_Entity& entity) const
     {
-        return m_dirLightMap.find(entity)->second;
+        return m_dirLights.GetId(entity);
     }
 
     game_DirectionalLight
     game_LightManager::GetDirectionalLight(const game_DirectionalLightId& id) const
     {
-        core_Assert(id < m_numDirLights);
+        core_Assert(id < m_dirLights.Size());
         return m_dirLights[id];
     }
 
-    const game_DirectionalLight*
-    game_LightManager::GetDirectionalLights(size_t* count) const
+    size_t
+    game_LightManager::GetNumDirectionalLights() const
     {
-        *count = m_numDirLights;
-        return &m_dirLights[0];
+        return m_dirLights.Size();
     }
 
     void
     game_LightManager::SetDirectionalLight(const game_DirectionalLightId& id, const game_DirectionalLight& light)
     {
-        core_Assert(id < m_numDirLights);
+        core_Assert(id < m_dirLights.Size());
         m_dirLights[id] = light;
     }
 
@@ -102,57 +81,46 @@ namespace pge
     game_LightManager::CreatePointLight(const game_Entity& entity, const game_PointLight& light)
     {
         core_Assert(!HasPointLight(entity));
-        game_PointLightId lid = m_numPointLights++;
-        m_pointLightMap.insert(std::make_pair(entity, lid));
-        m_pointLights[lid]        = light;
+        game_PointLightId lid     = m_pointLights.Insert(entity, light);
         m_pointLights[lid].entity = entity;
     }
 
     void
     game_LightManager::DestroyPointLight(const game_PointLightId& id)
     {
-        core_Assert(id < m_numPointLights);
-        game_Entity       entity = m_pointLights[id].entity;
-        game_PointLightId lastId = m_numPointLights - 1;
-        m_pointLightMap.erase(m_pointLightMap.find(entity));
-        if (id != lastId) {
-            m_pointLights[id]           = m_pointLights[lastId];
-            game_Entity lastEntity      = m_pointLights[lastId].entity;
-            m_pointLightMap[lastEntity] = id;
-        }
-        m_numPointLights--;
+        core_Assert(id < m_pointLights.Size());
+        m_pointLights.Remove(id);
     }
 
     bool
     game_LightManager::HasPointLight(const game_Entity& entity) const
     {
-        return m_pointLightMap.find(entity) != m_pointLightMap.end();
+        return m_pointLights.Has(entity);
     }
 
     game_PointLightId
     game_LightManager::GetPointLightId(const game_Entity& entity) const
     {
-        return m_pointLightMap.find(entity)->second;
+        return m_pointLights.GetId(entity);
     }
 
     game_PointLight
     game_LightManager::GetPointLight(const game_PointLightId& id) const
     {
-        core_Assert(id < m_numPointLights);
+        core_Assert(id < m_pointLights.Size());
         return m_pointLights[id];
     }
 
-    const game_PointLight*
-    game_LightManager::GetPointLights(size_t* count) const
+    size_t
+    game_LightManager::GetNumPointLights() const
     {
-        *count = m_numPointLights;
-        return &m_pointLights[0];
+        return m_pointLights.Size();
     }
 
     void
     game_LightManager::SetPointLight(const game_PointLightId& id, const game_PointLight& light)
     {
-        core_Assert(id < m_numPointLights);
+        core_Assert(id < m_pointLights.Size());
         m_pointLights[id] = light;
     }
 
@@ -173,13 +141,14 @@ namespace pge
         game_Entity closestEntity(game_EntityId_Invalid);
         float       closestDepth = std::numeric_limits<float>::max();
 
-        for (size_t i = 0; i < m_numDirLights + m_numPointLights; ++i) {
+        const size_t numDirLights = m_dirLights.Size();
+        for (size_t i = 0; i < numDirLights + m_pointLights.Size(); ++i) {
             game_TransformId tid = game_TransformId_Invalid;
-            if (i < m_numDirLights) {
+            if (i < numDirLights) {
                 const game_DirectionalLight& dlight = m_dirLights[i];
                 tid                                 = m_transformManager->GetTransformId(dlight.entity);
             } else {
-                const game_PointLight& plight = m_pointLights[i - m_numDirLights];
+                const game_PointLight& plight = m_pointLights[i - numDirLights];
                 tid                           = m_transformManager->GetTransformId(plight.entity);
             }
             math_Vec3 worldPos;
@@ -193,7 +162,7 @@ namespace pge
                 continue;
 
             if (math_Raycast_IntersectsViewRect(worldPos, rectSize, cursorNorm, view, proj)) {
-                closestEntity = (i < m_numDirLights) ? m_dirLights[i].entity : m_pointLights[i - m_numDirLights].entity;
+                closestEntity = (i < numDirLights) ? m_dirLights[i].entity : m_pointLights[i - numDirLights].entity;
                 closestDepth  = depth;
             }
         }
@@ -214,13 +183,13 @@ namespace pge
     game_LightManager::SerializeEntity(std::ostream& os, const game_Entity& entity) const
     {
         if (HasPointLight(entity)) {
-            game_PointLightId      pid    = m_pointLightMap.at(entity);
+            game_PointLightId      pid    = m_pointLights.GetId(entity);
             const game_PointLight& plight = m_pointLights[pid];
             os.write((const char*)&SERIALIZE_LIGHT_POINT, sizeof(SERIALIZE_LIGHT_POINT));
             os.write((const char*)&plight.color, sizeof(plight.color));
             os.write((const char*)&plight.radius, sizeof(plight.radius));
         } else if (HasDirectionalLight(entity)) {
-            game_DirectionalLightId      did    = m_dirLightMap.at(entity);
+            game_DirectionalLightId      did    = m_dirLights.GetId(entity);
             const game_DirectionalLight& dlight = m_dirLights[did];
             os.write((const char*)&SERIALIZE_LIGHT_DIRECTIONAL, sizeof(SERIALIZE_LIGHT_DIRECTIONAL));
             os.write((const char*)&dlight.color, sizeof(dlight.color));
@@ -261,10 +230,16 @@ namespace pge
     {
         unsigned version = SERIALIZE_VERSION;
         os.write((const char*)&version, sizeof(version));
-        os.write((const char*)&lm.m_numDirLights, sizeof(lm.m_numDirLights));
-        os.write((const char*)&lm.m_dirLights[0], lm.m_numDirLights * sizeof(game_DirectionalLight));
-        os.write((const char*)&lm.m_numPointLights, sizeof(lm.m_numPointLights));
-        os.write((const char*)&lm.m_pointLights[0], lm.m_numPointLights * sizeof(game_PointLight));
+        size_t numDirLights = lm.m_dirLights.Size();
+        os.write((const char*)&numDirLights, sizeof(numDirLights));
+        for (const game_DirectionalLight& dlight : lm.m_dirLights) {
+            os.write((const char*)&dlight, sizeof(dlight));
+        }
+        size_t numPointLights = lm.m_pointLights.Size();
+        os.write((const char*)&numPointLights, sizeof(numPointLights));
+        for (const game_PointLight& plight : lm.m_pointLights) {
+            os.write((const char*)&plight, sizeof(plight));
+        }
         return os;
     }
 
@@ -273,18 +248,23 @@ namespace pge
     {
         unsigned version = 0;
         is.read((char*)&version, sizeof(version));
-        is.read((char*)&lm.m_numDirLights, sizeof(lm.m_numDirLights));
-        is.read((char*)&lm.m_dirLights[0], lm.m_numDirLights * sizeof(game_DirectionalLight));
-        is.read((char*)&lm.m_numPointLights, sizeof(lm.m_numPointLights));
-        is.read((char*)&lm.m_pointLights[0], lm.m_numPointLights * sizeof(game_PointLight));
-
-        lm.m_dirLightMap.clear();
-        for (game_DirectionalLightId i = 0; i < lm.m_numDirLights; ++i) {
-            lm.m_dirLightMap.insert(std::make_pair(lm.m_dirLights[i].entity, i));
+
+        size_t numDirLights = 0;
+        is.read((char*)&numDirLights, sizeof(numDirLights));
+        lm.m_dirLights.Clear();
+        for (size_t i = 0; i < numDirLights; ++i) {
+            game_DirectionalLight dlight;
+            is.read((char*)&dlight, sizeof(dlight));
+            lm.m_dirLights.Insert(dlight.entity, dlight);
         }
-        lm.m_pointLightMap.clear();
-        for (game_PointLightId i = 0; i < lm.m_numPointLights; ++i) {
-            lm.m_pointLightMap.insert(std::make_pair(lm.m_pointLights[i].entity, i));
+
+        size_t numPointLights = 0;
+        is.read((char*)&numPointLights, sizeof(numPointLights));
+        lm.m_pointLights.Clear();
+        for (size_t i = 0; i < numPointLights; ++i) {
+            game_PointLight plight;
+            is.read((char*)&plight, sizeof(plight));
+            lm.m_pointLights.Insert(plight.entity, plight);
         }
 
         return is;
@@ -1,14 +1,16 @@
 #include "../include/game_mesh.h"
 #include <core_assert.h>
 #include <math_mat4x4.h>
+#include <algorithm>
 
 namespace pge
 {
     game_MeshManager::game_MeshManager(size_t capacity, res_ResourceManager* resources)
-        : m_resources(resources)
-    {
-        m_meshes.reserve(capacity);
-    }
+        : m_meshes(capacity)
+        , m_resources(resources)
+        , m_cullingStats()
+        , m_renderQueueStats()
+    {}
 
     game_MeshId
     game_MeshManager::CreateMesh(const game_Entity& entity)
@@ -20,17 +22,8 @@ namespace pge
     game_MeshManager::CreateMesh(const game_Entity& entity, const res_Mesh* mesh, const res_Material* material)
     {
         core_Assert(!HasMesh(entity));
-        core_Assert(m_meshes.size() < m_meshes.capacity());
-
-        MeshEntity meshEntity;
-        meshEntity.entity   = entity;
-        meshEntity.mesh     = mesh;
-        meshEntity.material = material;
-        m_meshes.push_back(meshEntity);
-
-        game_MeshId meshId = m_meshes.size() - 1;
-        m_entityMap.insert(std::make_pair(entity, meshId));
-        return meshId;
+        m_staleBounds.push_back(entity);
+        return m_meshes.Insert(entity, MeshComponent{mesh, material});
     }
 
     void
@@ -44,33 +37,17 @@ namespace pge
     void
     game_MeshManager::DestroyMesh(const game_MeshId& id)
     {
-        core_Assert(id < m_entityMap.size());
-
-        const game_MeshId& delId  = id;
-        const game_Entity        delEnt = m_meshes[delId].entity;
-
-        const game_MeshId& lastId  = m_entityMap.size() - 1;
-        const game_Entity        lastEnt = m_meshes[lastId].entity;
-
-        if (delId != lastId) {
-            m_meshes[delId]        = m_meshes[lastId];
-            m_meshes[delId].entity = lastEnt;
-            m_entityMap[lastEnt]   = delId;
-        }
-        m_entityMap.erase(delEnt);
-        m_meshes.pop_back();
+        core_Assert(id < m_meshes.Size());
+        m_spatialIndex.Remove(m_meshes.GetEntity(id));
+        m_meshes.Remove(id);
     }
 
     void
     game_MeshManager::GarbageCollect(const game_EntityManager& entityManager)
     {
-        for (size_t aliveStreak = 0; m_meshes.size() > 0 && aliveStreak < 4;) {
-            unsigned randIdx = rand() % m_meshes.size();
-            if (!entityManager.IsEntityAlive(m_meshes[randIdx].entity)) {
-                DestroyMesh(randIdx);
-                aliveStreak = 0;
-            } else {
-                aliveStreak++;
+        for (const game_Entity& entity : entityManager.GetDestroyedEntities()) {
+            if (!entityManager.IsEntityAlive(entity) && HasMesh(entity)) {
+                DestroyMesh(GetMeshId(entity));
             }
         }
     }
@@ -78,48 +55,49 @@ namespace pge
     bool
     game_MeshManager::HasMesh(const game_Entity& entity) const
     {
-        return m_entityMap.find(entity) != m_entityMap.end();
+        return m_meshes.Has(entity);
     }
 
     game_MeshId
     game_MeshManager::GetMeshId(const game_Entity& entity) const
     {
         core_Assert(HasMesh(entity));
-        return m_entityMap.find(entity)->second;
+        return m_meshes.GetId(entity);
     }
 
     void
     game_MeshManager::SetMesh(const game_MeshId& id, const res_Mesh* mesh)
     {
-        core_Assert(id < m_meshes.size());
+        core_Assert(id < m_meshes.Size());
         m_meshes[id].mesh = mesh;
+        m_staleBounds.push_back(m_meshes.GetEntity(id));
     }
 
     void
     game_MeshManager::SetMaterial(const game_MeshId& id, const res_Material* material)
     {
-        core_Assert(id < m_meshes.size());
+        core_Assert(id < m_meshes.Size());
         m_meshes[id].material = material;
     }
 
     game_Entity
     game_MeshManager::GetEntity(const game_MeshId& id) const
     {
-        core_Assert(id < m_meshes.size());
-        return m_meshes[id].entity;
+        core_Assert(id < m_meshes.Size());
+        return m_meshes.GetEntity(id);
     }
 
     const res_Mesh*
     game_MeshManager::GetMesh(const game_MeshId& id) const
     {
-        core_Assert(id < m_meshes.size());
+        core_Assert(id < m_meshes.Size());
         return m_meshes[id].mesh;
     }
 
     const res_Material*
     game_MeshManager::GetMaterial(const game_MeshId& id) const
     {
-        core_Assert(id < m_meshes.size());
+        core_Assert(id < m_meshes.Size());
         return m_meshes[id].material;
     }
 
@@ -130,43 +108,143 @@ namespace pge
                                  const game_EntityManager&    em,
                                  const game_RenderPass&       pass) const
     {
-        for (const auto& mesh : m_meshes) {
-            if (mesh.mesh == nullptr || mesh.material == nullptr || !em.IsEntityAlive(mesh.entity))
+        // Gather the world bounds of everything drawable, then cull them in one batch
+        m_drawCandidates.clear();
+        m_drawModelMatrices.clear();
+        m_drawBounds.clear();
+        for (game_MeshId mid = 0; mid < m_meshes.Size(); ++mid) {
+            const MeshComponent& mesh   = m_meshes[mid];
+            const game_Entity&   entity = m_meshes.GetEntity(mid);
+            if (mesh.mesh == nullptr || mesh.material == nullptr || !em.IsEntityAlive(entity))
                 continue;
 
-            math_Mat4x4 modelMatrix = tm.HasTransform(mesh.entity) ? tm.GetWorldMatrix(tm.GetTransformId(mesh.entity)) : math_Mat4x4();
-            if (am.HasAnimator(mesh.entity)) {
-                renderer->DrawSkeletalMesh(mesh.mesh, mesh.material, modelMatrix, am.GetAnimatedSkeleton(mesh.entity), pass);
+            game_TransformId tid         = tm.FindTransformId(entity);
+            math_Mat4x4      modelMatrix = tid != game_TransformId_Invalid ? tm.GetWorldMatrix(tid) : math_Mat4x4();
+            m_drawCandidates.push_back(mid);
+            m_drawModelMatrices.push_back(modelMatrix);
+            if (am.HasAnimator(entity) && !am.GetSkinningPalette(entity).empty()) {
+                // Skinned meshes can reach past their bind pose, so use the bounds of the pose that is drawn
+                m_drawBounds.push_back(math_TransformAABB(am.GetSkinnedBounds(entity), modelMatrix));
+            } else if (m_spatialIndex.Has(entity)) {
+                // Kept current by UpdateSpatialIndex, which runs before drawing
+                m_drawBounds.push_back(m_spatialIndex.GetBounds(entity));
             } else {
-                renderer->DrawMesh(mesh.mesh, mesh.material, modelMatrix, pass);
+                m_drawBounds.push_back(math_TransformAABB(mesh.mesh->GetAABB(), modelMatrix));
             }
         }
+
+        m_drawVisible.resize(m_drawBounds.size());
+        const math_Frustum frustum    = math_CreateFrustum(renderer->GetCameraViewProjection());
+        const size_t       numVisible = math_Frustum_CullAABBs(frustum, m_drawBounds.data(), m_drawBounds.size(), m_drawVisible.data());
+        m_cullingStats[static_cast<int>(pass)] = game_CullingStats{numVisible, m_drawBounds.size() - numVisible};
+
+        // Queue the visible meshes, so the renderer draws them grouped by the state they bind
+        m_renderQueue.Clear();
+        for (size_t i = 0; i < m_drawCandidates.size(); ++i) {
+            if (!m_drawVisible[i])
+                continue;
+
+            const MeshComponent& mesh        = m_meshes[m_drawCandidates[i]];
+            const game_Entity&   entity      = m_meshes.GetEntity(m_drawCandidates[i]);
+            const math_Mat4x4&   modelMatrix = m_drawModelMatrices[i];
+            const float          depth       = renderer->GetCameraDepth((m_drawBounds[i].min + m_drawBounds[i].max) * 0.5f);
+            if (am.HasAnimator(entity)) {
+                // Skinned meshes are drawn once the animation manager has produced their palette
+                const std::vector<math_Mat4x4>& palette = am.GetSkinningPalette(entity);
+                if (!palette.empty())
+                    m_renderQueue.Submit(renderer->CreateRenderCommand(mesh.mesh, mesh.material, modelMatrix, palette.data(), palette.size(), pass), depth);
+            } else {
+                m_renderQueue.Submit(renderer->CreateRenderCommand(mesh.mesh, mesh.material, modelMatrix, nullptr, 0, pass), depth);
+            }
+        }
+        m_renderQueue.Sort();
+        m_renderQueueStats[static_cast<int>(pass)] = m_renderQueue.GetStats();
+        renderer->DrawQueue(m_renderQueue);
     }
 
-    game_Entity
-    game_MeshManager::RaycastSelect(const game_TransformManager& tm,
-                                    const math_Ray&              ray,
-                                    const math_Mat4x4&           viewProj,
-                                    float*                       distanceOut) const
+    const game_CullingStats&
+    game_MeshManager::GetCullingStats(const game_RenderPass& pass) const
+    {
+        return m_cullingStats[static_cast<int>(pass)];
+    }
+
+    const game_RenderQueueStats&
+    game_MeshManager::GetRenderQueueStats(const game_RenderPass& pass) const
+    {
+        return m_renderQueueStats[static_cast<int>(pass)];
+    }
+
+    void
+    game_MeshManager::UpdateSpatialIndex(game_TransformManager& tm)
     {
-        float             closestDistance = std::numeric_limits<float>::max();
-        game_MeshId closestMesh     = game_MeshId_Invalid;
-        for (const auto& mesh : m_meshes) {
-            if (!tm.HasTransform(mesh.entity))
+        tm.TakeMovedEntities(&m_movedEntities);
+        m_staleBounds.insert(m_staleBounds.end(), m_movedEntities.begin(), m_movedEntities.end());
+        for (const game_Entity& entity : m_staleBounds) {
+            game_MeshId      mid = m_meshes.Find(entity);
+            game_TransformId tid = tm.FindTransformId(entity);
+            if (mid == game_MeshId_Invalid || tid == game_TransformId_Invalid || m_meshes[mid].mesh == nullptr) {
+                m_spatialIndex.Remove(entity);
                 continue;
-            auto aabb      = mesh.mesh->GetAABB();
-            aabb           = math_TransformAABB(aabb, tm.GetWorldMatrix(tm.GetTransformId(mesh.entity)));
+            }
+            m_spatialIndex.Update(entity, math_TransformAABB(m_meshes[mid].mesh->GetAABB(), tm.GetWorldMatrix(tid)));
+        }
+        m_staleBounds.clear();
+    }
+
+    const game_SpatialIndex&
+    game_MeshManager::GetSpatialIndex() const
+    {
+        return m_spatialIndex;
+    }
+
+    game_Entity
+    game_MeshManager::RaycastSelect(const game_TransformManager& tm, const math_Ray& ray, float* distanceOut) const
+    {
+        m_pickEntities.clear();
+        m_pickCandidates.clear();
+        m_spatialIndex.QueryRay(ray, std::numeric_limits<float>::max(), &m_pickEntities);
+        for (const game_Entity& entity : m_pickEntities) {
             float distance = 0;
-            if (math_Raycast_IntersectsAABB(ray, aabb, &distance)) {
-                if (distance < closestDistance) {
-                    closestMesh     = m_entityMap.find(mesh.entity)->second;
-                    closestDistance = distance;
-                }
+            math_Raycast_IntersectsAABB(ray, m_spatialIndex.GetBounds(entity), &distance);
+            m_pickCandidates.push_back(std::make_pair(distance, entity));
+        }
+        std::sort(m_pickCandidates.begin(), m_pickCandidates.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        // A triangle can't be closer than the bounds around it, so stop at the first bounds beyond the closest hit
+        float       closestDistance = std::numeric_limits<float>::max();
+        game_Entity closestEntity   = game_EntityId_Invalid;
+        for (const auto& candidate : m_pickCandidates) {
+            if (candidate.first > closestDistance)
+                break;
+            // The index is only brought up to date by UpdateSpatialIndex, so its entity may have lost its mesh since
+            const game_Entity& entity = candidate.second;
+            const game_MeshId  mid    = m_meshes.Find(entity);
+            if (mid == game_MeshId_Invalid || m_meshes[mid].mesh == nullptr)
+                continue;
+            const res_Mesh*        mesh = m_meshes[mid].mesh;
+            const game_TransformId tid  = tm.FindTransformId(entity);
+            if (tid == game_TransformId_Invalid)
+                continue;
+            if (!mesh->GetBoneOffsetMatrices().empty()) {
+                closestDistance = candidate.first;
+                closestEntity   = entity;
+                continue;
+            }
+
+            // Without normalizing the direction, distances along the local ray equal those along the world ray
+            math_Mat4x4 worldInv;
+            if (!math_Invert(tm.GetWorldMatrix(tid), &worldInv))
+                continue;
+            const math_Ray localRay((worldInv * math_Vec4(ray.origin, 1)).xyz, (worldInv * math_Vec4(ray.direction, 0)).xyz);
+            res_MeshBVHHit hit;
+            if (mesh->GetBVH().Raycast(localRay, closestDistance, &hit)) {
+                closestDistance = hit.distance;
+                closestEntity   = entity;
             }
         }
         if (distanceOut != nullptr)
             *distanceOut = closestDistance;
-        return (closestMesh == game_MeshId_Invalid) ? game_EntityId_Invalid : GetEntity(closestMesh);
+        return closestEntity;
     }
 
 
@@ -175,7 +253,7 @@ namespace pge
     void
     game_MeshManager::SerializeEntity(std::ostream& os, const game_Entity& entity) const
     {
-        game_MeshId mid = m_entityMap.at(entity);
+        game_MeshId mid = m_meshes.GetId(entity);
 
         std::string meshPath    = m_meshes[mid].mesh->GetPath();
         size_t      meshPathLen = meshPath.size();
@@ -195,7 +273,7 @@ namespace pge
         if (!HasMesh(entity)) {
             CreateMesh(entity);
         }
-        game_MeshId mid = m_entityMap.at(entity);
+        game_MeshId mid = m_meshes.GetId(entity);
 
         std::string meshPath;
         size_t      meshPathLen;
@@ -220,11 +298,12 @@ namespace pge
         unsigned version = SERIALIZE_VERSION;
         os.write((const char*)&version, sizeof(version));
 
-        unsigned numMeshes = sm.m_meshes.size();
+        unsigned numMeshes = sm.m_meshes.Size();
         os.write((const char*)&numMeshes, sizeof(numMeshes));
 
-        for (const auto& mesh : sm.m_meshes) {
-            os.write((const char*)&mesh.entity, sizeof(mesh.entity));
+        for (game_MeshId mid = 0; mid < numMeshes; ++mid) {
+            const auto& mesh = sm.m_meshes[mid];
+            os.write((const char*)&sm.m_meshes.GetEntity(mid), sizeof(game_Entity));
 
             auto     meshPath    = mesh.mesh->GetPath();
             unsigned meshPathLen = meshPath.size();
@@ -250,7 +329,9 @@ namespace pge
         bool     iseof     = is.eof();
         is.read((char*)&numMeshes, sizeof(numMeshes));
 
-        sm.m_meshes.resize(numMeshes);
+        sm.m_meshes.Clear();
+        sm.m_spatialIndex.Clear();
+        sm.m_staleBounds.clear();
         for (unsigned i = 0; i < numMeshes; ++i) {
             game_EntityId entityId;
             is.read((char*)&entityId, sizeof(entityId));
@@ -269,14 +350,8 @@ namespace pge
             is.read(matPath, matPathLen);
             matPath[matPathLen] = 0;
 
-            sm.m_meshes[i].entity   = entityId;
-            sm.m_meshes[i].mesh     = sm.m_resources->GetMesh(meshPath);
-            sm.m_meshes[i].material = sm.m_resources->GetMaterial(matPath);
-        }
-
-        sm.m_entityMap.clear();
-        for (size_t i = 0; i < numMeshes; ++i) {
-            sm.m_entityMap.insert(std::make_pair<>(sm.m_meshes[i].entity, game_MeshId(i)));
+            sm.m_meshes.Insert(entityId, game_MeshManager::MeshComponent{sm.m_resources->GetMesh(meshPath), sm.m_resources->GetMaterial(matPath)});
+            sm.m_staleBounds.push_back(entityId);
         }
         return is;
     }
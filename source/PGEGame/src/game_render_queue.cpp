@@ -0,0 +1,206 @@
+#include "../include/game_render_queue.h"
+#include <core_assert.h>
+#include <algorithm>
+
+namespace pge
+{
+    // Bits of each field in the sort key, from the highest down
+    static const unsigned PASS_BITS     = 2;
+    static const unsigned SKINNED_BITS  = 1;
+    static const unsigned EFFECT_BITS   = 10;
+    static const unsigned MATERIAL_BITS = 12;
+    static const unsigned MESH_BITS     = 16;
+    static const unsigned DEPTH_BITS    = 64 - PASS_BITS - SKINNED_BITS - EFFECT_BITS - MATERIAL_BITS - MESH_BITS;
+
+    static const unsigned MESH_SHIFT     = DEPTH_BITS;
+    static const unsigned MATERIAL_SHIFT = MESH_SHIFT + MESH_BITS;
+    static const unsigned EFFECT_SHIFT   = MATERIAL_SHIFT + MATERIAL_BITS;
+    static const unsigned SKINNED_SHIFT  = EFFECT_SHIFT + EFFECT_BITS;
+    static const unsigned PASS_SHIFT     = SKINNED_SHIFT + SKINNED_BITS;
+
+    game_RenderQueue::game_RenderQueue()
+        : m_stats()
+    {}
+
+    uint32_t
+    game_RenderQueue::GetResourceId(ResourceIds* ids, const void* resource, unsigned numBits)
+    {
+        if (resource == nullptr)
+            return 0;
+        auto it = ids->find(resource);
+        if (it != ids->end())
+            return it->second;
+        // Once the ids run out, further resources share the last one. Their draws then sort by depth alone, but state
+        // changes are found by comparing the resources, so they are still drawn correctly.
+        const uint32_t overflowId = (1u << numBits) - 1;
+        const uint32_t id         = static_cast<uint32_t>(ids->size()) + 1;
+        if (id >= overflowId)
+            return overflowId;
+        ids->emplace(resource, id);
+        return id;
+    }
+
+    void
+    game_RenderQueue::RecycleResourceIds(ResourceIds* ids, unsigned numBits)
+    {
+        // The ids of resources that are no longer drawn are only reclaimed all at once, so keys change for a frame
+        if (ids->size() + 1 >= (1u << numBits) - 1)
+            ids->clear();
+    }
+
+    void
+    game_RenderQueue::Clear()
+    {
+        m_commands.clear();
+        m_sorted.clear();
+        m_stateChanges.clear();
+        m_batches.clear();
+        m_stats = game_RenderQueueStats();
+        RecycleResourceIds(&m_effectIds, EFFECT_BITS);
+        RecycleResourceIds(&m_materialIds, MATERIAL_BITS);
+        RecycleResourceIds(&m_meshIds, MESH_BITS);
+    }
+
+    void
+    game_RenderQueue::Submit(const game_RenderCommand& command, float depth)
+    {
+        const uint64_t pass     = static_cast<uint64_t>(command.pass);
+        const uint64_t skinned  = command.palette != nullptr ? 1 : 0;
+        const uint64_t effect   = GetResourceId(&m_effectIds, command.effect, EFFECT_BITS);
+        const uint64_t material = GetResourceId(&m_materialIds, command.material, MATERIAL_BITS);
+        const uint64_t mesh     = GetResourceId(&m_meshIds, command.mesh, MESH_BITS);
+        const float    maxDepth = static_cast<float>((1u << DEPTH_BITS) - 1);
+        const uint64_t depthKey = static_cast<uint64_t>(std::min(std::max(depth, 0.0f), 1.0f) * maxDepth);
+
+        SortItem item;
+        item.key = pass << PASS_SHIFT | skinned << SKINNED_SHIFT | effect << EFFECT_SHIFT | material << MATERIAL_SHIFT
+                   | mesh << MESH_SHIFT | depthKey;
+        item.command = static_cast<uint32_t>(m_commands.size());
+        m_sorted.push_back(item);
+        m_commands.push_back(command);
+    }
+
+    // Least significant byte first, which keeps draws with equal keys in submission order. Bytes that are the same
+    // for every key, like the pass, are skipped.
+    void
+    game_RenderQueue::RadixSort()
+    {
+        const size_t numItems = m_sorted.size();
+        if (numItems < 2)
+            return;
+
+        size_t counts[8][256] = {};
+        for (const SortItem& item : m_sorted) {
+            for (unsigned byte = 0; byte < 8; ++byte)
+                counts[byte][(item.key >> (byte * 8)) & 0xff]++;
+        }
+
+        m_sortScratch.resize(numItems);
+        SortItem* source = m_sorted.data();
+        SortItem* dest   = m_sortScratch.data();
+        for (unsigned byte = 0; byte < 8; ++byte) {
+            const unsigned shift = byte * 8;
+            if (counts[byte][(source[0].key >> shift) & 0xff] == numItems)
+                continue;
+
+            size_t offsets[256];
+            size_t offset = 0;
+            for (unsigned digit = 0; digit < 256; ++digit) {
+                offsets[digit] = offset;
+                offset += counts[byte][digit];
+            }
+            for (size_t i = 0; i < numItems; ++i)
+                dest[offsets[(source[i].key >> shift) & 0xff]++] = source[i];
+            std::swap(source, dest);
+        }
+        if (source != m_sorted.data())
+            m_sorted.swap(m_sortScratch);
+    }
+
+    void
+    game_RenderQueue::Sort()
+    {
+        RadixSort();
+
+        m_stats = game_RenderQueueStats();
+        m_stateChanges.resize(m_sorted.size());
+        m_batches.clear();
+        const game_RenderCommand* previous = nullptr;
+        for (size_t i = 0; i < m_sorted.size(); ++i) {
+            const game_RenderCommand& command = m_commands[m_sorted[i].command];
+            uint8_t                   changes = 0;
+            if (previous == nullptr || previous->pass != command.pass) {
+                changes = game_RenderStateChange_Effect | game_RenderStateChange_Material | game_RenderStateChange_Mesh
+                          | game_RenderStateChange_Skinning;
+            } else {
+                changes |= previous->effect != command.effect ? game_RenderStateChange_Effect : 0;
+                changes |= previous->material != command.material ? game_RenderStateChange_Material : 0;
+                changes |= previous->mesh != command.mesh ? game_RenderStateChange_Mesh : 0;
+                changes |= (previous->palette != nullptr) != (command.palette != nullptr) ? game_RenderStateChange_Skinning : 0;
+            }
+            m_stateChanges[i] = changes;
+
+            // Skinned commands aren't instanced, as each has its own palette
+            game_RenderBatch* batch     = m_batches.empty() ? nullptr : &m_batches.back();
+            const bool        instanced = command.instanced && command.palette == nullptr;
+            if (batch != nullptr && changes == 0 && instanced && previous->instanced && batch->count < MAX_BATCH_SIZE) {
+                batch->count++;
+            } else {
+                m_batches.push_back(game_RenderBatch{i, 1});
+            }
+            previous = &command;
+
+            m_stats.numCommands++;
+            m_stats.numEffectChanges += (changes & game_RenderStateChange_Effect) ? 1 : 0;
+            m_stats.numMaterialChanges += (changes & game_RenderStateChange_Material) ? 1 : 0;
+            m_stats.numMeshChanges += (changes & game_RenderStateChange_Mesh) ? 1 : 0;
+        }
+        m_stats.numBatches = m_batches.size();
+    }
+
+    size_t
+    game_RenderQueue::Size() const
+    {
+        return m_sorted.size();
+    }
+
+    const game_RenderCommand&
+    game_RenderQueue::GetCommand(size_t index) const
+    {
+        core_Assert(index < m_sorted.size());
+        return m_commands[m_sorted[index].command];
+    }
+
+    uint64_t
+    game_RenderQueue::GetKey(size_t index) const
+    {
+        core_Assert(index < m_sorted.size());
+        return m_sorted[index].key;
+    }
+
+    uint8_t
+    game_RenderQueue::GetStateChanges(size_t index) const
+    {
+        core_Assert(index < m_stateChanges.size());
+        return m_stateChanges[index];
+    }
+
+    const game_RenderQueueStats&
+    game_RenderQueue::GetStats() const
+    {
+        return m_stats;
+    }
+
+    size_t
+    game_RenderQueue::GetNumBatches() const
+    {
+        return m_batches.size();
+    }
+
+    const game_RenderBatch&
+    game_RenderQueue::GetBatch(size_t index) const
+    {
+        core_Assert(index < m_batches.size());
+        return m_batches[index];
+    }
+} // namespace pge
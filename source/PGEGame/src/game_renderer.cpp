@@ -1,5 +1,6 @@
 #include "../include/game_renderer.h"
 #include "../include/game_world.h"
+#include <cstring>
 
 namespace pge
 {
@@ -26,6 +27,8 @@ namespace pge
         , m_cbBones(graphicsAdapter, nullptr, sizeof(CBBones), gfx_BufferUsage::DYNAMIC)
         , m_cbLights(graphicsAdapter, nullptr, sizeof(CBLights), gfx_BufferUsage::DYNAMIC)
         , m_cbLightTransforms(graphicsAdapter, nullptr, sizeof(CBLightTransforms), gfx_BufferUsage::DYNAMIC)
+        , m_instanceTransformsData(MAX_INSTANCES)
+        , m_instanceTransforms(graphicsAdapter, nullptr, sizeof(InstanceTransform), MAX_INSTANCES, gfx_BufferUsage::DYNAMIC)
         , m_shadowMap(graphicsAdapter, 2048, 2048, true, true, gfx_PixelFormat::R32_FLOAT)
         , m_viewShadows(graphicsAdapter, 1600, 900, true, true, gfx_PixelFormat::R32G32B32A32_FLOAT)
         , m_depthFX(resources->GetEffect("data/effects/depth.effect"))
@@ -38,7 +41,11 @@ namespace pge
                        sizeof(SCREEN_MESH_VERTICES),
                        SCREEN_MESH_INDICES,
                        sizeof(SCREEN_MESH_INDICES) / sizeof(unsigned))
-    {}
+    {
+        m_instancedFX[m_depthFX]  = resources->GetEffect("data/effects/depth_instanced.effect");
+        m_instancedFX[m_shadowFX] = resources->GetEffect("data/effects/shadow_instanced.effect");
+        m_instancedFX[resources->GetEffect("data/effects/default.effect")] = resources->GetEffect("data/effects/default_instanced.effect");
+    }
 
     void
     game_Renderer::SetCamera(const math_Mat4x4& cameraView, const math_Mat4x4& cameraProj)
@@ -47,6 +54,12 @@ namespace pge
         m_cameraProj = cameraProj;
     }
 
+    math_Mat4x4
+    game_Renderer::GetCameraViewProjection() const
+    {
+        return m_cameraProj * m_cameraView;
+    }
+
     void
     game_Renderer::UpdateLights(const game_LightManager&     lmanager,
                                 const game_TransformManager& tmanager,
@@ -56,17 +69,17 @@ namespace pge
     {
         // Update directional lights
         {
-            size_t                       dirCount = 0;
-            const game_DirectionalLight* dlights  = lmanager.GetDirectionalLights(&dirCount);
+            const size_t dirCount = lmanager.GetNumDirectionalLights();
             for (size_t i = 0; i < dirCount; ++i) {
-                auto& dlight = m_cbLightsData.dirLights[i];
-                if (!emanager.IsEntityAlive(dlights[i].entity)) {
+                const game_DirectionalLight light  = lmanager.GetDirectionalLight(i);
+                auto&                       dlight = m_cbLightsData.dirLights[i];
+                if (!emanager.IsEntityAlive(light.entity)) {
                     continue;
                 }
-                game_TransformId tid      = tmanager.GetTransformId(dlights[i].entity);
+                game_TransformId tid      = tmanager.GetTransformId(light.entity);
                 math_Quat        rotation = tid == game_TransformId_Invalid ? math_Quat() : tmanager.GetLocalRotation(tid);
-                dlight.direction          = m_cameraView * math_Rotate(math_Vec4(dlights[i].direction, 0), rotation);
-                dlight.color              = math_Vec4(dlights[i].color, dlights[i].strength);
+                dlight.direction          = m_cameraView * math_Rotate(math_Vec4(light.direction, 0), rotation);
+                dlight.color              = math_Vec4(light.color, light.strength);
 
                 // TODO: Per-light
                 // Shadow map
@@ -119,20 +132,20 @@ namespace pge
 
         // Update point lights
         {
-            size_t                 pointCount = 0;
-            const game_PointLight* plights    = lmanager.GetPointLights(&pointCount);
+            const size_t pointCount = lmanager.GetNumPointLights();
             for (size_t i = 0; i < pointCount; ++i) {
-                auto& plight = m_cbLightsData.pointLights[i];
-                if (!emanager.IsEntityAlive(plights[i].entity)) {
+                const game_PointLight light  = lmanager.GetPointLight(i);
+                auto&                 plight = m_cbLightsData.pointLights[i];
+                if (!emanager.IsEntityAlive(light.entity)) {
                     plight.position = math_Vec4::Zero();
                     plight.color    = math_Vec3::Zero();
                     plight.radius   = 0;
                     continue;
                 }
-                game_TransformId tid = tmanager.GetTransformId(plights[i].entity);
+                game_TransformId tid = tmanager.GetTransformId(light.entity);
                 plight.position = m_cameraView * math_Vec4((tid == game_TransformId_Invalid) ? math_Vec3::Zero() : tmanager.GetWorldPosition(tid), 1);
-                plight.color    = plights[i].color;
-                plight.radius   = plights[i].radius;
+                plight.color    = light.color;
+                plight.radius   = light.radius;
             }
             for (size_t i = pointCount; i < MAX_POINTLIGHTS; ++i) {
                 auto& plight    = m_cbLightsData.pointLights[i];
@@ -233,7 +246,8 @@ namespace pge
     game_Renderer::DrawSkeletalMesh(const res_Mesh*        mesh,
                                     const res_Material*    material,
                                     const math_Mat4x4&     modelMatrix,
-                                    const anim_Skeleton&   skeleton,
+                                    const math_Mat4x4*     palette,
+                                    size_t                 numBones,
                                     const game_RenderPass& pass)
     {
         core_Assert(mesh != nullptr && material != nullptr);
@@ -245,11 +259,8 @@ namespace pge
         math_Transpose(m_cbTransformData.normalMatrix);
         m_cbTransform.Update(&m_cbTransformData, sizeof(CBTransform));
 
-        const auto& boneOffsetMatrices = mesh->GetBoneOffsetMatrices();
-        unsigned    numBones           = skeleton.GetBoneCount();
-        for (unsigned i = 0; i < numBones; ++i) {
-            m_cbBonesData.bones[i] = skeleton.GetBone(i).worldTransform * boneOffsetMatrices[i];
-        }
+        core_Assert(numBones <= MAX_BONES);
+        memcpy(m_cbBonesData.bones, palette, numBones * sizeof(math_Mat4x4));
         m_cbBones.Update(&m_cbBonesData, sizeof(CBBones));
 
         m_cbTransform.BindVS(0);
@@ -262,6 +273,132 @@ namespace pge
         m_graphicsDevice->DrawIndexed(gfx_PrimitiveType::TRIANGLELIST, 0, mesh->GetNumTriangles() * 3);
     }
 
+    game_RenderCommand
+    game_Renderer::CreateRenderCommand(const res_Mesh*        mesh,
+                                       const res_Material*    material,
+                                       const math_Mat4x4&     modelMatrix,
+                                       const math_Mat4x4*     palette,
+                                       size_t                 numBones,
+                                       const game_RenderPass& pass) const
+    {
+        core_Assert(mesh != nullptr && material != nullptr);
+        game_RenderCommand command;
+        command.pass        = pass;
+        command.effect      = material->GetEffect();
+        command.material    = material;
+        command.mesh        = mesh;
+        command.modelMatrix = modelMatrix;
+        command.palette     = palette;
+        command.numBones    = numBones;
+        command.instanced   = false;
+        if (palette == nullptr) {
+            // As DrawMesh: the depth pass doesn't use the material, the shadow pass only for its shadow map slot
+            if (pass == game_RenderPass::DEPTH) {
+                command.effect   = m_depthFX;
+                command.material = nullptr;
+            } else if (pass == game_RenderPass::SHADOW) {
+                command.effect = m_shadowFX;
+            }
+            command.instanced = m_instancedFX.find(command.effect) != m_instancedFX.end();
+        }
+        return command;
+    }
+
+    float
+    game_Renderer::GetCameraDepth(const math_Vec3& worldPosition) const
+    {
+        const math_Vec4 clip = m_cameraProj * (m_cameraView * math_Vec4(worldPosition, 1));
+        return clip.w != 0 ? clip.z / clip.w : 0.0f;
+    }
+
+    void
+    game_Renderer::DrawQueue(const game_RenderQueue& queue)
+    {
+        // Instanced draws only take the view and projection from here
+        m_cbTransformData.viewMatrix = m_cameraView;
+        m_cbTransformData.projMatrix = m_cameraProj;
+        m_cbTransform.Update(&m_cbTransformData, sizeof(CBTransform));
+        m_cbTransform.BindVS(0);
+        m_cbLights.BindPS(1);
+        m_instanceTransforms.BindVS(0);
+
+        const res_Effect* boundEffect   = nullptr;
+        int               shadowMapSlot = -1; // Where the shadow map is bound, if anywhere
+        for (size_t b = 0; b < queue.GetNumBatches(); ++b) {
+            const game_RenderBatch&   batch   = queue.GetBatch(b);
+            const game_RenderCommand& command = queue.GetCommand(batch.first);
+            const uint8_t             changes = queue.GetStateChanges(batch.first);
+            const bool                skinned = command.palette != nullptr;
+
+            if (batch.count == 1) {
+                m_cbTransformData.modelMatrix = command.modelMatrix;
+                core_Verify(math_Invert(command.modelMatrix, &m_cbTransformData.normalMatrix));
+                math_Transpose(m_cbTransformData.normalMatrix);
+                m_cbTransform.Update(&m_cbTransformData, sizeof(CBTransform));
+            } else {
+                for (size_t i = 0; i < batch.count; ++i) {
+                    InstanceTransform& instance = m_instanceTransformsData[i];
+                    instance.modelMatrix        = queue.GetCommand(batch.first + i).modelMatrix;
+                    core_Verify(math_Invert(instance.modelMatrix, &instance.normalMatrix));
+                    math_Transpose(instance.normalMatrix);
+                }
+                m_instanceTransforms.Update(m_instanceTransformsData.data(), batch.count);
+            }
+
+            // Skinned meshes take the bones where static ones take the light transforms, and no shadow map
+            if (skinned) {
+                core_Assert(command.numBones <= MAX_BONES);
+                memcpy(m_cbBonesData.bones, command.palette, command.numBones * sizeof(math_Mat4x4));
+                m_cbBones.Update(&m_cbBonesData, sizeof(CBBones));
+                if (changes & game_RenderStateChange_Skinning) {
+                    m_cbBones.BindVS(1);
+                    if (shadowMapSlot >= 0)
+                        gfx_Texture2D_Unbind(m_graphicsAdapter, shadowMapSlot);
+                    shadowMapSlot = -1;
+                }
+            } else if (command.pass != game_RenderPass::DEPTH && (changes & game_RenderStateChange_Skinning)) {
+                m_cbLightTransforms.BindVS(1);
+            }
+
+            if (changes & game_RenderStateChange_Mesh)
+                command.mesh->Bind();
+
+            // Binding a material binds its effect as well (and it may replace the shadow map). Batches replace the
+            // effect by its instanced variant.
+            const bool bindsMaterial = skinned || command.pass == game_RenderPass::LIGHTING;
+            if (bindsMaterial && (changes & (game_RenderStateChange_Effect | game_RenderStateChange_Material))) {
+                command.material->Bind();
+                boundEffect = command.material->GetEffect();
+            }
+            const res_Effect* effect = batch.count > 1 ? m_instancedFX.at(command.effect) : command.effect;
+            if (effect != boundEffect) {
+                effect->Bind();
+                boundEffect = effect;
+            }
+
+            if (!skinned && command.pass != game_RenderPass::DEPTH) {
+                const int slot = static_cast<int>(command.material->GetEffect()->GetTextureSlot("ShadowMap"));
+                if (slot != shadowMapSlot || (changes & game_RenderStateChange_Material)) {
+                    if (shadowMapSlot >= 0 && shadowMapSlot != slot)
+                        gfx_Texture2D_Unbind(m_graphicsAdapter, shadowMapSlot);
+                    m_shadowMap.BindTexture(slot);
+                    shadowMapSlot = slot;
+                }
+            }
+
+            if (batch.count == 1) {
+                m_graphicsDevice->DrawIndexed(gfx_PrimitiveType::TRIANGLELIST, 0, command.mesh->GetNumTriangles() * 3);
+            } else {
+                m_graphicsDevice->DrawIndexedInstanced(gfx_PrimitiveType::TRIANGLELIST,
+                                                       0,
+                                                       command.mesh->GetNumTriangles() * 3,
+                                                       static_cast<unsigned>(batch.count));
+            }
+        }
+        if (shadowMapSlot >= 0)
+            gfx_Texture2D_Unbind(m_graphicsAdapter, shadowMapSlot);
+    }
+
     void
     game_Renderer::DrawRenderToView(const gfx_RenderTarget* rt, const res_Effect* effect)
     {
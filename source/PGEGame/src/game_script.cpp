@@ -3,6 +3,7 @@
 #include <core_assert.h>
 #include <input_keyboard.h>
 #include <iostream>
+#include <unordered_map>
 
 namespace pge
 {
@@ -69,13 +70,27 @@ namespace pge
     // game_ScriptManager
     // ==================================================
     struct game_ScriptManager::ScriptAPIImpl {
-        lua_State* luaState;
+        lua_State*                                   luaState;
+        std::unordered_map<std::string, std::string> chunkCache; // Compiled bytecode per script path
     };
 
+    static void
+    LuaErrorReport(lua_State* state)
+    {
+        core_LogErrorf("LUA Error: %s", lua_tostring(state, -1));
+        lua_pop(state, 1);
+    }
+
+    static int
+    LuaChunkWriter(lua_State* state, const void* data, size_t size, void* userData)
+    {
+        static_cast<std::string*>(userData)->append(static_cast<const char*>(data), size);
+        return 0;
+    }
+
     game_ScriptManager::game_ScriptManager(size_t capacity)
         : m_apiImpl(new ScriptAPIImpl)
-        , m_scripts(new ScriptComponent[capacity])
-        , m_numScripts(0)
+        , m_scripts(capacity)
     {
         m_apiImpl->luaState = luaL_newstate();
         core_Assert(m_apiImpl->luaState != nullptr);
@@ -93,13 +108,9 @@ namespace pge
     void
     game_ScriptManager::GarbageCollect(const game_EntityManager& entityManager)
     {
-        for (size_t aliveStreak = 0; m_numScripts > 0 && aliveStreak < 4;) {
-            unsigned randIdx = rand() % m_numScripts;
-            if (!entityManager.IsEntityAlive(m_scripts[randIdx].entity)) {
-                DestroyScript(randIdx);
-                aliveStreak = 0;
-            } else {
-                aliveStreak++;
+        for (const game_Entity& entity : entityManager.GetDestroyedEntities()) {
+            if (!entityManager.IsEntityAlive(entity) && HasScript(entity)) {
+                DestroyScript(GetScriptId(entity));
             }
         }
     }
@@ -108,89 +119,152 @@ namespace pge
     game_ScriptManager::CreateScript(const game_Entity& entity, const char* path)
     {
         core_Assert(!HasScript(entity));
-        game_ScriptId lid = m_numScripts++;
-        m_entityMap.insert(std::make_pair(entity, lid));
-        m_scripts[lid].entity = entity;
-        m_scripts[lid].path   = path;
+        // An older generation of the entity that wasn't garbage collected yet loses its script
+        game_ScriptId staleId = m_scripts.FindAnyGeneration(entity);
+        if (staleId != game_ComponentPool<ScriptComponent>::InvalidId)
+            DestroyScript(staleId);
+
+        game_ScriptId lid   = m_scripts.Insert(entity);
+        m_scripts[lid].path = path;
+        LoadScript(&m_scripts[lid]);
     }
 
     bool
     game_ScriptManager::HasScript(const game_Entity& entity) const
     {
-        return m_entityMap.find(entity) != m_entityMap.end();
+        return m_scripts.Has(entity);
     }
 
     game_ScriptId
     game_ScriptManager::GetScriptId(const game_Entity& entity) const
     {
         core_Assert(HasScript(entity));
-        return m_entityMap.at(entity);
+        return m_scripts.GetId(entity);
     }
 
     const char*
     game_ScriptManager::GetScriptPath(const game_ScriptId& id) const
     {
-        core_Assert(id < m_numScripts);
+        core_Assert(id < m_scripts.Size());
         return m_scripts[id].path.c_str();
     }
 
     void
     game_ScriptManager::SetScript(const game_ScriptId& id, const char* path)
     {
-        core_Assert(id < m_numScripts);
+        core_Assert(id < m_scripts.Size());
+        UnloadScript(&m_scripts[id]);
         m_scripts[id].path = path;
+        LoadScript(&m_scripts[id]);
     }
 
     void
     game_ScriptManager::DestroyScript(const game_ScriptId& id)
     {
-        core_Assert(id < m_numScripts);
-        game_Entity   entity = m_scripts[id].entity;
-        game_ScriptId lastId = m_numScripts - 1;
-        m_entityMap.erase(m_entityMap.find(entity));
-        if (id != lastId) {
-            m_scripts[id]           = m_scripts[lastId];
-            game_Entity lastEntity  = m_scripts[lastId].entity;
-            m_entityMap[lastEntity] = id;
-        }
-        m_numScripts--;
+        core_Assert(id < m_scripts.Size());
+        UnloadScript(&m_scripts[id]);
+        m_scripts.Remove(id);
     }
 
     void
-    LuaErrorReport(lua_State* state)
+    game_ScriptManager::ReloadScript(const char* path)
     {
-        core_LogErrorf("LUA Error: %s", lua_tostring(state, 1));
-        lua_pop(state, 1);
+        m_apiImpl->chunkCache.erase(path);
+        for (size_t i = 0; i < m_scripts.Size(); ++i) {
+            ScriptComponent& script = m_scripts[i];
+            if (script.path == path) {
+                UnloadScript(&script);
+                LoadScript(&script);
+            }
+        }
     }
 
     void
     game_ScriptManager::UpdateScripts()
     {
-        for (size_t i = 0; i < m_numScripts; ++i) {
+        lua_State*   L  = m_apiImpl->luaState;
+        const double dt = 1.0 / 60.0;
+        for (size_t i = 0; i < m_scripts.Size(); ++i) {
             const ScriptComponent& script = m_scripts[i];
+            if (script.updateRef == LUA_NOREF)
+                continue;
 
-            lua_State* L = luaL_newstate(); // m_apiImpl->luaState;
-            luaL_openlibs(L);
-            lua_getglobal(L, "_G");
-            luaL_setfuncs(L, SCRIPT_API_FUNCTIONS, 0);
-            lua_pop(L, 1);
-
-            luaL_dofile(L, script.path.c_str());
-            lua_getglobal(L, "onUpdate");
-            double dt = 1.0 / 60.0;
+            lua_rawgeti(L, LUA_REGISTRYINDEX, script.updateRef);
             lua_pushnumber(L, dt);
             int error = lua_pcall(L, 1, 0, 0);
             if (error != LUA_OK) {
                 LuaErrorReport(L);
             }
-            lua_close(L);
         }
     }
 
+    void
+    game_ScriptManager::LoadScript(ScriptComponent* script)
+    {
+        lua_State* L      = m_apiImpl->luaState;
+        script->envRef    = LUA_NOREF;
+        script->updateRef = LUA_NOREF;
+        if (script->path.empty())
+            return;
+
+        // Compile every script file only once; other instances are created from the cached bytecode.
+        auto chunkIt = m_apiImpl->chunkCache.find(script->path);
+        if (chunkIt == m_apiImpl->chunkCache.end()) {
+            if (luaL_loadfile(L, script->path.c_str()) != LUA_OK) {
+                LuaErrorReport(L);
+                return;
+            }
+            std::string bytecode;
+            lua_dump(L, LuaChunkWriter, &bytecode, 0);
+            lua_pop(L, 1);
+            chunkIt = m_apiImpl->chunkCache.emplace(script->path, std::move(bytecode)).first;
+        }
+        const std::string& bytecode = chunkIt->second;
+        if (luaL_loadbufferx(L, bytecode.data(), bytecode.size(), script->path.c_str(), "b") != LUA_OK) {
+            LuaErrorReport(L);
+            return;
+        }
+
+        // Give the chunk its own environment (falling back on the globals), so that scripts sharing a file don't share state.
+        lua_newtable(L);
+        lua_newtable(L);
+        lua_pushglobaltable(L);
+        lua_setfield(L, -2, "__index");
+        lua_setmetatable(L, -2);
+        lua_pushvalue(L, -1);
+        lua_setupvalue(L, -3, 1); // The first upvalue of a main chunk is its _ENV
+        script->envRef = luaL_ref(L, LUA_REGISTRYINDEX);
+
+        if (lua_pcall(L, 0, 0, 0) != LUA_OK) {
+            LuaErrorReport(L);
+            return;
+        }
+
+        lua_rawgeti(L, LUA_REGISTRYINDEX, script->envRef);
+        lua_pushliteral(L, "onUpdate");
+        lua_rawget(L, -2);
+        if (lua_isfunction(L, -1)) {
+            script->updateRef = luaL_ref(L, LUA_REGISTRYINDEX);
+        } else {
+            lua_pop(L, 1);
+        }
+        lua_pop(L, 1);
+    }
+
+    void
+    game_ScriptManager::UnloadScript(ScriptComponent* script)
+    {
+        lua_State* L = m_apiImpl->luaState;
+        luaL_unref(L, LUA_REGISTRYINDEX, script->updateRef);
+        luaL_unref(L, LUA_REGISTRYINDEX, script->envRef);
+        script->envRef    = LUA_NOREF;
+        script->updateRef = LUA_NOREF;
+    }
+
     void
     game_ScriptManager::SerializeEntity(std::ostream& os, const game_Entity& entity) const
     {
-        game_ScriptId sid = m_entityMap.at(entity);
+        game_ScriptId sid = m_scripts.GetId(entity);
         const ScriptComponent& script = m_scripts[sid];
         size_t pathSz = script.path.size();
         os.write((const char*)&pathSz, sizeof(pathSz));
@@ -0,0 +1,360 @@
+#include "../include/game_spatial_index.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+
+namespace pge
+{
+    static const int    CELL_COORD_LIMIT   = (1 << 20) - 1; // Cell coordinates are packed in 21 bits each
+    static const size_t MAX_CELLS_PER_ITEM = 64;
+
+    static uint64_t
+    CellKey(int x, int y, int z)
+    {
+        const uint64_t offset = 1 << 20;
+        return (uint64_t(x + offset) << 42) | (uint64_t(y + offset) << 21) | uint64_t(z + offset);
+    }
+
+    static size_t
+    CellCount(const int* min, const int* max)
+    {
+        size_t count = 1;
+        for (int axis = 0; axis < 3; ++axis)
+            count *= size_t(max[axis] - min[axis] + 1);
+        return count;
+    }
+
+    game_SpatialIndex::game_SpatialIndex(float cellSize)
+        : m_cellSize(cellSize)
+        , m_queryStamp(0)
+    {
+        core_Assert(cellSize > 0);
+        Clear();
+    }
+
+    void
+    game_SpatialIndex::Clear()
+    {
+        m_items.Clear();
+        m_cells.clear();
+        m_oversized.clear();
+        for (int axis = 0; axis < 3; ++axis) {
+            m_occupied.min[axis] = INT_MAX;
+            m_occupied.max[axis] = INT_MIN;
+        }
+    }
+
+    size_t
+    game_SpatialIndex::Size() const
+    {
+        return m_items.Size();
+    }
+
+    game_SpatialIndex::CellRange
+    game_SpatialIndex::GetCellRange(const math_AABB& bounds) const
+    {
+        CellRange range;
+        for (int axis = 0; axis < 3; ++axis) {
+            float min       = std::floor(bounds.min[axis] / m_cellSize);
+            float max       = std::floor(bounds.max[axis] / m_cellSize);
+            range.min[axis] = static_cast<int>(std::min(std::max(min, float(-CELL_COORD_LIMIT)), float(CELL_COORD_LIMIT)));
+            range.max[axis] = static_cast<int>(std::min(std::max(max, float(-CELL_COORD_LIMIT)), float(CELL_COORD_LIMIT)));
+        }
+        return range;
+    }
+
+    void
+    game_SpatialIndex::Link(const game_Entity& entity, const Item& item)
+    {
+        if (item.oversized) {
+            m_oversized.push_back(entity);
+            return;
+        }
+        for (int x = item.cells.min[0]; x <= item.cells.max[0]; ++x) {
+            for (int y = item.cells.min[1]; y <= item.cells.max[1]; ++y) {
+                for (int z = item.cells.min[2]; z <= item.cells.max[2]; ++z)
+                    m_cells[CellKey(x, y, z)].push_back(entity);
+            }
+        }
+        for (int axis = 0; axis < 3; ++axis) {
+            m_occupied.min[axis] = std::min(m_occupied.min[axis], item.cells.min[axis]);
+            m_occupied.max[axis] = std::max(m_occupied.max[axis], item.cells.max[axis]);
+        }
+    }
+
+    void
+    game_SpatialIndex::Unlink(const game_Entity& entity, const Item& item)
+    {
+        auto removeFrom = [&entity](Cell* entities) {
+            auto it = std::find(entities->begin(), entities->end(), entity);
+            core_Assert(it != entities->end());
+            *it = entities->back();
+            entities->pop_back();
+        };
+
+        if (item.oversized) {
+            removeFrom(&m_oversized);
+            return;
+        }
+        for (int x = item.cells.min[0]; x <= item.cells.max[0]; ++x) {
+            for (int y = item.cells.min[1]; y <= item.cells.max[1]; ++y) {
+                for (int z = item.cells.min[2]; z <= item.cells.max[2]; ++z) {
+                    auto cell = m_cells.find(CellKey(x, y, z));
+                    core_Assert(cell != m_cells.end());
+                    removeFrom(&cell->second);
+                    if (cell->second.empty())
+                        m_cells.erase(cell);
+                }
+            }
+        }
+    }
+
+    void
+    game_SpatialIndex::Update(const game_Entity& entity, const math_AABB& bounds)
+    {
+        Item item;
+        item.bounds     = bounds;
+        item.cells      = GetCellRange(bounds);
+        item.oversized  = CellCount(item.cells.min, item.cells.max) > MAX_CELLS_PER_ITEM;
+        item.queryStamp = m_queryStamp;
+
+        unsigned id = m_items.Find(entity);
+        if (id == game_ComponentPool<Item>::InvalidId) {
+            // An older generation of the entity that wasn't removed yet leaves its cells
+            unsigned staleId = m_items.FindAnyGeneration(entity);
+            if (staleId != game_ComponentPool<Item>::InvalidId)
+                Unlink(m_items.GetEntity(staleId), m_items[staleId]);
+            m_items.Insert(entity, item);
+            Link(entity, item);
+            return;
+        }
+
+        // Most moves stay within the same cells
+        Item& current = m_items[id];
+        if (current.oversized == item.oversized && std::equal(current.cells.min, current.cells.min + 3, item.cells.min)
+            && std::equal(current.cells.max, current.cells.max + 3, item.cells.max)) {
+            current.bounds = bounds;
+            return;
+        }
+        Unlink(entity, current);
+        current = item;
+        Link(entity, current);
+    }
+
+    void
+    game_SpatialIndex::Remove(const game_Entity& entity)
+    {
+        unsigned id = m_items.Find(entity);
+        if (id == game_EntitySparseSet::InvalidId)
+            return;
+        Unlink(entity, m_items[id]);
+        m_items.Remove(id);
+    }
+
+    bool
+    game_SpatialIndex::Has(const game_Entity& entity) const
+    {
+        return m_items.Has(entity);
+    }
+
+    const math_AABB&
+    game_SpatialIndex::GetBounds(const game_Entity& entity) const
+    {
+        return m_items[m_items.GetId(entity)].bounds;
+    }
+
+    void
+    game_SpatialIndex::BeginQuery() const
+    {
+        if (++m_queryStamp == 0) {
+            // Wrapped around; forget every stamp, so no item looks tested already
+            for (unsigned id = 0; id < m_items.Size(); ++id)
+                m_items[id].queryStamp = 0;
+            m_queryStamp = 1;
+        }
+    }
+
+    bool
+    game_SpatialIndex::Visit(const game_Entity& entity) const
+    {
+        const Item& item = m_items[m_items.GetId(entity)];
+        if (item.queryStamp == m_queryStamp)
+            return false;
+        item.queryStamp = m_queryStamp;
+        return true;
+    }
+
+    template <typename Test>
+    void
+    game_SpatialIndex::VisitCells(const CellRange& range, const Test& test, std::vector<game_Entity>* result) const
+    {
+        BeginQuery();
+        auto visitEntities = [&](const Cell& entities) {
+            for (const game_Entity& entity : entities) {
+                if (Visit(entity) && test(m_items[m_items.GetId(entity)].bounds))
+                    result->push_back(entity);
+            }
+        };
+        visitEntities(m_oversized);
+
+        CellRange clipped;
+        for (int axis = 0; axis < 3; ++axis) {
+            clipped.min[axis] = std::max(range.min[axis], m_occupied.min[axis]);
+            clipped.max[axis] = std::min(range.max[axis], m_occupied.max[axis]);
+            if (clipped.min[axis] > clipped.max[axis])
+                return;
+        }
+
+        // A range larger than the number of cells in use is cheaper to test cell by cell
+        if (CellCount(clipped.min, clipped.max) > m_cells.size()) {
+            for (const auto& cell : m_cells)
+                visitEntities(cell.second);
+            return;
+        }
+        for (int x = clipped.min[0]; x <= clipped.max[0]; ++x) {
+            for (int y = clipped.min[1]; y <= clipped.max[1]; ++y) {
+                for (int z = clipped.min[2]; z <= clipped.max[2]; ++z) {
+                    auto cell = m_cells.find(CellKey(x, y, z));
+                    if (cell != m_cells.end())
+                        visitEntities(cell->second);
+                }
+            }
+        }
+    }
+
+    template <typename OnCell>
+    void
+    game_SpatialIndex::WalkRay(const math_Ray& ray, float maxDistance, const OnCell& onCell) const
+    {
+        if (m_occupied.min[0] > m_occupied.max[0])
+            return;
+
+        // Clip the ray to the occupied cells, so it never walks empty space around them
+        float enter = 0, exit = maxDistance;
+        for (int axis = 0; axis < 3; ++axis) {
+            float min = m_occupied.min[axis] * m_cellSize;
+            float max = (m_occupied.max[axis] + 1) * m_cellSize;
+            if (ray.direction[axis] == 0) {
+                if (ray.origin[axis] < min || ray.origin[axis] > max)
+                    return;
+                continue;
+            }
+            float t0 = (min - ray.origin[axis]) / ray.direction[axis];
+            float t1 = (max - ray.origin[axis]) / ray.direction[axis];
+            enter    = std::max(enter, std::min(t0, t1));
+            exit     = std::min(exit, std::max(t0, t1));
+        }
+        if (enter > exit)
+            return;
+
+        // Amanatides-Woo traversal, starting in the cell where the ray enters
+        int   cell[3], step[3];
+        float nextBoundary[3], delta[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            float start = ray.origin[axis] + ray.direction[axis] * enter;
+            cell[axis]  = static_cast<int>(std::floor(start / m_cellSize));
+            cell[axis]  = std::min(std::max(cell[axis], m_occupied.min[axis]), m_occupied.max[axis]);
+            if (ray.direction[axis] == 0) {
+                step[axis]         = 0;
+                nextBoundary[axis] = FLT_MAX;
+                delta[axis]        = FLT_MAX;
+                continue;
+            }
+            step[axis]         = ray.direction[axis] > 0 ? 1 : -1;
+            float boundary     = (cell[axis] + (step[axis] > 0 ? 1 : 0)) * m_cellSize;
+            nextBoundary[axis] = (boundary - ray.origin[axis]) / ray.direction[axis];
+            delta[axis]        = m_cellSize / std::fabs(ray.direction[axis]);
+        }
+
+        for (;;) {
+            int   axis     = nextBoundary[0] < nextBoundary[1] ? (nextBoundary[0] < nextBoundary[2] ? 0 : 2) : (nextBoundary[1] < nextBoundary[2] ? 1 : 2);
+            float cellExit = nextBoundary[axis];
+
+            auto found = m_cells.find(CellKey(cell[0], cell[1], cell[2]));
+            if (!onCell(found != m_cells.end() ? &found->second : nullptr, cellExit))
+                return;
+            if (cellExit > exit)
+                return;
+
+            cell[axis] += step[axis];
+            if (cell[axis] < m_occupied.min[axis] || cell[axis] > m_occupied.max[axis])
+                return;
+            nextBoundary[axis] += delta[axis];
+        }
+    }
+
+    game_Entity
+    game_SpatialIndex::Raycast(const math_Ray& ray, float* distanceOut) const
+    {
+        BeginQuery();
+        float       closestDistance = FLT_MAX;
+        game_Entity closestEntity   = game_EntityId_Invalid;
+        auto        testEntities    = [&](const Cell& entities) {
+            for (const game_Entity& entity : entities) {
+                float distance = 0;
+                if (Visit(entity) && math_Raycast_IntersectsAABB(ray, GetBounds(entity), &distance) && distance < closestDistance) {
+                    closestDistance = distance;
+                    closestEntity   = entity;
+                }
+            }
+        };
+        testEntities(m_oversized);
+
+        // Hits in later cells can't be closer than one before the current cell's exit
+        WalkRay(ray, FLT_MAX, [&](const Cell* entities, float cellExit) {
+            if (entities != nullptr)
+                testEntities(*entities);
+            return closestDistance > cellExit;
+        });
+
+        if (distanceOut != nullptr)
+            *distanceOut = closestDistance;
+        return closestEntity;
+    }
+
+    void
+    game_SpatialIndex::QueryRay(const math_Ray& ray, float maxDistance, std::vector<game_Entity>* result) const
+    {
+        BeginQuery();
+        auto testEntities = [&](const Cell& entities) {
+            for (const game_Entity& entity : entities) {
+                float distance = 0;
+                if (Visit(entity) && math_Raycast_IntersectsAABB(ray, GetBounds(entity), &distance) && distance <= maxDistance)
+                    result->push_back(entity);
+            }
+        };
+        testEntities(m_oversized);
+        WalkRay(ray, maxDistance, [&](const Cell* entities, float) {
+            if (entities != nullptr)
+                testEntities(*entities);
+            return true;
+        });
+    }
+
+    void
+    game_SpatialIndex::QueryAABB(const math_AABB& box, std::vector<game_Entity>* result) const
+    {
+        auto overlaps = [&box](const math_AABB& bounds) {
+            return bounds.min.x <= box.max.x && bounds.max.x >= box.min.x && bounds.min.y <= box.max.y && bounds.max.y >= box.min.y
+                   && bounds.min.z <= box.max.z && bounds.max.z >= box.min.z;
+        };
+        VisitCells(GetCellRange(box), overlaps, result);
+    }
+
+    void
+    game_SpatialIndex::QuerySphere(const math_Vec3& center, float radius, std::vector<game_Entity>* result) const
+    {
+        auto overlaps = [&center, radius](const math_AABB& bounds) {
+            float distanceSquared = 0;
+            for (int axis = 0; axis < 3; ++axis) {
+                float closest = std::min(std::max(center[axis], bounds.min[axis]), bounds.max[axis]);
+                distanceSquared += (center[axis] - closest) * (center[axis] - closest);
+            }
+            return distanceSquared <= radius * radius;
+        };
+        const math_Vec3 extents(radius, radius, radius);
+        VisitCells(GetCellRange(math_AABB(center - extents, center + extents)), overlaps, result);
+    }
+} // namespace pge
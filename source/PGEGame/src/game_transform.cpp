@@ -1,141 +1,146 @@
 #include "../include/game_transform.h"
 #include <core_assert.h>
+#include <algorithm>
 #include <iostream>
 
 namespace pge
 {
-    struct LocalTransformData {
-        math_Vec3 position;
-        math_Quat rotation;
-        math_Vec3 scale;
-    };
-    static const size_t TRANSFORM_ELEMENT_SIZE
-        = sizeof(game_Entity) + sizeof(LocalTransformData) + 2 * sizeof(math_Mat4x4) + 4 * sizeof(game_TransformId);
-
+    // The buffers always hold one extra slot (at index numTransforms), used as temporary storage when swapping transforms
     void
-    game_TransformManager::AllocateBuffers(size_t capacity)
-    {
-        if (m_buffer != nullptr)
-            free(m_buffer);
-        core_Assert(capacity > 0);
-        m_capacity        = capacity;
-        size_t bufferSize = TRANSFORM_ELEMENT_SIZE * m_capacity;
-
-        m_buffer     = malloc(bufferSize);
-        m_entity     = reinterpret_cast<game_Entity*>(m_buffer);
-        m_localData  = reinterpret_cast<LocalTransformData*>(m_entity + capacity);
-        m_local      = reinterpret_cast<math_Mat4x4*>(m_localData + capacity);
-        m_world      = m_local + capacity;
-        m_parent     = reinterpret_cast<game_TransformId*>(m_world + capacity);
-        m_firstChild = m_parent + capacity;
-        m_next       = m_firstChild + capacity;
-        m_prev       = m_next + capacity;
+    game_TransformManager::ResizeBuffers(size_t numTransforms)
+    {
+        const size_t numSlots = numTransforms + 1;
+        m_localData.Resize(numSlots);
+        m_local.Resize(numSlots);
+        m_world.Resize(numSlots);
+        m_worldRotation.Resize(numSlots);
+        m_worldScale.Resize(numSlots);
+        m_parent.Resize(numSlots);
+        m_firstChild.Resize(numSlots);
+        m_next.Resize(numSlots);
+        m_prev.Resize(numSlots);
+        m_depth.Resize(numSlots);
+        m_dirty.Resize(numSlots);
     }
 
     game_TransformManager::game_TransformManager(size_t capacity)
-        : m_capacity(capacity)
-        , m_buffer(nullptr)
+        : m_dirtyCount(0)
+        , m_firstDirty(0)
+        , m_trackMoved(false)
+    {
+        Reserve(capacity);
+        ResizeBuffers(0);
+    }
+
+    game_TransformManager::~game_TransformManager() {}
+
+    void
+    game_TransformManager::Reserve(size_t capacity)
     {
-        AllocateBuffers(capacity);
+        m_entities.Reserve(capacity);
+        m_localData.Reserve(capacity + 1);
+        m_local.Reserve(capacity + 1);
+        m_world.Reserve(capacity + 1);
+        m_worldRotation.Reserve(capacity + 1);
+        m_worldScale.Reserve(capacity + 1);
+        m_parent.Reserve(capacity + 1);
+        m_firstChild.Reserve(capacity + 1);
+        m_next.Reserve(capacity + 1);
+        m_prev.Reserve(capacity + 1);
+        m_depth.Reserve(capacity + 1);
+        m_dirty.Reserve(capacity + 1);
     }
 
-    game_TransformManager::~game_TransformManager()
+    size_t
+    game_TransformManager::GetNumTransforms() const
     {
-        free(m_buffer);
+        return m_entities.Size();
     }
 
     game_TransformId
     game_TransformManager::CreateTransform(const game_Entity& entity, const math_Vec3& position, const math_Quat& rotation, const math_Vec3& scale)
     {
         core_Assert(!HasTransform(entity));
-        core_Assert(m_entityMap.size() < m_capacity);
-        game_TransformId tid = m_entityMap.size();
+        // An older generation of the entity that wasn't garbage collected yet loses its transform
+        game_TransformId staleId = m_entities.FindAnyGeneration(entity);
+        if (staleId != game_TransformId_Invalid)
+            DestroyTransform(staleId);
+
+        game_TransformId tid = m_entities.Insert(entity);
+        ResizeBuffers(m_entities.Size());
 
-        m_entity[tid]             = entity.id;
         m_localData[tid].position = position;
         m_localData[tid].rotation = rotation;
         m_localData[tid].scale    = math_Vec3::One();
 
         math_Mat4x4 xform = math_CreateTransformMatrix(position, rotation, scale);
-        m_world[tid]      = xform;
+        m_local[tid]      = xform;
+        m_world[tid]         = xform;
+        m_worldRotation[tid] = rotation;
+        m_worldScale[tid]    = scale;
         m_parent[tid]     = game_TransformId_Invalid;
         m_firstChild[tid] = game_TransformId_Invalid;
         m_next[tid]       = game_TransformId_Invalid;
         m_prev[tid]       = game_TransformId_Invalid;
+        m_dirty[tid]      = false;
+        if (m_trackMoved)
+            m_movedEntities.push_back(entity);
 
-        m_entityMap.insert(std::make_pair(entity, tid));
-        SetLocal(tid, xform);
-
-        return tid;
+        // It was appended to the deepest level; move it up to the roots
+        if (m_levelEnd.empty())
+            m_levelEnd.push_back(0);
+        m_levelEnd.back()++;
+        m_depth[tid] = static_cast<unsigned>(m_levelEnd.size() - 1);
+        return MoveToDepth(tid, 0);
     }
 
     void
     game_TransformManager::CreateTransforms(const game_Entity* entities, size_t numEntities, game_TransformId* destBuf)
     {
         for (size_t i = 0; i < numEntities; ++i) {
-            destBuf[i] = CreateTransform(entities[i], math_Vec3::Zero(), math_Quat(), math_Vec3::One());
+            CreateTransform(entities[i], math_Vec3::Zero(), math_Quat(), math_Vec3::One());
+        }
+        for (size_t i = 0; i < numEntities; ++i) {
+            destBuf[i] = m_entities.GetId(entities[i]);
         }
     }
 
     void
     game_TransformManager::DestroyTransform(const game_TransformId& id)
     {
-        core_Assert(id < m_entityMap.size());
-
-        const game_TransformId& delId  = id;
-        const game_Entity       delEnt = m_entity[delId];
-
-        // Remove from current parent (if any)
-        SetParent(delId, game_TransformId_Invalid);
+        core_Assert(id < m_entities.Size());
+        const game_Entity entity = m_entities.GetEntity(id);
+        game_TransformId  delId  = id;
 
-        // Detach from children
-        auto child = m_firstChild[delId];
-        while (child != game_TransformId_Invalid) {
-            m_parent[child] = game_TransformId_Invalid;
-            m_prev[child]   = game_TransformId_Invalid;
-            auto next       = m_next[child];
-            m_next[child]   = game_TransformId_Invalid;
-            child           = next;
-        }
-        m_firstChild[delId] = game_TransformId_Invalid;
-
-        // Swap last with current data in buffers and remap
-        const game_TransformId& lastId  = m_entityMap.size() - 1;
-        const game_Entity       lastEnt = m_entity[lastId];
-        if (delId != lastId) {
-            m_entity[delId]    = m_entity[lastId];
-            m_localData[delId] = m_localData[lastId];
-            m_local[delId]     = m_local[lastId];
-            m_world[delId]     = m_world[lastId];
-
-            // Update the lastId-childrens parent
-            game_TransformId c = m_firstChild[lastId];
-            while (c != game_TransformId_Invalid) {
-                auto next = m_next[c];
-                SetParent(c, delId);
-                c = next;
-            }
-
-            // Update lastId's parent
-            game_TransformId p = m_parent[lastId];
-            SetParent(lastId, game_TransformId_Invalid); // Remove lastId from parent
-            SetParent(delId, p);
-
-            m_entityMap[lastEnt] = delId;
+        // Detach from children, which become roots that keep their world transform
+        while (m_firstChild[delId] != game_TransformId_Invalid) {
+            SetParent(m_firstChild[delId], game_TransformId_Invalid);
+            delId = m_entities.GetId(entity);
+        }
+        Unlink(delId);
+
+        // Move it to the end of the deepest level (the end of the buffer), so removing it keeps the others in order
+        delId                         = MoveToDepth(delId, static_cast<unsigned>(m_levelEnd.size() - 1));
+        const game_TransformId lastId = m_entities.Size() - 1;
+        SwapTransforms(delId, lastId);
+        if (m_dirty[lastId]) {
+            m_dirty[lastId] = false;
+            m_dirtyCount--;
         }
-        m_entityMap.erase(delEnt);
+        m_levelEnd.back()--;
+        m_entities.Remove(lastId);
+        ResizeBuffers(m_entities.Size());
+        TrimLevels();
+        if (m_trackMoved)
+            m_movedEntities.push_back(entity);
     }
 
     void
     game_TransformManager::GarbageCollect(const game_EntityManager& emanager)
     {
-        for (size_t aliveStreak = 0; m_entityMap.size() > 0 && aliveStreak < 4;) {
-            unsigned randIdx = rand() % m_entityMap.size();
-            if (!emanager.IsEntityAlive(m_entity[randIdx])) {
-                DestroyTransform(randIdx);
-                aliveStreak = 0;
-            } else {
-                aliveStreak++;
+        for (const game_Entity& entity : emanager.GetDestroyedEntities()) {
+            if (!emanager.IsEntityAlive(entity) && HasTransform(entity)) {
+                DestroyTransform(GetTransformId(entity));
             }
         }
     }
@@ -143,20 +148,26 @@ namespace pge
     bool
     game_TransformManager::HasTransform(const game_Entity& entity) const
     {
-        return m_entityMap.find(entity) != m_entityMap.end();
+        return m_entities.Has(entity);
     }
 
     game_TransformId
     game_TransformManager::GetTransformId(const game_Entity& entity) const
     {
         core_Assert(HasTransform(entity));
-        return m_entityMap.at(entity);
+        return m_entities.GetId(entity);
+    }
+
+    game_TransformId
+    game_TransformManager::FindTransformId(const game_Entity& entity) const
+    {
+        return m_entities.Find(entity);
     }
 
     void
     game_TransformManager::Translate(const game_TransformId& id, const math_Vec3& translation)
     {
-        core_Assert(id < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
         m_localData[id].position += translation;
         for (size_t i = 0; i < 3; ++i)
             m_local[id][i][3] = m_localData[id].position[i];
@@ -166,7 +177,7 @@ namespace pge
     void
     game_TransformManager::Rotate(const game_TransformId& id, const math_Vec3& axis, float degrees)
     {
-        core_Assert(id < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
         m_localData[id].rotation *= math_QuatFromAxisAngle(axis, degrees);
         SetLocal(id, math_CreateTransformMatrix(m_localData[id].position, m_localData[id].rotation, m_localData[id].scale));
     }
@@ -174,20 +185,28 @@ namespace pge
     void
     game_TransformManager::Scale(const game_TransformId& id, const math_Vec3& scale)
     {
-        core_Assert(id < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
         for (size_t i = 0; i < 3; ++i)
             m_localData[id].scale[i] *= scale[i];
         SetLocal(id, math_CreateTransformMatrix(m_localData[id].position, m_localData[id].rotation, m_localData[id].scale));
     }
 
     void
-    game_TransformManager::SetParent(const game_TransformId& child, const game_TransformId& parent)
+    game_TransformManager::SetParent(const game_TransformId& childId, const game_TransformId& parentId)
     {
+        // Copied, since the arguments may refer to links that are about to change (e.g. GetFirstChild)
+        const game_TransformId child  = childId;
+        const game_TransformId parent = parentId;
         core_Assert(child != parent);
-        core_Assert(child < m_entityMap.size());
+        core_Assert(child < m_entities.Size());
         if (m_parent[child] == parent)
             return;
 
+        ResolveWorld(child);
+        if (parent != game_TransformId_Invalid) {
+            ResolveWorld(parent);
+        }
+
         // Adjust local matrix s.t. the world transform remains unchanged.
         {
             // World[oldparentofi] * Local[i] = World[newparentofi] * X * Local[i]
@@ -209,47 +228,34 @@ namespace pge
         }
 
 
-        // Remove from current parent
-        if (m_parent[child] != game_TransformId_Invalid) {
-            game_TransformId curParent = m_parent[child];
-            if (child == m_firstChild[curParent]) {
-                m_firstChild[curParent] = m_next[child];
-                if (m_next[child] != game_TransformId_Invalid) {
-                    m_prev[m_next[child]] = game_TransformId_Invalid;
-                }
-            } else {
-                game_TransformId t = m_firstChild[curParent];
-                while (t != child)
-                    t = m_next[t];
-                if (m_prev[t] != game_TransformId_Invalid)
-                    m_next[m_prev[t]] = m_next[t];
-                if (m_next[t] != game_TransformId_Invalid)
-                    m_prev[m_next[t]] = m_prev[t];
-            }
+        Unlink(child);
+        if (parent != game_TransformId_Invalid) {
+            Link(child, parent);
         }
 
-        // Assign to new parent
-        if (parent != game_TransformId_Invalid) {
-            if (m_firstChild[parent] == game_EntityId_Invalid) {
-                m_firstChild[parent] = child;
-                m_prev[child]        = game_TransformId_Invalid;
-                m_next[child]        = game_TransformId_Invalid;
-            } else {
-                const game_TransformId prevFirst = m_firstChild[parent];
-                m_firstChild[parent]             = child;
-                m_next[child]                    = prevFirst;
-                m_prev[child]                    = game_TransformId_Invalid;
-                m_prev[prevFirst]                = child;
+        // Move the subtree to the levels of its new depth
+        const unsigned depth = parent == game_TransformId_Invalid ? 0 : m_depth[parent] + 1;
+        if (depth != m_depth[child]) {
+            const int delta = static_cast<int>(depth) - static_cast<int>(m_depth[child]);
+            m_subtree.clear();
+            m_subtree.push_back(m_entities.GetEntity(child));
+            for (size_t i = 0; i < m_subtree.size(); ++i) {
+                game_TransformId id = m_entities.GetId(m_subtree[i]);
+                for (game_TransformId c = m_firstChild[id]; c != game_TransformId_Invalid; c = m_next[c]) {
+                    m_subtree.push_back(m_entities.GetEntity(c));
+                }
+            }
+            for (const game_Entity& entity : m_subtree) {
+                game_TransformId id = m_entities.GetId(entity);
+                MoveToDepth(id, m_depth[id] + delta);
             }
         }
-
-        m_parent[child] = parent;
     }
 
     void
     game_TransformManager::SetLocal(const game_TransformId& id, const math_Vec3& position, const math_Quat& rotation, const math_Vec3& scale)
     {
-        core_Assert(id < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
         m_localData[id].position = position;
         m_localData[id].rotation = rotation;
         m_localData[id].scale    = scale;
@@ -259,7 +265,7 @@ namespace pge
     void
     game_TransformManager::SetLocalPosition(const game_TransformId& id, const math_Vec3& position)
     {
-        core_Assert(id < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
         m_localData[id].position = position;
         for (size_t i = 0; i < 3; ++i)
             m_local[id][i][3] = m_localData[id].position[i];
@@ -269,7 +275,7 @@ namespace pge
     void
     game_TransformManager::SetLocalRotation(const game_TransformId& id, const math_Quat& rotation)
     {
-        core_Assert(id < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
         m_localData[id].rotation = rotation;
         SetLocal(id, math_CreateTransformMatrix(m_localData[id].position, m_localData[id].rotation, m_localData[id].scale));
     }
@@ -277,7 +283,7 @@ namespace pge
     void
     game_TransformManager::SetLocalScale(const game_TransformId& id, const math_Vec3& scale)
     {
-        core_Assert(id < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
         m_localData[id].scale = scale;
         SetLocal(id, math_CreateTransformMatrix(m_localData[id].position, m_localData[id].rotation, m_localData[id].scale));
     }
@@ -285,7 +291,7 @@ namespace pge
     void
     game_TransformManager::SetLocalForward(const game_TransformId& id, const math_Vec3& forward, const math_Vec3& up)
     {
-        core_Assert(id < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
 
         const math_Vec3 originalFwd(0, 1, 0);
         const math_Vec3 cross = math_Cross(originalFwd, forward);
@@ -309,7 +315,7 @@ namespace pge
     void
     game_TransformManager::SetLocalLookAt(const game_TransformId& id, const math_Vec3& position, const math_Vec3& target, const math_Vec3& up)
     {
-        core_Assert(id < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
         m_localData[id].position = position;
         m_localData[id].scale    = math_Vec3::One();
         SetLocalForward(id, math_Normalize(target - position), up);
@@ -318,22 +324,22 @@ namespace pge
     const game_Entity&
     game_TransformManager::GetEntity(const game_TransformId& id) const
     {
-        core_Assert(id < m_entityMap.size());
-        return m_entity[id];
+        core_Assert(id < m_entities.Size());
+        return m_entities.GetEntity(id);
     }
 
     const game_TransformId&
     game_TransformManager::GetParent(const game_TransformId& id) const
     {
-        core_Assert(id < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
         return m_parent[id];
     }
 
     bool
     game_TransformManager::IsAncestor(const game_TransformId& id, const game_TransformId& ancestor) const
     {
-        core_Assert(id < m_entityMap.size());
-        core_Assert(ancestor < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
+        core_Assert(ancestor < m_entities.Size());
         game_TransformId parent = m_parent[id];
         while (parent != game_TransformId_Invalid) {
             if (parent == ancestor)
@@ -346,63 +352,65 @@ namespace pge
     const game_TransformId&
     game_TransformManager::GetFirstChild(const game_TransformId& id) const
     {
-        core_Assert(id < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
         return m_firstChild[id];
     }
 
     const game_TransformId&
     game_TransformManager::GetNextSibling(const game_TransformId& id) const
     {
-        core_Assert(id < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
         return m_next[id];
     }
 
     const game_TransformId&
     game_TransformManager::GetPreviousSibling(const game_TransformId& id) const
     {
-        core_Assert(id < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
         return m_prev[id];
     }
 
     math_Mat4x4
     game_TransformManager::GetLocalMatrix(const game_TransformId& id) const
     {
-        core_Assert(id < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
         return m_local[id];
     }
 
     math_Vec3
     game_TransformManager::GetLocalPosition(const game_TransformId& id) const
     {
-        core_Assert(id < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
         return m_localData[id].position;
     }
 
     math_Quat
     game_TransformManager::GetLocalRotation(const game_TransformId& id) const
     {
-        core_Assert(id < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
         return m_localData[id].rotation;
     }
 
     math_Vec3
     game_TransformManager::GetLocalScale(const game_TransformId& id) const
     {
-        core_Assert(id < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
         return m_localData[id].scale;
     }
 
     math_Mat4x4
     game_TransformManager::GetWorldMatrix(const game_TransformId& id) const
     {
-        core_Assert(id < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
+        ResolveWorld(id);
         return m_world[id];
     }
 
     math_Vec3
     game_TransformManager::GetWorldPosition(const game_TransformId& id) const
     {
-        core_Assert(id < m_entityMap.size());
+        core_Assert(id < m_entities.Size());
+        ResolveWorld(id);
         const math_Mat4x4& world = m_world[id];
         return math_Vec3(world[0][3], world[1][3], world[2][3]);
     }
@@ -410,37 +418,47 @@ namespace pge
     math_Quat
     game_TransformManager::GetWorldRotation(const game_TransformId& id) const
     {
-        core_Assert(id < m_entityMap.size());
-        game_TransformId pid = m_parent[id];
-        math_Quat        parRot;
-        if (pid != game_TransformId_Invalid) {
-            parRot = GetWorldRotation(pid);
-        }
-        return parRot * m_localData[id].rotation;
+        core_Assert(id < m_entities.Size());
+        ResolveWorld(id);
+        return m_worldRotation[id];
     }
 
     math_Vec3
     game_TransformManager::GetWorldScale(const game_TransformId& id) const
     {
-        core_Assert(id < m_entityMap.size());
-        game_TransformId pid = m_parent[id];
-        math_Vec3        parScale;
-        if (pid != game_TransformId_Invalid) {
-            parScale = GetWorldScale(pid);
-        }
-        math_Vec3 scale = m_localData[id].scale;
-        for (size_t i = 0; i < 3; ++i)
-            scale[i] *= parScale[i];
-        return scale;
+        core_Assert(id < m_entities.Size());
+        ResolveWorld(id);
+        return m_worldScale[id];
     }
 
 
     constexpr unsigned SERIALIZE_VERSION = 1;
 
+    // Buffers are written chunk by chunk, the stream layout is the same as that of a flat array
+    template <typename Buffer>
+    static void
+    WriteBuffer(std::ostream& os, const Buffer& buffer, size_t count)
+    {
+        const size_t chunkSize = Buffer::GetChunkSize();
+        for (size_t i = 0; i < count; i += chunkSize) {
+            os.write((const char*)&buffer[i], sizeof(buffer[i]) * std::min(chunkSize, count - i));
+        }
+    }
+
+    template <typename Buffer>
+    static void
+    ReadBuffer(std::istream& is, Buffer* buffer, size_t count)
+    {
+        const size_t chunkSize = Buffer::GetChunkSize();
+        for (size_t i = 0; i < count; i += chunkSize) {
+            is.read((char*)&(*buffer)[i], sizeof((*buffer)[i]) * std::min(chunkSize, count - i));
+        }
+    }
+
     void
     game_TransformManager::SerializeEntity(std::ostream& os, const game_Entity& entity) const
     {
-        game_TransformId          tid       = m_entityMap.at(entity);
+        game_TransformId          tid       = m_entities.GetId(entity);
         const LocalTransformData& localData = m_localData[tid];
         os.write((const char*)&localData.position, sizeof(localData.position));
         os.write((const char*)&localData.rotation, sizeof(localData.rotation));
@@ -453,7 +471,7 @@ namespace pge
         if (!HasTransform(entity)) {
             CreateTransform(entity);
         }
-        game_TransformId    tid       = m_entityMap[entity];
+        game_TransformId    tid       = m_entities.GetId(entity);
         LocalTransformData& localData = m_localData[tid];
         is.read((char*)&localData.position, sizeof(localData.position));
         is.read((char*)&localData.rotation, sizeof(localData.rotation));
@@ -464,19 +482,19 @@ namespace pge
     std::ostream&
     operator<<(std::ostream& os, const game_TransformManager& tm)
     {
-        unsigned numComponents = tm.m_entityMap.size();
+        unsigned numComponents = tm.m_entities.Size();
 
         unsigned version = SERIALIZE_VERSION;
         os.write((const char*)&version, sizeof(version));
         os.write((const char*)&numComponents, sizeof(numComponents));
 
-        os.write((const char*)tm.m_entity, sizeof(tm.m_entity[0]) * numComponents);
-        os.write((const char*)tm.m_localData, sizeof(tm.m_localData[0]) * numComponents);
-        os.write((const char*)tm.m_world, sizeof(tm.m_world[0]) * numComponents);
-        os.write((const char*)tm.m_parent, sizeof(tm.m_parent[0]) * numComponents);
-        os.write((const char*)tm.m_firstChild, sizeof(tm.m_firstChild[0]) * numComponents);
-        os.write((const char*)tm.m_next, sizeof(tm.m_next[0]) * numComponents);
-        os.write((const char*)tm.m_prev, sizeof(tm.m_prev[0]) * numComponents);
+        os.write((const char*)tm.m_entities.GetEntities(), sizeof(game_Entity) * numComponents);
+        WriteBuffer(os, tm.m_localData, numComponents);
+        WriteBuffer(os, tm.m_world, numComponents);
+        WriteBuffer(os, tm.m_parent, numComponents);
+        WriteBuffer(os, tm.m_firstChild, numComponents);
+        WriteBuffer(os, tm.m_next, numComponents);
+        WriteBuffer(os, tm.m_prev, numComponents);
 
         return os;
     }
@@ -490,35 +508,44 @@ namespace pge
         unsigned numTransforms = 0;
         is.read((char*)&numTransforms, sizeof(numTransforms));
 
-        if (tm.m_capacity < numTransforms) {
-            tm.AllocateBuffers(numTransforms);
-        }
-
-        is.read((char*)tm.m_entity, sizeof(tm.m_entity[0]) * numTransforms);
-        is.read((char*)tm.m_localData, sizeof(tm.m_localData[0]) * numTransforms);
-        is.read((char*)tm.m_world, sizeof(tm.m_world[0]) * numTransforms);
-        is.read((char*)tm.m_parent, sizeof(tm.m_parent[0]) * numTransforms);
-        is.read((char*)tm.m_firstChild, sizeof(tm.m_firstChild[0]) * numTransforms);
-        is.read((char*)tm.m_next, sizeof(tm.m_next[0]) * numTransforms);
-        is.read((char*)tm.m_prev, sizeof(tm.m_prev[0]) * numTransforms);
-
-        tm.m_entityMap.clear();
+        tm.m_entities.Clear();
+        tm.Reserve(numTransforms);
         for (unsigned i = 0; i < numTransforms; ++i) {
-            tm.m_entityMap.insert(std::make_pair<>(tm.m_entity[i], i));
+            game_Entity entity;
+            is.read((char*)&entity, sizeof(entity));
+            tm.m_entities.Insert(entity);
         }
+        tm.ResizeBuffers(numTransforms);
+        ReadBuffer(is, &tm.m_localData, numTransforms);
+        ReadBuffer(is, &tm.m_world, numTransforms);
+        ReadBuffer(is, &tm.m_parent, numTransforms);
+        ReadBuffer(is, &tm.m_firstChild, numTransforms);
+        ReadBuffer(is, &tm.m_next, numTransforms);
+        ReadBuffer(is, &tm.m_prev, numTransforms);
 
+        for (size_t i = 0; i < numTransforms; ++i) {
+            tm.m_dirty[i] = false;
+        }
+        tm.m_dirtyCount = 0;
+        tm.SortByDepth();
         for (size_t i = 0; i < numTransforms; ++i) {
             LocalTransformData data = tm.m_localData[i];
             tm.SetLocal(i, math_CreateTransformMatrix(data.position, data.rotation, data.scale));
         }
+        tm.UpdateWorldTransforms();
 
         return is;
     }
 
+    // World matrices act as a cache of the hierarchy, so (re)computing them is allowed from const getters.
     void
-    game_TransformManager::Transform(const game_TransformId& id, const math_Mat4x4& parent)
+    game_TransformManager::Transform(const game_TransformId& id, const math_Mat4x4& parent) const
     {
-        m_world[id]            = parent * m_local[id];
+        if (m_dirty[id]) {
+            m_dirty[id] = false;
+            m_dirtyCount--;
+        }
+        SetWorld(id, parent * m_local[id]);
         game_TransformId child = m_firstChild[id];
         while (child != game_TransformId_Invalid) {
             Transform(child, m_world[id]);
@@ -526,13 +553,302 @@ namespace pge
         }
     }
 
+    // The rows of a rotation that were scaled by the given (non-negative) scale. An axis scaled to zero has no
+    // direction of its own, so it's completed from the other two; with more than one, the rotation is unknown.
+    static math_Mat4x4
+    UnscaleRotationRows(const math_Mat4x4& matrix, const math_Vec3& scale)
+    {
+        math_Mat4x4 rotMatrix;
+        int         numFlat  = 0;
+        size_t      flatAxis = 0;
+        for (size_t i = 0; i < 3; ++i) {
+            const math_Vec3 row(matrix[i][0], matrix[i][1], matrix[i][2]);
+            if (math_FloatEqual(scale[i], 0)) {
+                numFlat++;
+                flatAxis = i;
+            } else {
+                rotMatrix[i] = math_Vec4(row / scale[i], 0);
+            }
+        }
+        if (numFlat == 0)
+            return rotMatrix;
+        if (numFlat == 1) {
+            const math_Vec3 a(rotMatrix[(flatAxis + 1) % 3][0], rotMatrix[(flatAxis + 1) % 3][1], rotMatrix[(flatAxis + 1) % 3][2]);
+            const math_Vec3 b(rotMatrix[(flatAxis + 2) % 3][0], rotMatrix[(flatAxis + 2) % 3][1], rotMatrix[(flatAxis + 2) % 3][2]);
+            const math_Vec3 axis = math_Cross(a, b);
+            if (!math_FloatEqual(math_Length(axis), 0)) {
+                rotMatrix[flatAxis] = math_Vec4(math_Normalize(axis), 0);
+                return rotMatrix;
+            }
+        }
+        return math_Mat4x4();
+    }
+
+    // World rotation and scale are decomposed from the world matrix, so they always agree with GetWorldMatrix.
+    // Transform matrices are T * S * R, so the rows of the upper 3x3 are the rows of the rotation, scaled.
+    void
+    game_TransformManager::SetWorld(const game_TransformId& id, const math_Mat4x4& world) const
+    {
+        m_world[id] = world;
+        if (m_trackMoved)
+            m_movedEntities.push_back(m_entities.GetEntity(id));
+
+        math_Vec3 scale;
+        for (size_t i = 0; i < 3; ++i)
+            scale[i] = math_Length(math_Vec3(world[i][0], world[i][1], world[i][2]));
+        math_Mat4x4     rotMatrix = UnscaleRotationRows(world, scale);
+        const math_Vec3 r0(rotMatrix[0][0], rotMatrix[0][1], rotMatrix[0][2]);
+        const math_Vec3 r1(rotMatrix[1][0], rotMatrix[1][1], rotMatrix[1][2]);
+        const math_Vec3 r2(rotMatrix[2][0], rotMatrix[2][1], rotMatrix[2][2]);
+        if (math_Dot(math_Cross(r0, r1), r2) < 0) {
+            rotMatrix *= -1.f;
+            scale *= -1.f;
+        }
+        m_worldRotation[id] = math_QuatFromMatrix(rotMatrix);
+        m_worldScale[id]    = scale;
+    }
+
     void
     game_TransformManager::SetLocal(const game_TransformId& id, const math_Mat4x4& matrix)
     {
-        core_Assert(id < m_entityMap.size());
-        m_local[id]                  = matrix;
-        game_TransformId parentId    = m_parent[id];
-        math_Mat4x4      parentWorld = parentId == game_TransformId_Invalid ? math_Mat4x4() : m_world[parentId];
-        Transform(id, parentWorld);
+        core_Assert(id < m_entities.Size());
+        m_local[id] = matrix;
+        MarkDirty(id);
+    }
+
+    void
+    game_TransformManager::MarkDirty(const game_TransformId& id)
+    {
+        if (m_dirty[id])
+            return;
+        m_firstDirty = m_dirtyCount == 0 ? id : std::min<size_t>(m_firstDirty, id);
+        m_dirty[id]  = true;
+        m_dirtyCount++;
+    }
+
+    // Returns the top-most dirty transform on the path from id to its root (or invalid if id's world matrix is up to date)
+    game_TransformId
+    game_TransformManager::FindDirtyRoot(game_TransformId id) const
+    {
+        game_TransformId dirtyRoot = game_TransformId_Invalid;
+        for (; id != game_TransformId_Invalid; id = m_parent[id]) {
+            if (m_dirty[id])
+                dirtyRoot = id;
+        }
+        return dirtyRoot;
+    }
+
+    void
+    game_TransformManager::ResolveWorld(const game_TransformId& id) const
+    {
+        if (m_dirtyCount == 0)
+            return;
+        game_TransformId dirtyRoot = FindDirtyRoot(id);
+        if (dirtyRoot != game_TransformId_Invalid) {
+            game_TransformId parentId = m_parent[dirtyRoot];
+            Transform(dirtyRoot, parentId == game_TransformId_Invalid ? math_Mat4x4() : m_world[parentId]);
+        }
+    }
+
+    void
+    game_TransformManager::UpdateWorldTransforms()
+    {
+        if (m_dirtyCount == 0)
+            return;
+
+        // A level only depends on the levels above it, so each one could be split across threads
+        size_t levelBegin = 0;
+        for (size_t level = 0; level < m_levelEnd.size(); ++level) {
+            size_t begin = std::max(levelBegin, m_firstDirty);
+            size_t end   = m_levelEnd[level];
+            if (begin < end) {
+                UpdateWorldRange(begin, end);
+            }
+            levelBegin = end;
+        }
+
+        const size_t numTransforms = m_entities.Size();
+        for (size_t i = m_firstDirty; i < numTransforms; ++i) {
+            m_dirty[i] = false;
+        }
+        m_dirtyCount = 0;
+    }
+
+    void
+    game_TransformManager::TakeMovedEntities(std::vector<game_Entity>* moved)
+    {
+        moved->clear();
+        moved->swap(m_movedEntities);
+        m_trackMoved = true;
+    }
+
+    void
+    game_TransformManager::UpdateWorldRange(size_t begin, size_t end)
+    {
+        // Transforms updated during the sweep stay flagged, which tells their children (in later levels) to update as well
+        for (size_t i = begin; i < end; ++i) {
+            const game_TransformId parent = m_parent[i];
+            if (parent == game_TransformId_Invalid) {
+                if (m_dirty[i])
+                    SetWorld(i, m_local[i]);
+            } else if (m_dirty[i] || m_dirty[parent]) {
+                SetWorld(i, m_world[parent] * m_local[i]);
+                m_dirty[i] = true;
+            }
+        }
+    }
+
+    // ----------------------------------------------
+    // Hierarchy ordering
+    // ----------------------------------------------
+    void
+    game_TransformManager::Link(const game_TransformId& child, const game_TransformId& parent)
+    {
+        m_parent[child] = parent;
+        m_prev[child]   = game_TransformId_Invalid;
+        m_next[child]   = m_firstChild[parent];
+        if (m_next[child] != game_TransformId_Invalid) {
+            m_prev[m_next[child]] = child;
+        }
+        m_firstChild[parent] = child;
+    }
+
+    void
+    game_TransformManager::Unlink(const game_TransformId& child)
+    {
+        const game_TransformId parent = m_parent[child];
+        if (parent == game_TransformId_Invalid)
+            return;
+        if (m_prev[child] != game_TransformId_Invalid) {
+            m_next[m_prev[child]] = m_next[child];
+        } else {
+            m_firstChild[parent] = m_next[child];
+        }
+        if (m_next[child] != game_TransformId_Invalid) {
+            m_prev[m_next[child]] = m_prev[child];
+        }
+        m_parent[child] = game_TransformId_Invalid;
+        m_next[child]   = game_TransformId_Invalid;
+        m_prev[child]   = game_TransformId_Invalid;
+    }
+
+    // Copies a transform into an unused slot and points its parent, siblings and children at the new slot
+    void
+    game_TransformManager::MoveSlot(const game_TransformId& from, const game_TransformId& to)
+    {
+        m_localData[to]     = m_localData[from];
+        m_local[to]         = m_local[from];
+        m_world[to]         = m_world[from];
+        m_worldRotation[to] = m_worldRotation[from];
+        m_worldScale[to]    = m_worldScale[from];
+        m_parent[to]        = m_parent[from];
+        m_firstChild[to]    = m_firstChild[from];
+        m_next[to]          = m_next[from];
+        m_prev[to]          = m_prev[from];
+        m_depth[to]         = m_depth[from];
+        m_dirty[to]         = m_dirty[from];
+
+        if (m_prev[to] != game_TransformId_Invalid) {
+            m_next[m_prev[to]] = to;
+        } else if (m_parent[to] != game_TransformId_Invalid) {
+            m_firstChild[m_parent[to]] = to;
+        }
+        if (m_next[to] != game_TransformId_Invalid) {
+            m_prev[m_next[to]] = to;
+        }
+        for (game_TransformId c = m_firstChild[to]; c != game_TransformId_Invalid; c = m_next[c]) {
+            m_parent[c] = to;
+        }
+    }
+
+    void
+    game_TransformManager::SwapTransforms(const game_TransformId& a, const game_TransformId& b)
+    {
+        if (a == b)
+            return;
+        const game_TransformId spare = static_cast<game_TransformId>(m_entities.Size());
+        MoveSlot(a, spare);
+        MoveSlot(b, a);
+        MoveSlot(spare, b);
+        m_entities.Swap(a, b);
+        if (m_dirtyCount > 0 && (m_dirty[a] || m_dirty[b])) {
+            m_firstDirty = std::min<size_t>(m_firstDirty, std::min(a, b));
+        }
+    }
+
+    // Moves a transform to the given level, one level at a time: it swaps with the last (or first) transform of its
+    // level, after which the level boundary is shifted past it. Only a single transform per level is moved.
+    game_TransformId
+    game_TransformManager::MoveToDepth(game_TransformId id, unsigned depth)
+    {
+        unsigned level = m_depth[id];
+        while (level < depth) {
+            if (level + 1 == m_levelEnd.size()) {
+                const size_t end = m_levelEnd.back();
+                m_levelEnd.push_back(end);
+            }
+            const game_TransformId last = static_cast<game_TransformId>(m_levelEnd[level] - 1);
+            SwapTransforms(id, last);
+            id = last;
+            m_levelEnd[level]--;
+            level++;
+        }
+        while (level > depth) {
+            const game_TransformId first = static_cast<game_TransformId>(m_levelEnd[level - 1]);
+            SwapTransforms(id, first);
+            id = first;
+            m_levelEnd[level - 1]++;
+            level--;
+        }
+        m_depth[id] = depth;
+        TrimLevels();
+        return id;
+    }
+
+    void
+    game_TransformManager::TrimLevels()
+    {
+        while (!m_levelEnd.empty()) {
+            const size_t levelBegin = m_levelEnd.size() > 1 ? m_levelEnd[m_levelEnd.size() - 2] : 0;
+            if (m_levelEnd.back() != levelBegin)
+                break;
+            m_levelEnd.pop_back();
+        }
+    }
+
+    // Full sort, only used when the ordering is unknown (i.e. after deserializing)
+    void
+    game_TransformManager::SortByDepth()
+    {
+        const size_t numTransforms = m_entities.Size();
+        m_levelEnd.clear();
+        for (size_t i = 0; i < numTransforms; ++i) {
+            unsigned depth = 0;
+            for (game_TransformId p = m_parent[i]; p != game_TransformId_Invalid; p = m_parent[p])
+                ++depth;
+            m_depth[i] = depth;
+            if (depth >= m_levelEnd.size()) {
+                m_levelEnd.resize(depth + 1, 0);
+            }
+            m_levelEnd[depth]++;
+        }
+
+        std::vector<size_t> levelNext(m_levelEnd.size(), 0);
+        for (size_t level = 0; level < m_levelEnd.size(); ++level) {
+            levelNext[level] = level == 0 ? 0 : m_levelEnd[level - 1];
+            m_levelEnd[level] += levelNext[level];
+        }
+
+        std::vector<game_TransformId> target(numTransforms);
+        for (size_t i = 0; i < numTransforms; ++i) {
+            target[i] = static_cast<game_TransformId>(levelNext[m_depth[i]]++);
+        }
+        for (game_TransformId i = 0; i < numTransforms; ++i) {
+            while (target[i] != i) {
+                const game_TransformId j = target[i];
+                SwapTransforms(i, j);
+                std::swap(target[i], target[j]);
+            }
+        }
     }
-} // namespace pge
\ No newline at end of file
+} // namespace pge
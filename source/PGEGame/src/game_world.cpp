@@ -3,15 +3,28 @@
 
 namespace pge
 {
-    game_World::game_World(gfx_GraphicsAdapter* graphicsAdapter, gfx_GraphicsDevice* graphicsDevice, res_ResourceManager* resources)
-        : m_transformManager(100)
-        , m_meshManager(100, resources)
-        , m_animationManager(100)
-        , m_lightManager(&m_transformManager, 100)
-        , m_scriptManager(100)
+    game_WorldCapacity::game_WorldCapacity(size_t numEntities)
+        : transforms(numEntities)
+        , meshes(numEntities)
+        , animators(numEntities)
+        , lights(numEntities)
+        , scripts(numEntities)
+        , frameArenaBytes(1024 * 1024)
+    {}
+
+    game_World::game_World(gfx_GraphicsAdapter*      graphicsAdapter,
+                           gfx_GraphicsDevice*       graphicsDevice,
+                           res_ResourceManager*      resources,
+                           const game_WorldCapacity& capacity)
+        : m_transformManager(capacity.transforms)
+        , m_meshManager(capacity.meshes, resources)
+        , m_animationManager(capacity.animators)
+        , m_lightManager(&m_transformManager, capacity.lights)
+        , m_scriptManager(capacity.scripts)
         , m_behaviourManager()
         , m_cameraManager(&m_transformManager)
         , m_renderer(graphicsAdapter, graphicsDevice, resources)
+        , m_frameArena(capacity.frameArenaBytes)
     {}
 
     void
@@ -23,14 +36,24 @@ namespace pge
         m_lightManager.GarbageCollect(m_entityManager);
         m_scriptManager.GarbageCollect(m_entityManager);
         m_cameraManager.GarbageCollect(m_entityManager);
+        m_behaviourManager.GarbageCollect(m_entityManager);
+        m_entityManager.ClearDestroyedEntities();
+    }
+
+    void
+    game_World::BeginFrame()
+    {
+        m_frameArena.NextFrame();
     }
 
     void
     game_World::Update()
     {
         m_behaviourManager.Update(1.0f / 60.0f);
-        m_animationManager.Update(1.0f / 60.0f);
+        m_animationManager.Update(1.0f / 60.0f, m_meshManager, m_transformManager);
         m_scriptManager.UpdateScripts();
+        m_transformManager.UpdateWorldTransforms();
+        m_meshManager.UpdateSpatialIndex(m_transformManager);
     }
 
 
@@ -38,6 +61,8 @@ namespace pge
     game_World::Draw(const math_Mat4x4& view, const math_Mat4x4& proj, const game_RenderPass& pass, bool withDebug)
     {
         m_scriptManager.UpdateScripts();
+        m_transformManager.UpdateWorldTransforms();
+        m_meshManager.UpdateSpatialIndex(m_transformManager);
 
         m_renderer.SetCamera(view, proj);
         m_renderer.UpdateLights(m_lightManager, m_transformManager, m_entityManager, m_meshManager, m_animationManager);
@@ -56,6 +81,7 @@ namespace pge
         const game_Entity& camera     = m_cameraManager.GetActiveCamera();
         const math_Mat4x4& cameraView = m_cameraManager.GetViewMatrix(camera);
         const math_Mat4x4& cameraProj = m_cameraManager.GetProjectionMatrix(camera);
+        m_animationManager.SetViewpoint(m_transformManager.GetWorldPosition(m_transformManager.GetTransformId(camera)));
         Draw(cameraView, cameraProj, game_RenderPass::LIGHTING, true);
     }
 
@@ -66,10 +92,9 @@ namespace pge
         math_Vec2 billboardSize(2, 2);
 
         // Static Mesh select
-        const math_Mat4x4 viewProj = projMat * viewMat;
-        const math_Ray    ray      = math_Raycast_RayFromPixel(cursor, viewSize, viewProj);
-        float             meshSelectDistance;
-        game_Entity       meshSelectEntity = m_meshManager.RaycastSelect(m_transformManager, ray, viewProj, &meshSelectDistance);
+        const math_Ray ray = math_Raycast_RayFromPixel(cursor, viewSize, projMat * viewMat);
+        float          meshSelectDistance;
+        game_Entity    meshSelectEntity = m_meshManager.RaycastSelect(m_transformManager, ray, &meshSelectDistance);
 
         // Point Light select
         math_Vec2 cursorNorm(cursor.x / viewSize.x, cursor.y / viewSize.y);
@@ -165,6 +190,12 @@ namespace pge
         return &m_renderer;
     }
 
+    mem_FrameArena*
+    game_World::GetFrameArena()
+    {
+        return &m_frameArena;
+    }
+
 
     const game_EntityManager*
     game_World::GetEntityManager() const
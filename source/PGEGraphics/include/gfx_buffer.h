@@ -54,6 +54,21 @@ namespace pge
         void Update(const void* data, size_t size, size_t offset);
         void Bind(unsigned slot, size_t vertexStride, size_t offset) const;
     };
+
+
+    // An array of elements that shaders read by index, e.g. per-instance data
+    class gfx_StructuredBuffer {
+        class gfx_StructuredBufferImpl;
+        std::unique_ptr<gfx_StructuredBufferImpl> m_impl;
+
+    public:
+        gfx_StructuredBuffer(gfx_GraphicsAdapter* graphicsAdapter, const void* data, size_t elementSize, size_t numElements, gfx_BufferUsage usage);
+        ~gfx_StructuredBuffer();
+
+        // Replaces the first numElements elements
+        void Update(const void* data, size_t numElements);
+        void BindVS(unsigned slot) const;
+    };
 }
 
 #endif
\ No newline at end of file
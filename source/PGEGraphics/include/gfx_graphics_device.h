@@ -34,6 +34,7 @@ namespace pge
         void Present();
         void Draw(gfx_PrimitiveType primitive, unsigned first, unsigned count);
         void DrawIndexed(gfx_PrimitiveType primitive, unsigned first, unsigned count);
+        void DrawIndexedInstanced(gfx_PrimitiveType primitive, unsigned first, unsigned count, unsigned numInstances);
         void SetViewport(float x, float y, float width, float height);
         void SetRasterizerState(const gfx_RasterizerState& state);
         gfx_RasterizerState GetRasterizerState() const;
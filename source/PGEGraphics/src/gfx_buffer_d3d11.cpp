@@ -17,13 +17,15 @@ namespace pge
     }
 
     static ID3D11Buffer*
-    CreateBufferD3D11(ID3D11Device* device, const void* data, size_t size, gfx_BufferUsage usage, UINT bindFlags)
+    CreateBufferD3D11(ID3D11Device* device, const void* data, size_t size, gfx_BufferUsage usage, UINT bindFlags, size_t structureStride = 0)
     {
-        D3D11_BUFFER_DESC bufferDesc = {0};
-        bufferDesc.BindFlags         = bindFlags;
-        bufferDesc.ByteWidth         = size;
-        bufferDesc.CPUAccessFlags    = (usage == gfx_BufferUsage::DYNAMIC) ? D3D11_CPU_ACCESS_WRITE : 0;
-        bufferDesc.Usage             = GetBufferUsageD3D11(usage);
+        D3D11_BUFFER_DESC bufferDesc   = {0};
+        bufferDesc.BindFlags           = bindFlags;
+        bufferDesc.ByteWidth           = size;
+        bufferDesc.CPUAccessFlags      = (usage == gfx_BufferUsage::DYNAMIC) ? D3D11_CPU_ACCESS_WRITE : 0;
+        bufferDesc.Usage               = GetBufferUsageD3D11(usage);
+        bufferDesc.MiscFlags           = structureStride > 0 ? D3D11_RESOURCE_MISC_BUFFER_STRUCTURED : 0;
+        bufferDesc.StructureByteStride = structureStride;
 
         D3D11_SUBRESOURCE_DATA bufferData = {0};
         bufferData.pSysMem                = data;
@@ -200,4 +202,60 @@ namespace pge
                                                     reinterpret_cast<UINT*>(&vertexStride),
                                                     reinterpret_cast<UINT*>(&offset));
     }
+
+
+    // ------------------------------------------------------------
+    // gfx_StructuredBuffer
+    // ------------------------------------------------------------
+    struct gfx_StructuredBuffer::gfx_StructuredBufferImpl {
+        ID3D11DeviceContext*      m_deviceContext;
+        gfx_BufferUsage           m_usage;
+        ID3D11Buffer*             m_buffer;
+        ID3D11ShaderResourceView* m_view;
+        size_t                    m_elementSize;
+        size_t                    m_numElements;
+    };
+
+    gfx_StructuredBuffer::gfx_StructuredBuffer(gfx_GraphicsAdapter* graphicsAdapter,
+                                               const void*          data,
+                                               size_t               elementSize,
+                                               size_t               numElements,
+                                               gfx_BufferUsage      usage)
+        : m_impl(new gfx_StructuredBufferImpl)
+    {
+        auto          graphicsAdapterD3D11 = reinterpret_cast<gfx_GraphicsAdapterD3D11*>(graphicsAdapter);
+        ID3D11Device* device               = graphicsAdapterD3D11->GetDevice();
+        m_impl->m_deviceContext            = graphicsAdapterD3D11->GetDeviceContext();
+        m_impl->m_usage                    = usage;
+        m_impl->m_elementSize              = elementSize;
+        m_impl->m_numElements              = numElements;
+        m_impl->m_buffer = CreateBufferD3D11(device, data, elementSize * numElements, usage, D3D11_BIND_SHADER_RESOURCE, elementSize);
+
+        D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc = {};
+        viewDesc.Format                          = DXGI_FORMAT_UNKNOWN;
+        viewDesc.ViewDimension                   = D3D11_SRV_DIMENSION_BUFFER;
+        viewDesc.Buffer.FirstElement             = 0;
+        viewDesc.Buffer.NumElements              = numElements;
+        HRESULT result                           = device->CreateShaderResourceView(m_impl->m_buffer, &viewDesc, &m_impl->m_view);
+        core_AssertWithReason(SUCCEEDED(result), _com_error(result).ErrorMessage());
+    }
+
+    gfx_StructuredBuffer::~gfx_StructuredBuffer()
+    {
+        m_impl->m_view->Release();
+        m_impl->m_buffer->Release();
+    }
+
+    void
+    gfx_StructuredBuffer::Update(const void* data, size_t numElements)
+    {
+        core_Assert(numElements <= m_impl->m_numElements);
+        UpdateBufferD3D11(m_impl->m_deviceContext, m_impl->m_buffer, data, numElements * m_impl->m_elementSize, 0, m_impl->m_usage);
+    }
+
+    void
+    gfx_StructuredBuffer::BindVS(unsigned slot) const
+    {
+        m_impl->m_deviceContext->VSSetShaderResources(slot, 1, &m_impl->m_view);
+    }
 } // namespace pge
\ No newline at end of file
@@ -86,6 +86,13 @@ namespace pge
         m_impl->m_deviceContext->DrawIndexed(count, first, 0);
     }
 
+    void
+    gfx_GraphicsDevice::DrawIndexedInstanced(gfx_PrimitiveType primitive, unsigned first, unsigned count, unsigned numInstances)
+    {
+        m_impl->m_deviceContext->IASetPrimitiveTopology(GetPrimitiveType3D11(primitive));
+        m_impl->m_deviceContext->DrawIndexedInstanced(count, numInstances, first, 0, 0);
+    }
+
     void
     gfx_GraphicsDevice::SetViewport(float x, float y, float width, float height)
     {
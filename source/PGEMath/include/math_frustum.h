@@ -0,0 +1,128 @@
+#ifndef PGE_MATH_MATH_FRUSTUM_H
+#define PGE_MATH_MATH_FRUSTUM_H
+
+#include "math_mat4x4.h"
+#include "math_aabb.h"
+#include <cmath>
+#include <cstdint>
+
+// SSE is part of every x64 target; define PGE_MATH_NO_SIMD to force the scalar test
+#if !defined(PGE_MATH_NO_SIMD) && (defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#    define MATH_SIMD_SSE
+#    include <xmmintrin.h>
+#endif
+
+namespace pge
+{
+    // Left, right, bottom, top, near and far planes (a, b, c, d), facing inward and normalized. A point p is inside
+    // the plane when a * p.x + b * p.y + c * p.z + d >= 0.
+    struct math_Frustum {
+        math_Vec4 planes[6];
+    };
+
+    // The planes of a view-projection matrix with clip space depth in [0, 1], like math_PerspectiveFovRH and
+    // math_OrthographicRH make. The planes are in the space the matrix transforms from.
+    inline math_Frustum
+    math_CreateFrustum(const math_Mat4x4& viewProj)
+    {
+        const math_Vec4& x = viewProj[0];
+        const math_Vec4& y = viewProj[1];
+        const math_Vec4& z = viewProj[2];
+        const math_Vec4& w = viewProj[3];
+
+        math_Frustum frustum;
+        frustum.planes[0] = w + x;
+        frustum.planes[1] = w - x;
+        frustum.planes[2] = w + y;
+        frustum.planes[3] = w - y;
+        frustum.planes[4] = z;
+        frustum.planes[5] = w - z;
+        for (math_Vec4& plane : frustum.planes)
+            plane = plane / math_Length(plane.xyz);
+        return frustum;
+    }
+
+    // False when the box lies entirely behind one of the planes. Boxes just outside a corner of the frustum can
+    // pass, which is fine for culling.
+    inline bool
+    math_Frustum_IntersectsAABB(const math_Frustum& frustum, const math_AABB& aabb)
+    {
+        const math_Vec3 center  = (aabb.min + aabb.max) * 0.5f;
+        const math_Vec3 extents = (aabb.max - aabb.min) * 0.5f;
+        for (const math_Vec4& plane : frustum.planes) {
+            float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+            float radius   = fabsf(plane.x) * extents.x + fabsf(plane.y) * extents.y + fabsf(plane.z) * extents.z;
+            if (distance + radius < 0)
+                return false;
+        }
+        return true;
+    }
+
+    // Tests a contiguous array of boxes, writing 1 for the ones that intersect the frustum and 0 for the others.
+    // Returns the number of intersecting boxes. Gives the same results as math_Frustum_IntersectsAABB.
+    inline size_t
+    math_Frustum_CullAABBs(const math_Frustum& frustum, const math_AABB* boxes, size_t numBoxes, uint8_t* visible)
+    {
+        size_t numVisible = 0;
+        size_t i          = 0;
+#ifdef MATH_SIMD_SSE
+        // Four boxes at a time: their bounds are transposed into one register per coordinate, and every plane is
+        // tested against all four. The rest is left to the scalar test.
+        static_assert(sizeof(math_AABB) == 6 * sizeof(float), "Boxes are loaded as six packed floats");
+        __m128 normal[6][3], absNormal[6][3], offset[6];
+        for (int plane = 0; plane < 6; ++plane) {
+            for (int axis = 0; axis < 3; ++axis) {
+                normal[plane][axis]    = _mm_set1_ps(frustum.planes[plane][axis]);
+                absNormal[plane][axis] = _mm_set1_ps(fabsf(frustum.planes[plane][axis]));
+            }
+            offset[plane] = _mm_set1_ps(frustum.planes[plane].w);
+        }
+
+        const __m128 half = _mm_set1_ps(0.5f);
+        for (; i + 4 <= numBoxes; i += 4) {
+            // Each box's floats 0-3 (min, max.x) and 2-5 (min.z, max), transposed to one register per coordinate
+            const float* bounds = reinterpret_cast<const float*>(boxes + i);
+            __m128       minX   = _mm_loadu_ps(bounds);
+            __m128       minY   = _mm_loadu_ps(bounds + 6);
+            __m128       minZ   = _mm_loadu_ps(bounds + 12);
+            __m128       maxX   = _mm_loadu_ps(bounds + 18);
+            __m128       minZ2  = _mm_loadu_ps(bounds + 2);
+            __m128       maxX2  = _mm_loadu_ps(bounds + 8);
+            __m128       maxY   = _mm_loadu_ps(bounds + 14);
+            __m128       maxZ   = _mm_loadu_ps(bounds + 20);
+            _MM_TRANSPOSE4_PS(minX, minY, minZ, maxX);
+            _MM_TRANSPOSE4_PS(minZ2, maxX2, maxY, maxZ);
+
+            const __m128 center[3]  = {_mm_mul_ps(_mm_add_ps(minX, maxX), half),
+                                       _mm_mul_ps(_mm_add_ps(minY, maxY), half),
+                                       _mm_mul_ps(_mm_add_ps(minZ, maxZ), half)};
+            const __m128 extents[3] = {_mm_mul_ps(_mm_sub_ps(maxX, minX), half),
+                                       _mm_mul_ps(_mm_sub_ps(maxY, minY), half),
+                                       _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half)};
+
+            // Summed in the same order as the scalar test, so both agree on boxes touching a plane
+            __m128 outside = _mm_setzero_ps();
+            for (int plane = 0; plane < 6; ++plane) {
+                __m128 distance = _mm_add_ps(_mm_mul_ps(normal[plane][0], center[0]), _mm_mul_ps(normal[plane][1], center[1]));
+                distance        = _mm_add_ps(_mm_add_ps(distance, _mm_mul_ps(normal[plane][2], center[2])), offset[plane]);
+                __m128 radius   = _mm_add_ps(_mm_mul_ps(absNormal[plane][0], extents[0]), _mm_mul_ps(absNormal[plane][1], extents[1]));
+                radius          = _mm_add_ps(radius, _mm_mul_ps(absNormal[plane][2], extents[2]));
+                outside         = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+            }
+
+            int outsideMask = _mm_movemask_ps(outside);
+            for (int lane = 0; lane < 4; ++lane) {
+                visible[i + lane] = (outsideMask >> lane & 1) == 0 ? 1 : 0;
+                numVisible += visible[i + lane];
+            }
+        }
+#endif
+        for (; i < numBoxes; ++i) {
+            visible[i] = math_Frustum_IntersectsAABB(frustum, boxes[i]) ? 1 : 0;
+            numVisible += visible[i];
+        }
+        return numVisible;
+    }
+} // namespace pge
+
+#endif
@@ -57,12 +57,43 @@ namespace pge
             tmin = tzmin;
         if (tzmax < tmax)
             tmax = tzmax;
+        if (tmax < 0) // Behind the ray
+            return false;
 
         if (distance != nullptr)
             *distance = tmin;
         return true;
     }
 
+    // Moller-Trumbore, hits both faces. The distance is along the ray, in units of its direction's length.
+    constexpr bool
+    math_Raycast_IntersectsTriangle(const math_Ray& ray, const math_Vec3& a, const math_Vec3& b, const math_Vec3& c, float* distance)
+    {
+        const math_Vec3 edge1 = b - a;
+        const math_Vec3 edge2 = c - a;
+        const math_Vec3 p     = math_Cross(ray.direction, edge2);
+        const float     det   = math_Dot(edge1, p);
+        if (det == 0)
+            return false;
+
+        const float     invDet = 1.0f / det;
+        const math_Vec3 s      = ray.origin - a;
+        const float     u      = math_Dot(s, p) * invDet;
+        if (u < 0 || u > 1)
+            return false;
+        const math_Vec3 q = math_Cross(s, edge1);
+        const float     v = math_Dot(ray.direction, q) * invDet;
+        if (v < 0 || u + v > 1)
+            return false;
+        const float t = math_Dot(edge2, q) * invDet;
+        if (t < 0)
+            return false;
+
+        if (distance != nullptr)
+            *distance = t;
+        return true;
+    }
+
     constexpr math_Vec3
     math_Raycast_Unproject(const math_Vec3& pixel, const math_Vec2& windowSize, const math_Mat4x4& viewProjInv)
     {
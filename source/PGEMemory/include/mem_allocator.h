@@ -0,0 +1,67 @@
+#ifndef PGE_MEMORY_MEM_ALLOCATOR_H
+#define PGE_MEMORY_MEM_ALLOCATOR_H
+
+#include "mem_frame_arena.h"
+#include <string>
+#include <vector>
+
+namespace pge
+{
+    // STL allocator that takes its memory from a frame arena. Deallocation is a no-op; the memory is
+    // reclaimed when the arena cycles, so containers using it must not outlive the next frame.
+    template <typename T>
+    class mem_ArenaAllocator {
+        template <typename U>
+        friend class mem_ArenaAllocator;
+
+        mem_FrameArena* m_arena;
+
+    public:
+        using value_type = T;
+
+        explicit mem_ArenaAllocator(mem_FrameArena* arena)
+            : m_arena(arena)
+        {}
+
+        template <typename U>
+        mem_ArenaAllocator(const mem_ArenaAllocator<U>& other)
+            : m_arena(other.m_arena)
+        {}
+
+        T*
+        allocate(size_t count)
+        {
+            return static_cast<T*>(m_arena->Allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        void
+        deallocate(T*, size_t)
+        {}
+
+        mem_FrameArena*
+        GetArena() const
+        {
+            return m_arena;
+        }
+
+        template <typename U>
+        bool
+        operator==(const mem_ArenaAllocator<U>& rhs) const
+        {
+            return m_arena == rhs.m_arena;
+        }
+
+        template <typename U>
+        bool
+        operator!=(const mem_ArenaAllocator<U>& rhs) const
+        {
+            return m_arena != rhs.m_arena;
+        }
+    };
+
+    template <typename T>
+    using mem_FrameVector = std::vector<T, mem_ArenaAllocator<T>>;
+    using mem_FrameString = std::basic_string<char, std::char_traits<char>, mem_ArenaAllocator<char>>;
+} // namespace pge
+
+#endif
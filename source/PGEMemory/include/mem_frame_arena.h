@@ -0,0 +1,72 @@
+#ifndef PGE_MEMORY_MEM_FRAME_ARENA_H
+#define PGE_MEMORY_MEM_FRAME_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace pge
+{
+    // ----------------------------------------------
+    // mem_LinearArena
+    // ----------------------------------------------
+    // Bump allocator: allocating advances an offset, and everything is released at once by Reset.
+    // Allocate is thread-safe. When the block is exhausted, allocations overflow onto the heap until the next Reset.
+    class mem_LinearArena {
+        char*               m_block;
+        size_t              m_capacity;
+        std::atomic<size_t> m_offset;
+        std::vector<void*>  m_overflow;
+        std::mutex          m_overflowMutex;
+
+        mem_LinearArena(const mem_LinearArena& other) = delete;
+        mem_LinearArena& operator=(const mem_LinearArena& rhs) = delete;
+
+    public:
+        explicit mem_LinearArena(size_t capacity);
+        ~mem_LinearArena();
+
+        void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+        void  Reset();
+
+        size_t GetCapacity() const;
+        size_t GetUsed() const;
+        size_t GetNumOverflows() const;
+        bool   Owns(const void* ptr) const;
+    };
+
+    // ----------------------------------------------
+    // mem_FrameArena
+    // ----------------------------------------------
+    // Two linear arenas that alternate every frame. Data allocated during a frame stays valid through the next one,
+    // so a consumer that lags one frame behind (e.g. render submission) can still read it.
+    class mem_FrameArena {
+        mem_LinearArena m_arenas[2];
+        unsigned        m_current;
+
+    public:
+        explicit mem_FrameArena(size_t capacityPerFrame);
+
+        // Makes the older arena current and resets it.
+        void NextFrame();
+
+        void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        template <typename T>
+        T*
+        AllocateArray(size_t count)
+        {
+            T* data = static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+            for (size_t i = 0; i < count; ++i)
+                new (&data[i]) T();
+            return data;
+        }
+
+        const mem_LinearArena& GetCurrent() const;
+        const mem_LinearArena& GetPrevious() const;
+    };
+} // namespace pge
+
+#endif
@@ -0,0 +1,128 @@
+#include "../include/mem_frame_arena.h"
+#include <core_assert.h>
+#include <core_log.h>
+#include <cstdlib>
+#include <cstdint>
+
+namespace pge
+{
+    // ----------------------------------------------
+    // mem_LinearArena
+    // ----------------------------------------------
+    mem_LinearArena::mem_LinearArena(size_t capacity)
+        : m_block(static_cast<char*>(malloc(capacity)))
+        , m_capacity(capacity)
+        , m_offset(0)
+    {
+        core_Assert(m_block != nullptr);
+    }
+
+    mem_LinearArena::~mem_LinearArena()
+    {
+        Reset();
+        free(m_block);
+    }
+
+    void*
+    mem_LinearArena::Allocate(size_t size, size_t alignment)
+    {
+        core_Assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+        const uintptr_t base   = reinterpret_cast<uintptr_t>(m_block);
+        size_t          offset = m_offset.load(std::memory_order_relaxed);
+        for (;;) {
+            const size_t aligned = ((base + offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+            const size_t end     = aligned + size;
+            if (end > m_capacity)
+                break;
+            if (m_offset.compare_exchange_weak(offset, end, std::memory_order_relaxed))
+                return m_block + aligned;
+        }
+
+        // Out of space, serve it from the heap until the next reset
+        void* ptr = nullptr;
+#ifdef _WIN32
+        ptr = _aligned_malloc(size, alignment);
+#else
+        ptr = aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+#endif
+        core_Assert(ptr != nullptr);
+        std::lock_guard<std::mutex> lock(m_overflowMutex);
+        m_overflow.push_back(ptr);
+        return ptr;
+    }
+
+    void
+    mem_LinearArena::Reset()
+    {
+        if (!m_overflow.empty()) {
+            core_LogWarningf("Linear arena of %zu bytes overflowed %zu times", m_capacity, m_overflow.size());
+        }
+        for (void* ptr : m_overflow) {
+#ifdef _WIN32
+            _aligned_free(ptr);
+#else
+            free(ptr);
+#endif
+        }
+        m_overflow.clear();
+        m_offset.store(0, std::memory_order_relaxed);
+    }
+
+    size_t
+    mem_LinearArena::GetCapacity() const
+    {
+        return m_capacity;
+    }
+
+    size_t
+    mem_LinearArena::GetUsed() const
+    {
+        return m_offset.load(std::memory_order_relaxed);
+    }
+
+    size_t
+    mem_LinearArena::GetNumOverflows() const
+    {
+        return m_overflow.size();
+    }
+
+    bool
+    mem_LinearArena::Owns(const void* ptr) const
+    {
+        const char* p = static_cast<const char*>(ptr);
+        return p >= m_block && p < m_block + m_capacity;
+    }
+
+    // ----------------------------------------------
+    // mem_FrameArena
+    // ----------------------------------------------
+    mem_FrameArena::mem_FrameArena(size_t capacityPerFrame)
+        : m_arenas{mem_LinearArena(capacityPerFrame), mem_LinearArena(capacityPerFrame)}
+        , m_current(0)
+    {}
+
+    void
+    mem_FrameArena::NextFrame()
+    {
+        m_current ^= 1;
+        m_arenas[m_current].Reset();
+    }
+
+    void*
+    mem_FrameArena::Allocate(size_t size, size_t alignment)
+    {
+        return m_arenas[m_current].Allocate(size, alignment);
+    }
+
+    const mem_LinearArena&
+    mem_FrameArena::GetCurrent() const
+    {
+        return m_arenas[m_current];
+    }
+
+    const mem_LinearArena&
+    mem_FrameArena::GetPrevious() const
+    {
+        return m_arenas[m_current ^ 1];
+    }
+} // namespace pge
@@ -10,6 +10,7 @@
 #include <math_vec2.h>
 #include <math_vec3.h>
 #include <math_aabb.h>
+#include "res_mesh_bvh.h"
 
 namespace pge
 {
@@ -113,6 +114,7 @@ namespace pge
         size_t                   m_numTriangles;
         math_AABB                m_aabb;
         std::vector<math_Mat4x4> m_boneMatrices;
+        res_MeshBVH              m_bvh; // Of the triangles in bind pose
 
     public:
         res_Mesh(gfx_GraphicsAdapter*       graphicsAdapter,
@@ -134,6 +136,7 @@ namespace pge
         math_AABB                       GetAABB() const;
         std::string                     GetPath() const;
         const std::vector<math_Mat4x4>& GetBoneOffsetMatrices() const;
+        const res_MeshBVH&              GetBVH() const;
     };
 
     class res_MeshCache {
@@ -0,0 +1,53 @@
+#ifndef PGE_RESOURCE_RES_MESH_BVH_H
+#define PGE_RESOURCE_RES_MESH_BVH_H
+
+#include <math_raycasting.h>
+#include <cstdint>
+#include <vector>
+
+namespace pge
+{
+    struct res_MeshBVHHit {
+        float    distance; // Along the ray, in units of its direction's length
+        unsigned triangle; // Index into the mesh's triangles
+    };
+
+    // Bounding volume hierarchy over the triangles of a mesh in its local space, for raycasts against the actual
+    // geometry. Built top-down with binned surface area heuristic splits. The nodes are stored depth-first, so a
+    // node's first child follows it directly, and leaves hold a range of triangles copied in node order.
+    class res_MeshBVH {
+        struct Node {
+            math_AABB bounds;
+            uint32_t  first; // Second child for an inner node, first triangle for a leaf
+            uint32_t  count; // Triangles in a leaf, 0 for an inner node
+        };
+
+        struct Triangle {
+            math_Vec3 vertices[3];
+        };
+
+        std::vector<Node>     m_nodes;
+        std::vector<Triangle> m_triangles;
+        std::vector<unsigned> m_triangleIds; // Of the triangles as indexed by the mesh
+
+        template <bool AnyHit>
+        bool Traverse(const math_Ray& ray, float maxDistance, res_MeshBVHHit* hit) const;
+
+    public:
+        res_MeshBVH() = default;
+        // The position is the first attribute of every vertex, three floats.
+        res_MeshBVH(const char* vertexData, size_t vertexStride, const unsigned* indexData, size_t numTriangles);
+
+        size_t    GetNumNodes() const;
+        size_t    GetNumTriangles() const;
+        size_t    GetSizeInBytes() const;
+        math_AABB GetBounds() const;
+
+        // The closest triangle the ray hits within maxDistance.
+        bool Raycast(const math_Ray& ray, float maxDistance, res_MeshBVHHit* hit) const;
+        // Whether the ray hits any triangle within maxDistance, which stops at the first one found.
+        bool RaycastAny(const math_Ray& ray, float maxDistance) const;
+    };
+} // namespace pge
+
+#endif
@@ -17,7 +17,7 @@ namespace pge
 
     class res_Skeleton {
         std::string                    m_path;
-        std::unique_ptr<anim_Skeleton> m_skeleton;
+        std::unique_ptr<anim_SkeletonDef> m_skeleton;
 
         void MakeSkeleton(res_Bone* bones, unsigned numBones);
 
@@ -25,9 +25,9 @@ namespace pge
         res_Skeleton(res_Bone* bones, unsigned numBones);
         res_Skeleton(const char* path);
 
-        void                 Write(std::ostream& os) const;
-        const char*          GetPath() const;
-        const anim_Skeleton* GetSkeleton() const;
+        void                    Write(std::ostream& os) const;
+        const char*             GetPath() const;
+        const anim_SkeletonDef* GetSkeleton() const;
     };
 
     class res_SkeletonCache {
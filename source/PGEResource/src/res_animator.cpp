@@ -14,8 +14,8 @@ namespace pge
         is >> json;
         is.close();
 
-        std::string          skelPath = json["skeleton"];
-        const anim_Skeleton* skeleton = skeletonCache->Load(skelPath.c_str())->GetSkeleton();
+        std::string             skelPath = json["skeleton"];
+        const anim_SkeletonDef* skeleton = skeletonCache->Load(skelPath.c_str())->GetSkeleton();
 
         std::vector<anim_AnimationState> states;
         auto                             jstates = json["animation_states"];
@@ -228,6 +228,7 @@ namespace pge
         core_AssertWithReason(strcmp(attributes[0].Name(), "POSITION") == 0, "The position has to be the first attribute!");
         size_t numVertices = vertexDataSize / m_vertexStride;
         m_aabb             = math_AABB(reinterpret_cast<const char*>(vertexData), numVertices, m_vertexStride, 0);
+        m_bvh              = res_MeshBVH(reinterpret_cast<const char*>(vertexData), m_vertexStride, indexData, m_numTriangles);
 
         // Copy the bone offset matrices
         m_boneMatrices.resize(numBones);
@@ -244,6 +245,7 @@ namespace pge
         , m_numTriangles(other.m_numTriangles)
         , m_aabb(other.m_aabb)
         , m_boneMatrices(std::move(other.m_boneMatrices))
+        , m_bvh(std::move(other.m_bvh))
     {}
 
     res_Mesh::res_Mesh(pge::gfx_GraphicsAdapter* graphicsAdapter, const res_SerializedMesh& smesh)
@@ -255,6 +257,7 @@ namespace pge
         , m_numTriangles(smesh.GetNumTriangles())
         , m_aabb(smesh.GetAABB())
         , m_boneMatrices(smesh.GetBoneOffsetMatrices())
+        , m_bvh(smesh.GetVertexData(), smesh.GetVertexStride(), smesh.GetTriangleData(), smesh.GetNumTriangles())
     {}
 
     res_Mesh::res_Mesh(pge::gfx_GraphicsAdapter* graphicsAdapter, const char* path)
@@ -293,6 +296,12 @@ namespace pge
         return m_boneMatrices;
     }
 
+    const res_MeshBVH&
+    res_Mesh::GetBVH() const
+    {
+        return m_bvh;
+    }
+
     // ---------------------------------
     // res_MeshCache
     // ---------------------------------
@@ -0,0 +1,289 @@
+#include "../include/res_mesh_bvh.h"
+#include <core_assert.h>
+#include <algorithm>
+#include <cfloat>
+
+namespace pge
+{
+    static const unsigned NUM_BINS       = 16;
+    static const unsigned MAX_LEAF_SIZE  = 16;   // Larger leaves are split even when the heuristic says otherwise
+    static const unsigned MAX_DEPTH      = 48;   // Bounds the traversal stack
+    static const float    TRAVERSAL_COST = 1.0f; // Relative to testing one triangle
+
+    static void
+    Grow(math_AABB* box, const math_AABB& other)
+    {
+        box->min = math_Vec3(std::min(box->min.x, other.min.x), std::min(box->min.y, other.min.y), std::min(box->min.z, other.min.z));
+        box->max = math_Vec3(std::max(box->max.x, other.max.x), std::max(box->max.y, other.max.y), std::max(box->max.z, other.max.z));
+    }
+
+    static math_AABB
+    EmptyBox()
+    {
+        return math_AABB(math_Vec3(FLT_MAX, FLT_MAX, FLT_MAX), math_Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+    }
+
+    static float
+    HalfArea(const math_AABB& box)
+    {
+        const math_Vec3 size = box.max - box.min;
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+
+    // Distance along the ray to where it enters the box, or FLT_MAX if it misses it within maxDistance
+    static float
+    IntersectBox(const math_AABB& box, const math_Vec3& origin, const math_Vec3& invDir, float maxDistance)
+    {
+        float tmin = 0, tmax = maxDistance;
+        for (int axis = 0; axis < 3; ++axis) {
+            float t0 = (box.min[axis] - origin[axis]) * invDir[axis];
+            float t1 = (box.max[axis] - origin[axis]) * invDir[axis];
+            tmin     = std::max(tmin, std::min(t0, t1));
+            tmax     = std::min(tmax, std::max(t0, t1));
+        }
+        return tmin <= tmax ? tmin : FLT_MAX;
+    }
+
+    namespace
+    {
+        struct Builder {
+            std::vector<math_AABB> bounds;    // Per triangle
+            std::vector<math_Vec3> centroids; // Per triangle
+            std::vector<unsigned>  order;     // Triangles, partitioned into the leaves
+        };
+
+        struct Bin {
+            math_AABB bounds;
+            unsigned  count;
+        };
+    } // namespace
+
+    template <typename Node>
+    static void
+    BuildNode(Builder* builder, std::vector<Node>* nodes, size_t nodeIndex, unsigned begin, unsigned end, unsigned depth)
+    {
+        math_AABB bounds         = EmptyBox();
+        math_AABB centroidBounds = EmptyBox();
+        for (unsigned i = begin; i < end; ++i) {
+            const unsigned triangle = builder->order[i];
+            Grow(&bounds, builder->bounds[triangle]);
+            Grow(&centroidBounds, math_AABB(builder->centroids[triangle], builder->centroids[triangle]));
+        }
+        (*nodes)[nodeIndex].bounds = bounds;
+        (*nodes)[nodeIndex].first  = begin;
+        (*nodes)[nodeIndex].count  = end - begin;
+
+        const unsigned count = end - begin;
+        if (count <= 2 || depth >= MAX_DEPTH)
+            return;
+
+        // Bin the centroids along each axis, and find the cheapest split between two bins
+        float    bestCost = FLT_MAX;
+        int      bestAxis = -1;
+        unsigned bestBin  = 0;
+        for (int axis = 0; axis < 3; ++axis) {
+            const float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+            if (extent <= 0)
+                continue;
+            const float scale = NUM_BINS / extent;
+
+            Bin bins[NUM_BINS];
+            for (Bin& bin : bins)
+                bin = Bin{EmptyBox(), 0};
+            for (unsigned i = begin; i < end; ++i) {
+                const unsigned triangle = builder->order[i];
+                const unsigned bin      = std::min(NUM_BINS - 1, static_cast<unsigned>((builder->centroids[triangle][axis] - centroidBounds.min[axis]) * scale));
+                Grow(&bins[bin].bounds, builder->bounds[triangle]);
+                bins[bin].count++;
+            }
+
+            // Sweep from the right to get the cost of everything right of each split, then from the left
+            float     rightArea[NUM_BINS];
+            unsigned  rightCount[NUM_BINS];
+            math_AABB rightBounds = EmptyBox();
+            unsigned  numRight    = 0;
+            for (unsigned bin = NUM_BINS - 1; bin > 0; --bin) {
+                Grow(&rightBounds, bins[bin].bounds);
+                numRight += bins[bin].count;
+                rightArea[bin]  = numRight > 0 ? HalfArea(rightBounds) : 0;
+                rightCount[bin] = numRight;
+            }
+            math_AABB leftBounds = EmptyBox();
+            unsigned  numLeft    = 0;
+            for (unsigned bin = 0; bin < NUM_BINS - 1; ++bin) {
+                Grow(&leftBounds, bins[bin].bounds);
+                numLeft += bins[bin].count;
+                if (numLeft == 0 || rightCount[bin + 1] == 0)
+                    continue;
+                float cost = HalfArea(leftBounds) * numLeft + rightArea[bin + 1] * rightCount[bin + 1];
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin  = bin;
+                }
+            }
+        }
+        if (bestAxis < 0)
+            return; // All centroids coincide
+
+        const float leafCost  = static_cast<float>(count);
+        const float splitCost = TRAVERSAL_COST + bestCost / HalfArea(bounds);
+        if (splitCost >= leafCost && count <= MAX_LEAF_SIZE)
+            return;
+
+        const float scale = NUM_BINS / (centroidBounds.max[bestAxis] - centroidBounds.min[bestAxis]);
+        auto        split = std::partition(builder->order.begin() + begin, builder->order.begin() + end, [&](unsigned triangle) {
+            unsigned bin = std::min(NUM_BINS - 1, static_cast<unsigned>((builder->centroids[triangle][bestAxis] - centroidBounds.min[bestAxis]) * scale));
+            return bin <= bestBin;
+        });
+        const unsigned middle = static_cast<unsigned>(split - builder->order.begin());
+        core_Assert(middle > begin && middle < end);
+
+        // Depth-first: the left child directly follows its parent
+        const size_t left = nodes->size();
+        nodes->push_back(Node());
+        BuildNode(builder, nodes, left, begin, middle, depth + 1);
+        const size_t right = nodes->size();
+        nodes->push_back(Node());
+        BuildNode(builder, nodes, right, middle, end, depth + 1);
+
+        (*nodes)[nodeIndex].first = static_cast<uint32_t>(right);
+        (*nodes)[nodeIndex].count = 0;
+    }
+
+    res_MeshBVH::res_MeshBVH(const char* vertexData, size_t vertexStride, const unsigned* indexData, size_t numTriangles)
+    {
+        if (numTriangles == 0)
+            return;
+
+        m_triangles.resize(numTriangles);
+        Builder builder;
+        builder.bounds.resize(numTriangles);
+        builder.centroids.resize(numTriangles);
+        builder.order.resize(numTriangles);
+        for (size_t i = 0; i < numTriangles; ++i) {
+            for (size_t j = 0; j < 3; ++j) {
+                const float* position      = reinterpret_cast<const float*>(vertexData + indexData[i * 3 + j] * vertexStride);
+                m_triangles[i].vertices[j] = math_Vec3(position[0], position[1], position[2]);
+            }
+            builder.bounds[i]    = math_AABB(m_triangles[i].vertices, 3);
+            builder.centroids[i] = (m_triangles[i].vertices[0] + m_triangles[i].vertices[1] + m_triangles[i].vertices[2]) / 3.0f;
+            builder.order[i]     = static_cast<unsigned>(i);
+        }
+
+        m_nodes.reserve(numTriangles / 2 + 1);
+        m_nodes.push_back(Node());
+        BuildNode(&builder, &m_nodes, 0, 0, static_cast<unsigned>(numTriangles), 0);
+        m_nodes.shrink_to_fit();
+
+        // Store the triangles in leaf order, so a leaf tests a contiguous range
+        std::vector<Triangle> unordered;
+        unordered.swap(m_triangles);
+        m_triangles.resize(numTriangles);
+        m_triangleIds = builder.order;
+        for (size_t i = 0; i < numTriangles; ++i)
+            m_triangles[i] = unordered[m_triangleIds[i]];
+    }
+
+    size_t
+    res_MeshBVH::GetNumNodes() const
+    {
+        return m_nodes.size();
+    }
+
+    size_t
+    res_MeshBVH::GetNumTriangles() const
+    {
+        return m_triangles.size();
+    }
+
+    size_t
+    res_MeshBVH::GetSizeInBytes() const
+    {
+        return m_nodes.size() * sizeof(Node) + m_triangles.size() * sizeof(Triangle) + m_triangleIds.size() * sizeof(unsigned);
+    }
+
+    math_AABB
+    res_MeshBVH::GetBounds() const
+    {
+        return m_nodes.empty() ? math_AABB() : m_nodes[0].bounds;
+    }
+
+    template <bool AnyHit>
+    bool
+    res_MeshBVH::Traverse(const math_Ray& ray, float maxDistance, res_MeshBVHHit* hit) const
+    {
+        if (m_nodes.empty())
+            return false;
+
+        const math_Vec3 invDir(1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z);
+        float           closest  = maxDistance;
+        unsigned        triangle = 0;
+        bool            found    = false;
+
+        uint32_t stack[MAX_DEPTH + 1];
+        unsigned stackSize = 0;
+        uint32_t node      = 0;
+        if (IntersectBox(m_nodes[0].bounds, ray.origin, invDir, closest) == FLT_MAX)
+            return false;
+        for (;;) {
+            const Node& current = m_nodes[node];
+            if (current.count > 0) {
+                for (uint32_t i = current.first; i < current.first + current.count; ++i) {
+                    const math_Vec3* vertices = m_triangles[i].vertices;
+                    float            distance = 0;
+                    if (math_Raycast_IntersectsTriangle(ray, vertices[0], vertices[1], vertices[2], &distance) && distance <= closest) {
+                        closest  = distance;
+                        triangle = i;
+                        found    = true;
+                        if (AnyHit)
+                            return true;
+                    }
+                }
+            } else {
+                // Visit the nearer child first, and skip children farther than the closest hit so far
+                uint32_t nearChild = node + 1;
+                uint32_t farChild  = current.first;
+                float    nearDist  = IntersectBox(m_nodes[nearChild].bounds, ray.origin, invDir, closest);
+                float    farDist   = IntersectBox(m_nodes[farChild].bounds, ray.origin, invDir, closest);
+                if (farDist < nearDist) {
+                    std::swap(nearChild, farChild);
+                    std::swap(nearDist, farDist);
+                }
+                if (nearDist != FLT_MAX) {
+                    if (farDist != FLT_MAX)
+                        stack[stackSize++] = farChild;
+                    node = nearChild;
+                    continue;
+                }
+            }
+
+            // Pop the next node that can still hold a closer hit
+            bool next = false;
+            while (stackSize > 0 && !next) {
+                node = stack[--stackSize];
+                next = IntersectBox(m_nodes[node].bounds, ray.origin, invDir, closest) != FLT_MAX;
+            }
+            if (!next)
+                break;
+        }
+
+        if (found && hit != nullptr) {
+            hit->distance = closest;
+            hit->triangle = m_triangleIds[triangle];
+        }
+        return found;
+    }
+
+    bool
+    res_MeshBVH::Raycast(const math_Ray& ray, float maxDistance, res_MeshBVHHit* hit) const
+    {
+        return Traverse<false>(ray, maxDistance, hit);
+    }
+
+    bool
+    res_MeshBVH::RaycastAny(const math_Ray& ray, float maxDistance) const
+    {
+        return Traverse<true>(ray, maxDistance, nullptr);
+    }
+} // namespace pge
@@ -1,5 +1,7 @@
 #include "../include/res_skeleton.h"
 #include <fstream>
+#include <anim_compression.h>
+#include <cstring>
 
 namespace pge
 {
@@ -46,11 +48,10 @@ namespace pge
             anim_SkeletonBone bone;
             strcpy_s(bone.name, sizeof(bone.name), resBone.name.c_str());
             bone.localTransform = resBone.transform;
-            bone.worldTransform = resBone.transform;
             bone.parentIdx      = resBone.parent;
             sbones.emplace_back(bone);
         }
-        m_skeleton = std::make_unique<anim_Skeleton>(&sbones[0], numBones);
+        m_skeleton = std::make_unique<anim_SkeletonDef>(&sbones[0], numBones);
     }
 
     res_Skeleton::res_Skeleton(res_Bone* bones, unsigned numBones)
@@ -107,7 +108,7 @@ namespace pge
         return m_path.c_str();
     }
 
-    const anim_Skeleton*
+    const anim_SkeletonDef*
     res_Skeleton::GetSkeleton() const
     {
         return m_skeleton.get();
@@ -148,7 +149,13 @@ namespace pge
     {
         std::ifstream is(path, std::ios::binary);
         core_Assert(is.is_open());
-        m_animation = std::make_unique<anim_SkeletonAnimation>(is);
+        // Compressed clips (.skelanimc, written by ModelConvert) stay compressed and are sampled as they play
+        const size_t pathLen = strlen(path);
+        if (pathLen > 10 && strcmp(path + pathLen - 10, ".skelanimc") == 0) {
+            m_animation = std::make_unique<anim_SkeletonAnimation>(std::make_shared<const anim_CompressedAnimation>(is));
+        } else {
+            m_animation = std::make_unique<anim_SkeletonAnimation>(is);
+        }
     }
 
     void
@@ -8,6 +8,9 @@
 #include <input_keyboard.h>
 
 class EntityBehaviour : public pge::game_Behaviour {
+    static constexpr pge::anim_TriggerId TRIGGER_MOVE_START = pge::anim_HashTrigger("move_start");
+    static constexpr pge::anim_TriggerId TRIGGER_MOVE_STOP  = pge::anim_HashTrigger("move_stop");
+
     pge::game_Entity            m_entity;
     pge::game_TransformManager* m_transformManager;
     pge::game_AnimationManager* m_animManager;
@@ -42,12 +45,12 @@ public:
         if (pge::math_LengthSquared(movement) > 0) {
             movement = pge::math_Normalize(movement);
             if (!wasMoving) {
-                m_animManager->Trigger("move_start");
+                m_animManager->Trigger(TRIGGER_MOVE_START);
                 wasMoving = true;
             }
             m_transformManager->SetLocalForward(tid, pge::math_Normalize(movement), pge::math_Vec3(0, 0, 1));
         } else if (wasMoving) {
-            m_animManager->Trigger("move_stop");
+            m_animManager->Trigger(TRIGGER_MOVE_STOP);
             wasMoving = false;
         }
 
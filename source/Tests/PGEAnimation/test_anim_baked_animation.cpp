@@ -0,0 +1,173 @@
+#include <gtest/gtest.h>
+#include <anim_baked_animation.h>
+#include <anim_pose.h>
+#include <math_interp.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+using namespace pge;
+
+static anim_SkeletonAnimationChannel
+CreateSmoothChannel(const char* boneName, double duration, float phase)
+{
+    std::vector<anim_KeyVec3> positionKeys, scaleKeys;
+    std::vector<anim_KeyQuat> rotationKeys;
+    for (double time = 0; time <= duration + 1e-9; time += 1.0 / 60) {
+        const float t = float(time) + phase;
+        positionKeys.push_back({math_Vec3(0.1f * sinf(t * 3.0f), 1.0f, 0.1f * cosf(t * 2.0f)), time});
+        scaleKeys.push_back({math_Vec3(1, 1, 1), time});
+        rotationKeys.push_back({math_QuatFromAxisAngle(math_Normalize(math_Vec3(1, sinf(t), 0.5f)), 30.0f * sinf(t * 1.5f)), time});
+    }
+    return anim_SkeletonAnimationChannel(boneName,
+                                         positionKeys.data(),
+                                         positionKeys.size(),
+                                         scaleKeys.data(),
+                                         scaleKeys.size(),
+                                         rotationKeys.data(),
+                                         rotationKeys.size());
+}
+
+// A branching skeleton with a channel and a bind offset per bone
+struct TestCharacter {
+    std::vector<anim_SkeletonBone>             bones;
+    std::vector<anim_SkeletonAnimationChannel> channels;
+    std::vector<math_Mat4x4>                   offsets;
+
+    TestCharacter(unsigned numBones, double duration)
+        : bones(numBones)
+    {
+        for (unsigned i = 0; i < numBones; ++i) {
+            sprintf(bones[i].name, "bone%u", i);
+            bones[i].localTransform = math_Mat4x4::Identity();
+            bones[i].parentIdx      = static_cast<int>(i) - 1 - static_cast<int>(i % 3 == 2);
+            channels.push_back(CreateSmoothChannel(bones[i].name, duration, 0.4f * i));
+            offsets.push_back(math_CreateTranslationMatrix(math_Vec3(0, -1.0f * i, 0)));
+        }
+    }
+};
+
+static float
+MaxDifference(const math_Mat4x4* a, const math_Mat4x4* b, size_t count)
+{
+    float maxDifference = 0;
+    for (size_t i = 0; i < count * 16; ++i)
+        maxDifference = std::max(maxDifference, fabsf(a[0].values[i] - b[0].values[i]));
+    return maxDifference;
+}
+
+static void
+ComputePalette(const anim_SkeletonAnimation& animation, const anim_AnimationBinding& binding, const math_Mat4x4* offsets, double time, anim_Pose* pose, math_Mat4x4* palette)
+{
+    pose->SetBindPose();
+    pose->Animate(animation, binding, time);
+    pose->ComputeWorldTransforms();
+    anim_ComputeSkinningPalette(*pose, offsets, palette);
+}
+
+TEST(anim_BakedAnimation, MatchesEvaluatedPalettes)
+{
+    TestCharacter          character(12, 2.0);
+    anim_SkeletonDef       skeleton(character.bones.data(), character.bones.size());
+    anim_SkeletonAnimation animation("clip", 2.0, character.channels.data(), character.channels.size());
+    anim_AnimationBinding  binding(skeleton, animation);
+    anim_Pose              pose(&skeleton);
+
+    anim_BakedAnimation baked(skeleton, animation, character.offsets.data(), 30.0f);
+    EXPECT_EQ(baked.GetAnimation(), &animation);
+    EXPECT_EQ(baked.GetFrameCount(), 61u);
+    EXPECT_EQ(baked.GetSizeInBytes(), 61u * 12 * sizeof(math_Mat4x4));
+
+    std::vector<math_Mat4x4> expected(12), palette(12);
+    for (unsigned frame = 0; frame < baked.GetFrameCount(); frame += 7) {
+        ComputePalette(animation, binding, character.offsets.data(), frame / 30.0, &pose, expected.data());
+        EXPECT_LE(MaxDifference(baked.GetPalette(frame), expected.data(), 12), 1e-4f) << "frame " << frame;
+        baked.Sample(frame / 30.0 + 0.01, false, palette.data());
+        EXPECT_LE(MaxDifference(palette.data(), expected.data(), 12), 1e-4f) << "frame " << frame;
+    }
+
+    // Between frames, interpolation stays close to evaluating the clip
+    for (double time = 0.02; time < 2.0; time += 0.13) {
+        ComputePalette(animation, binding, character.offsets.data(), time, &pose, expected.data());
+        baked.Sample(time, true, palette.data());
+        EXPECT_LE(MaxDifference(palette.data(), expected.data(), 12), 0.02f) << "time " << time;
+    }
+
+    // Clamped past either end
+    baked.Sample(5.0, true, palette.data());
+    EXPECT_EQ(MaxDifference(palette.data(), baked.GetPalette(60), 12), 0.0f);
+    baked.Sample(-1.0, true, palette.data());
+    EXPECT_EQ(MaxDifference(palette.data(), baked.GetPalette(0), 12), 0.0f);
+}
+
+TEST(anim_BakedAnimation, BoneBoundsHoldEveryFrame)
+{
+    TestCharacter          character(12, 2.0);
+    anim_SkeletonDef       skeleton(character.bones.data(), character.bones.size());
+    anim_SkeletonAnimation animation("clip", 2.0, character.channels.data(), character.channels.size());
+    anim_AnimationBinding  binding(skeleton, animation);
+    anim_Pose              pose(&skeleton);
+    anim_BakedAnimation    baked(skeleton, animation, character.offsets.data(), 30.0f);
+
+    // The bounds are exactly those of the bones over the baked frames
+    math_AABB                expected(math_Vec3(1e9f, 1e9f, 1e9f), math_Vec3(-1e9f, -1e9f, -1e9f));
+    std::vector<math_Mat4x4> palette(12);
+    for (unsigned frame = 0; frame < baked.GetFrameCount(); ++frame) {
+        ComputePalette(animation, binding, character.offsets.data(), std::min(frame / 30.0, 2.0), &pose, palette.data());
+        anim_ExpandBoundsToBones(pose, &expected);
+    }
+    const math_AABB& bounds = baked.GetBoneBounds();
+    for (int j = 0; j < 3; ++j) {
+        EXPECT_NEAR(bounds.min[j], expected.min[j], 1e-4f);
+        EXPECT_NEAR(bounds.max[j], expected.max[j], 1e-4f);
+    }
+    EXPECT_GT(bounds.max.y - bounds.min.y, 1.0f);
+
+    // Bones inside the bounds leave them as they are
+    math_AABB box(math_Vec3(-100, -100, -100), math_Vec3(100, 100, 100));
+    anim_ExpandBoundsToBones(pose, &box);
+    EXPECT_EQ(box.min, math_Vec3(-100, -100, -100));
+    EXPECT_EQ(box.max, math_Vec3(100, 100, 100));
+}
+
+TEST(anim_BakedAnimation, CrowdBenchmark)
+{
+    // 500 characters with a 60 bone skeleton, each at its own time in a 1 s walk cycle
+    const size_t           numCharacters = 500;
+    const int              numFrames     = 100;
+    TestCharacter          character(60, 1.0);
+    anim_SkeletonDef       skeleton(character.bones.data(), character.bones.size());
+    anim_SkeletonAnimation walk("walk", 1.0, character.channels.data(), character.channels.size());
+    anim_AnimationBinding  binding(skeleton, walk);
+    anim_Pose              pose(&skeleton);
+    anim_BakedAnimation    baked(skeleton, walk, character.offsets.data());
+
+    std::vector<math_Mat4x4> palette(60);
+    auto                     run = [&](bool useBaked) {
+        float checksum = 0;
+        auto  start    = std::chrono::high_resolution_clock::now();
+        for (int frame = 0; frame < numFrames; ++frame) {
+            for (size_t i = 0; i < numCharacters; ++i) {
+                double time = fmod(frame / 60.0 + i * 0.0137, 1.0);
+                if (useBaked)
+                    baked.Sample(time, true, palette.data());
+                else
+                    ComputePalette(walk, binding, character.offsets.data(), time, &pose, palette.data());
+                checksum += palette[59][1][3];
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::make_pair(std::chrono::duration<double, std::milli>(end - start).count() / numFrames, checksum);
+    };
+
+    auto evaluated = run(false);
+    auto fromBaked = run(true);
+    EXPECT_NEAR(fromBaked.second / (numFrames * numCharacters), evaluated.second / (numFrames * numCharacters), 0.01f);
+    printf("[ BENCH    ] %zu characters: %.3f ms evaluated, %.3f ms baked, %zu bytes for %u frames\n",
+           numCharacters,
+           evaluated.first,
+           fromBaked.first,
+           baked.GetSizeInBytes(),
+           baked.GetFrameCount());
+}
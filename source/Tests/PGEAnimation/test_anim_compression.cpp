@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+#include <anim_compression.h>
+#include <anim_pose.h>
+#include <math_interp.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+using namespace pge;
+
+// Smooth motion keyed at 60 Hz, with a track that never moves
+static anim_SkeletonAnimationChannel
+CreateSmoothChannel(const char* boneName, double duration, float phase)
+{
+    std::vector<anim_KeyVec3> positionKeys, scaleKeys;
+    std::vector<anim_KeyQuat> rotationKeys;
+    for (double time = 0; time <= duration + 1e-9; time += 1.0 / 60) {
+        const float t = float(time) + phase;
+        positionKeys.push_back({math_Vec3(sinf(t * 3.0f), 0.5f * cosf(t * 2.0f), t), time});
+        scaleKeys.push_back({math_Vec3(1, 1, 1), time});
+        rotationKeys.push_back({math_QuatFromAxisAngle(math_Normalize(math_Vec3(1, sinf(t), 0.5f)), 170.0f * sinf(t * 1.5f)), time});
+    }
+    return anim_SkeletonAnimationChannel(boneName,
+                                         positionKeys.data(),
+                                         positionKeys.size(),
+                                         scaleKeys.data(),
+                                         scaleKeys.size(),
+                                         rotationKeys.data(),
+                                         rotationKeys.size());
+}
+
+static float
+RotationError(const math_Quat& a, const math_Quat& b)
+{
+    return 2.0f * acosf(std::min(1.0f, fabsf(math_Dot(math_Normalize(a), math_Normalize(b)))));
+}
+
+TEST(anim_CompressedAnimation, StaysWithinErrorBounds)
+{
+    anim_SkeletonAnimationChannel channels[2] = {CreateSmoothChannel("root", 2.0, 0.0f), CreateSmoothChannel("arm", 2.0, 1.3f)};
+    anim_SkeletonAnimation        animation("clip", 2.0, channels, 2);
+
+    const anim_CompressionSettings settings(30.0f, 0.001f, 0.002f, 0.001f);
+    anim_CompressedAnimation       compressed(animation, settings);
+    ASSERT_EQ(compressed.GetChannelCount(), 2u);
+    EXPECT_STREQ(compressed.GetBoneName(1), "arm");
+    EXPECT_EQ(compressed.GetDuration(), 2.0);
+
+    // On the grid the bounds hold exactly, between grid frames the source's own keys add some error
+    anim_ChannelCursor cursor;
+    for (int frame = 0; frame <= 60; ++frame) {
+        const double time = frame / 30.0;
+        math_Vec3    position, scale;
+        math_Quat    rotation;
+        compressed.Sample(1, time, &position, &rotation, &scale, &cursor);
+        EXPECT_LE(math_Length(position - channels[1].SamplePosition(time)), settings.translationError) << "frame " << frame;
+        EXPECT_LE(RotationError(rotation, channels[1].SampleRotation(time)), settings.rotationError + 1e-3f) << "frame " << frame;
+        EXPECT_EQ(scale, math_Vec3(1, 1, 1));
+    }
+    for (double time = -0.5; time < 2.5; time += 0.013) {
+        math_Vec3 position, scale;
+        math_Quat rotation;
+        compressed.Sample(0, time, &position, &rotation, &scale);
+        EXPECT_LE(math_Length(position - channels[0].SamplePosition(time)), 0.01f) << "time " << time;
+        EXPECT_LE(RotationError(rotation, channels[0].SampleRotation(time)), 0.01f) << "time " << time;
+    }
+
+    // Each constant scale track keeps a single key, and the smooth tracks need fewer than the 61 grid frames
+    EXPECT_LT(compressed.GetNumKeys(), 2u * (1 + 61 + 61));
+}
+
+TEST(anim_CompressedAnimation, SerializeAndDecompressKeepSamples)
+{
+    anim_SkeletonAnimationChannel channel = CreateSmoothChannel("root", 1.5, 0.4f);
+    anim_SkeletonAnimation        animation("clip", 1.5, &channel, 1);
+    anim_CompressedAnimation      compressed(animation);
+
+    std::stringstream ss;
+    ss << compressed;
+    EXPECT_EQ(ss.str().size(), sizeof(unsigned) * 4 + strlen("clip") + sizeof(double) + sizeof(float) + compressed.GetSizeInBytes());
+    anim_CompressedAnimation loaded(ss);
+    anim_SkeletonAnimation   decompressed = compressed.Decompress();
+    for (double time = 0; time <= 1.5; time += 0.011) {
+        math_Vec3 position, scale, loadedPosition, loadedScale;
+        math_Quat rotation, loadedRotation;
+        compressed.Sample(0, time, &position, &rotation, &scale);
+        loaded.Sample(0, time, &loadedPosition, &loadedRotation, &loadedScale);
+        EXPECT_EQ(position, loadedPosition);
+        EXPECT_EQ(memcmp(&rotation, &loadedRotation, sizeof(math_Quat)), 0);
+
+        EXPECT_LE(math_Length(decompressed.GetChannels()[0].SamplePosition(time) - position), 1e-4f);
+        EXPECT_LE(RotationError(decompressed.GetChannels()[0].SampleRotation(time), rotation), 2e-3f);
+    }
+}
+
+TEST(anim_CompressedAnimation, PoseSamplesCompressedClip)
+{
+    anim_SkeletonBone bones[2];
+    for (int i = 0; i < 2; ++i) {
+        snprintf(bones[i].name, sizeof(bones[i].name), i == 0 ? "root" : "arm");
+        bones[i].localTransform = math_Mat4x4::Identity();
+        bones[i].parentIdx      = i - 1;
+    }
+    anim_SkeletonDef              skeleton(bones, 2);
+    anim_SkeletonAnimationChannel channel = CreateSmoothChannel("arm", 1.0, 0.0f);
+    anim_SkeletonAnimation        animation("clip", 1.0, &channel, 1);
+    anim_CompressedAnimation      compressed(animation);
+    anim_AnimationBinding         binding(skeleton, compressed);
+    anim_Pose                     pose(&skeleton);
+
+    EXPECT_EQ(pose.Animate(compressed, binding, 0.4), 1u);
+    math_Vec3 position, scale;
+    math_Quat rotation;
+    compressed.Sample(0, 0.4, &position, &rotation, &scale);
+    EXPECT_EQ(pose.GetTranslations()[1], position);
+    EXPECT_EQ(pose.GetTranslations()[0], math_Vec3(0, 0, 0));
+}
+
+TEST(anim_CompressedAnimation, SkeletonAnimationPlaysCompressedClip)
+{
+    anim_SkeletonBone bones[2];
+    for (int i = 0; i < 2; ++i) {
+        snprintf(bones[i].name, sizeof(bones[i].name), i == 0 ? "root" : "arm");
+        bones[i].localTransform = math_Mat4x4::Identity();
+        bones[i].parentIdx      = i - 1;
+    }
+    anim_SkeletonDef              skeleton(bones, 2);
+    anim_SkeletonAnimationChannel channel = CreateSmoothChannel("arm", 1.0, 0.0f);
+    anim_SkeletonAnimation        source("clip", 1.0, &channel, 1);
+    auto                          compressed = std::make_shared<const anim_CompressedAnimation>(source);
+    anim_SkeletonAnimation        animation(compressed);
+    ASSERT_EQ(animation.GetCompressed(), compressed.get());
+    EXPECT_EQ(animation.GetChannels(), nullptr);
+    EXPECT_EQ(animation.GetChannelCount(), 1u);
+    EXPECT_STREQ(animation.GetBoneName(0), "arm");
+    EXPECT_STREQ(animation.GetName(), "clip");
+    EXPECT_EQ(animation.GetDuration(), 1.0);
+
+    anim_AnimationBinding binding(skeleton, animation);
+    anim_Pose             pose(&skeleton);
+    anim_ChannelCursor    cursor;
+    for (double time = 0; time <= 1.0; time += 0.07) {
+        EXPECT_EQ(pose.Animate(animation, binding, time, &cursor), 1u);
+        math_Vec3 position, scale;
+        math_Quat rotation;
+        compressed->Sample(0, time, &position, &rotation, &scale);
+        EXPECT_EQ(pose.GetTranslations()[1], position);
+        EXPECT_EQ(memcmp(&pose.GetRotations()[1], &rotation, sizeof(math_Quat)), 0);
+    }
+
+    // Writing it out gives the keyframe clip it decompresses to
+    std::stringstream ss;
+    ss << animation;
+    anim_SkeletonAnimation loaded(ss);
+    EXPECT_EQ(loaded.GetCompressed(), nullptr);
+    ASSERT_EQ(loaded.GetChannelCount(), 1u);
+    EXPECT_LE(math_Length(loaded.GetChannels()[0].SamplePosition(0.5) - compressed->Decompress().GetChannels()[0].SamplePosition(0.5)), 1e-6f);
+}
+
+TEST(anim_CompressedAnimation, VampireClipsBenchmark)
+{
+    const char* clips[] = {"Vampire_idle", "Vampire_walk"};
+    for (const char* clip : clips) {
+        const std::string path = std::string(PGE_TEST_DATA_DIR) + "/Vampire/" + clip + ".skelanim";
+        std::ifstream     file(path, std::ios::binary | std::ios::ate);
+        if (!file.is_open())
+            GTEST_SKIP() << "No clip at " << path;
+        const size_t sourceBytes = static_cast<size_t>(file.tellg());
+        file.seekg(0);
+        anim_SkeletonAnimation animation(file);
+
+        const anim_CompressionSettings settings;
+        anim_CompressedAnimation       compressed(animation, settings);
+        for (unsigned c = 0; c < animation.GetChannelCount(); ++c) {
+            const anim_SkeletonAnimationChannel& channel = animation.GetChannels()[c];
+            for (double time = 0; time <= animation.GetDuration(); time += 1.0 / 30) {
+                math_Vec3 position, scale;
+                math_Quat rotation;
+                compressed.Sample(c, time, &position, &rotation, &scale);
+                // The source keys are at 30 Hz as well, so the grid error bounds apply up to rounding of the frame
+                ASSERT_LE(math_Length(position - channel.SamplePosition(time)), settings.translationError * 2) << channel.GetBoneName();
+                ASSERT_LE(RotationError(rotation, channel.SampleRotation(time)), settings.rotationError * 4) << channel.GetBoneName();
+            }
+        }
+
+        std::vector<anim_ChannelCursor> cursors(compressed.GetChannelCount());
+        const int                       numPasses = 20;
+        size_t                          numTracks = 0;
+        float                           checksum  = 0;
+        auto                            start     = std::chrono::high_resolution_clock::now();
+        for (int pass = 0; pass < numPasses; ++pass) {
+            for (double time = 0; time < animation.GetDuration(); time += 1.0 / 60) {
+                for (unsigned c = 0; c < compressed.GetChannelCount(); ++c) {
+                    math_Vec3 position, scale;
+                    math_Quat rotation;
+                    compressed.Sample(c, time, &position, &rotation, &scale, &cursors[c]);
+                    checksum += position.x + rotation.w + scale.z;
+                    numTracks += 3;
+                }
+            }
+        }
+        auto   end     = std::chrono::high_resolution_clock::now();
+        double seconds = std::chrono::duration<double>(end - start).count();
+        EXPECT_TRUE(checksum == checksum);
+
+        std::stringstream ss;
+        ss << compressed;
+        printf("[ BENCH    ] %s: %zu bytes -> %zu bytes (%.1fx), %zu keys kept, decode %.1fM tracks/s\n",
+               clip,
+               sourceBytes,
+               ss.str().size(),
+               double(sourceBytes) / ss.str().size(),
+               compressed.GetNumKeys(),
+               numTracks / seconds / 1e6);
+    }
+}
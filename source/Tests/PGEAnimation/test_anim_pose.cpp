@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+#include <anim_pose.h>
+#include <math_interp.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+using namespace pge;
+
+// A chain with branches every few bones, so the world pass sees parents at varying distances
+static std::vector<anim_SkeletonBone>
+CreateBones(unsigned numBones)
+{
+    std::vector<anim_SkeletonBone> bones(numBones);
+    for (unsigned i = 0; i < numBones; ++i) {
+        snprintf(bones[i].name, sizeof(bones[i].name), "bone%u", i);
+        bones[i].localTransform = math_Mat4x4::Identity();
+        bones[i].parentIdx      = i == 0 ? -1 : static_cast<int>(i % 3 == 0 ? i / 2 : i - 1);
+    }
+    return bones;
+}
+
+static void
+Randomize(anim_Pose* pose, std::mt19937* random)
+{
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+    for (size_t i = 0; i < pose->GetBoneCount(); ++i) {
+        pose->GetTranslations()[i] = math_Vec3(value(*random), value(*random), value(*random));
+        pose->GetRotations()[i]    = math_Normalize(math_Quat(value(*random), value(*random), value(*random), value(*random)));
+        pose->GetScales()[i]       = math_Vec3(scale(*random), scale(*random), scale(*random));
+    }
+}
+
+// ----------------------------------------------
+// Scalar reference
+// ----------------------------------------------
+static math_Quat
+NlerpReference(const math_Quat& from, const math_Quat& to, float factor)
+{
+    const math_Quat target = math_Dot(from, to) < 0 ? -to : to;
+    return math_Normalize(math_Lerp(from, target, factor));
+}
+
+static void
+WorldReference(const anim_Pose& pose, std::vector<math_Mat4x4>* world)
+{
+    world->resize(pose.GetBoneCount());
+    for (size_t i = 0; i < pose.GetBoneCount(); ++i) {
+        const math_Mat4x4 local = math_CreateTransformMatrix(pose.GetTranslations()[i], pose.GetRotations()[i], pose.GetScales()[i]);
+        const int         parentIdx = pose.GetSkeleton()->GetBone(i).parentIdx;
+        (*world)[i]                 = parentIdx == -1 ? local : (*world)[parentIdx] * local;
+    }
+}
+
+TEST(anim_BlendPoses, MatchesScalarReference)
+{
+    std::mt19937 random(11);
+    // Counts around the width of the kernels, so both the wide loop and the remainder are covered
+    for (unsigned numBones = 1; numBones <= 13; ++numBones) {
+        std::vector<anim_SkeletonBone> bones = CreateBones(numBones);
+        anim_SkeletonDef               skeleton(bones.data(), numBones);
+        anim_Pose                      from(&skeleton), to(&skeleton), blended(&skeleton);
+        Randomize(&from, &random);
+        Randomize(&to, &random);
+        // Every other target rotation in the opposite hemisphere
+        for (unsigned i = 0; i < numBones; i += 2) {
+            if (math_Dot(from.GetRotations()[i], to.GetRotations()[i]) > 0)
+                to.GetRotations()[i] = -to.GetRotations()[i];
+        }
+
+        for (float factor : {0.0f, 0.3f, 0.5f, 1.0f}) {
+            anim_BlendPoses(from, to, factor, &blended);
+            for (unsigned i = 0; i < numBones; ++i) {
+                const math_Vec3 translation = math_Lerp(from.GetTranslations()[i], to.GetTranslations()[i], factor);
+                const math_Vec3 scale       = math_Lerp(from.GetScales()[i], to.GetScales()[i], factor);
+                const math_Quat rotation    = NlerpReference(from.GetRotations()[i], to.GetRotations()[i], factor);
+                for (int c = 0; c < 3; ++c) {
+                    EXPECT_NEAR(blended.GetTranslations()[i][c], translation[c], 1e-5f) << numBones << " bones, bone " << i;
+                    EXPECT_NEAR(blended.GetScales()[i][c], scale[c], 1e-5f) << numBones << " bones, bone " << i;
+                }
+                EXPECT_NEAR(blended.GetRotations()[i].w, rotation.w, 1e-5f) << numBones << " bones, bone " << i;
+                EXPECT_NEAR(blended.GetRotations()[i].x, rotation.x, 1e-5f) << numBones << " bones, bone " << i;
+                EXPECT_NEAR(blended.GetRotations()[i].y, rotation.y, 1e-5f) << numBones << " bones, bone " << i;
+                EXPECT_NEAR(blended.GetRotations()[i].z, rotation.z, 1e-5f) << numBones << " bones, bone " << i;
+            }
+        }
+
+        // Blending into one of the inputs
+        anim_BlendPoses(from, to, 0.5f, &blended);
+        anim_BlendPoses(from, to, 0.5f, &from);
+        EXPECT_EQ(memcmp(from.GetRotations(), blended.GetRotations(), numBones * sizeof(math_Quat)), 0);
+        EXPECT_EQ(memcmp(from.GetTranslations(), blended.GetTranslations(), numBones * sizeof(math_Vec3)), 0);
+    }
+}
+
+TEST(anim_Pose, WorldTransformsMatchScalarReference)
+{
+    std::mt19937 random(13);
+    for (unsigned numBones = 1; numBones <= 13; ++numBones) {
+        std::vector<anim_SkeletonBone> bones = CreateBones(numBones);
+        anim_SkeletonDef               skeleton(bones.data(), numBones);
+        anim_Pose                      pose(&skeleton);
+        Randomize(&pose, &random);
+        // Unnormalized rotations are normalized when composed, like math_CreateTransformMatrix does
+        pose.GetRotations()[0] = 3.0f * pose.GetRotations()[0];
+        pose.ComputeWorldTransforms();
+
+        std::vector<math_Mat4x4> expected;
+        WorldReference(pose, &expected);
+        for (unsigned i = 0; i < numBones; ++i) {
+            for (int r = 0; r < 4; ++r) {
+                for (int c = 0; c < 4; ++c)
+                    EXPECT_NEAR(pose.GetWorldTransform(i)[r][c], expected[i][r][c], 1e-3f) << numBones << " bones, bone " << i;
+            }
+        }
+    }
+}
+
+TEST(anim_Pose, SkinningPaletteAppliesBoneOffsets)
+{
+    std::mt19937                   random(19);
+    const unsigned                 numBones = 7;
+    std::vector<anim_SkeletonBone> bones    = CreateBones(numBones);
+    anim_SkeletonDef               skeleton(bones.data(), numBones);
+    anim_Pose                      pose(&skeleton), offsetPose(&skeleton);
+    Randomize(&pose, &random);
+    Randomize(&offsetPose, &random);
+    pose.ComputeWorldTransforms();
+    offsetPose.ComputeWorldTransforms();
+
+    std::vector<math_Mat4x4> palette(numBones);
+    anim_ComputeSkinningPalette(pose, offsetPose.GetWorldTransforms(), palette.data());
+    for (unsigned i = 0; i < numBones; ++i) {
+        const math_Mat4x4 expected = pose.GetWorldTransform(i) * offsetPose.GetWorldTransform(i);
+        for (int r = 0; r < 4; ++r) {
+            for (int c = 0; c < 4; ++c)
+                EXPECT_NEAR(palette[i][r][c], expected[r][c], 1e-3f) << "bone " << i;
+        }
+    }
+}
+
+TEST(anim_Pose, ThroughputBenchmark)
+{
+    const unsigned numBones   = 64;
+    const unsigned numPoses   = 256;
+    const int      numRounds  = 20;
+    const double   numSamples = double(numBones) * numPoses * numRounds;
+
+    std::mt19937                   random(17);
+    std::vector<anim_SkeletonBone> bones = CreateBones(numBones);
+    anim_SkeletonDef               skeleton(bones.data(), numBones);
+    std::vector<anim_Pose>         from(numPoses, anim_Pose(&skeleton)), to(numPoses, anim_Pose(&skeleton));
+    for (unsigned p = 0; p < numPoses; ++p) {
+        Randomize(&from[p], &random);
+        Randomize(&to[p], &random);
+    }
+    anim_Pose out(&skeleton);
+
+    auto bonesPerSecond = [&](auto&& kernel) {
+        float checksum = 0;
+        auto  start    = std::chrono::high_resolution_clock::now();
+        for (int round = 0; round < numRounds; ++round) {
+            for (unsigned p = 0; p < numPoses; ++p)
+                checksum += kernel(p);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        EXPECT_TRUE(checksum == checksum);
+        return numSamples / std::chrono::duration<double>(end - start).count();
+    };
+
+    const double blend = bonesPerSecond([&](unsigned p) {
+        anim_BlendPoses(from[p], to[p], 0.4f, &out);
+        return out.GetRotations()[numBones - 1].w;
+    });
+    const double blendReference = bonesPerSecond([&](unsigned p) {
+        for (unsigned i = 0; i < numBones; ++i) {
+            out.GetTranslations()[i] = math_Lerp(from[p].GetTranslations()[i], to[p].GetTranslations()[i], 0.4f);
+            out.GetRotations()[i]    = NlerpReference(from[p].GetRotations()[i], to[p].GetRotations()[i], 0.4f);
+            out.GetScales()[i]       = math_Lerp(from[p].GetScales()[i], to[p].GetScales()[i], 0.4f);
+        }
+        return out.GetRotations()[numBones - 1].w;
+    });
+    const double world = bonesPerSecond([&](unsigned p) {
+        from[p].ComputeWorldTransforms();
+        return from[p].GetWorldTransform(numBones - 1)[0][3];
+    });
+    std::vector<math_Mat4x4> referenceWorld;
+    const double             worldReference = bonesPerSecond([&](unsigned p) {
+        WorldReference(from[p], &referenceWorld);
+        return referenceWorld[numBones - 1][0][3];
+    });
+
+    printf("[ BENCH    ] bones per second: blend %.1fM (scalar %.1fM), world transforms %.1fM (scalar %.1fM)\n",
+           blend / 1e6,
+           blendReference / 1e6,
+           world / 1e6,
+           worldReference / 1e6);
+}
@@ -0,0 +1,508 @@
+#include <gtest/gtest.h>
+#include <anim_skeleton.h>
+#include <anim_animator.h>
+#include <anim_pose.h>
+#include <anim_pose_cache.h>
+#include <math_interp.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <sstream>
+
+using namespace pge;
+
+static anim_SkeletonAnimationChannel
+CreateChannel(const char* boneName, double duration, double keysPerSecond, std::mt19937* random)
+{
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    std::vector<anim_KeyVec3>             vecKeys;
+    std::vector<anim_KeyQuat>             quatKeys;
+    const unsigned                        numKeys = static_cast<unsigned>(duration * keysPerSecond) + 1;
+    for (unsigned i = 0; i < numKeys; ++i) {
+        // Uneven spacing, like keys that were reduced after export
+        const double time = (i + (i % 3 == 1 ? 0.4 : 0.0)) / keysPerSecond;
+        anim_KeyVec3 vecKey;
+        vecKey.time  = time;
+        vecKey.value = math_Vec3(value(*random), value(*random), value(*random));
+        vecKeys.push_back(vecKey);
+
+        anim_KeyQuat quatKey;
+        quatKey.time  = time;
+        quatKey.value = math_Quat(value(*random), value(*random), value(*random), value(*random));
+        quatKeys.push_back(quatKey);
+    }
+    return anim_SkeletonAnimationChannel(boneName, &vecKeys[0], numKeys, &vecKeys[0], numKeys, &quatKeys[0], numKeys);
+}
+
+// Scans all keys from the start, like the sampling used to
+static math_Vec3
+SampleLinear(const std::vector<anim_KeyVec3>& keys, double time)
+{
+    if (time <= keys.front().time)
+        return keys.front().value;
+    for (size_t i = 1; i < keys.size(); ++i) {
+        if (time < keys[i].time) {
+            const float ratio = float((time - keys[i - 1].time) / (keys[i].time - keys[i - 1].time));
+            return (1 - ratio) * keys[i - 1].value + ratio * keys[i].value;
+        }
+    }
+    return keys.back().value;
+}
+
+static void
+ExpectNear(const math_Vec3& a, const math_Vec3& b)
+{
+    EXPECT_NEAR(a.x, b.x, 1e-3f);
+    EXPECT_NEAR(a.y, b.y, 1e-3f);
+    EXPECT_NEAR(a.z, b.z, 1e-3f);
+}
+
+TEST(anim_SkeletonAnimationChannel, SampleMatchesLinearScan)
+{
+    std::vector<anim_KeyVec3> keys;
+    for (int i = 0; i < 50; ++i) {
+        anim_KeyVec3 key;
+        key.time  = i * 0.1 + (i % 2) * 0.03;
+        key.value = math_Vec3(float(i), float(i % 7), -float(i));
+        keys.push_back(key);
+    }
+    anim_KeyQuat rotation;
+    rotation.time  = 0;
+    rotation.value = math_Quat();
+    anim_SkeletonAnimationChannel channel("bone", &keys[0], keys.size(), &keys[0], keys.size(), &rotation, 1);
+
+    // Forward playback, jumps backward, before the first and past the last key
+    anim_ChannelCursor cursor;
+    for (double time : {-1.0, 0.0, 0.01, 0.1, 0.13, 0.2, 0.21, 1.5, 1.55, 0.4, 0.45, 4.0, 4.9, 4.93, 5.0, 0.05}) {
+        ExpectNear(channel.SamplePosition(time, &cursor), SampleLinear(keys, time));
+        ExpectNear(channel.SampleScale(time), SampleLinear(keys, time));
+    }
+    for (double time = 0; time < 5.0; time += 1.0 / 60) {
+        ExpectNear(channel.SamplePosition(time, &cursor), SampleLinear(keys, time));
+    }
+    EXPECT_EQ(channel.SampleRotation(3.0).w, 1.0f);
+}
+
+TEST(anim_SkeletonAnimationChannel, CopyAndSerializeKeepKeys)
+{
+    std::mt19937                  random(7);
+    anim_SkeletonAnimationChannel channel = CreateChannel("bone", 2.0, 30.0, &random);
+    anim_SkeletonAnimationChannel copy(channel);
+    anim_SkeletonAnimation        animation("clip", 2.0, &copy, 1);
+
+    std::stringstream ss;
+    ss << animation;
+    anim_SkeletonAnimation loaded(ss);
+    ASSERT_EQ(loaded.GetChannelCount(), 1u);
+    EXPECT_STREQ(loaded.GetChannels()[0].GetBoneName(), "bone");
+    for (double time = 0; time < 2.0; time += 0.07) {
+        ExpectNear(loaded.GetChannels()[0].SamplePosition(time), channel.SamplePosition(time));
+        EXPECT_NEAR(loaded.GetChannels()[0].SampleRotation(time).w, channel.SampleRotation(time).w, 1e-5f);
+    }
+}
+
+TEST(anim_SkeletonAnimationChannel, SamplingBenchmark)
+{
+    // One minute clips at 30 keys per second, played back at 60 fps
+    const unsigned numBones  = 60;
+    const double   duration  = 60.0;
+    const double   frameTime = 1.0 / 60;
+
+    std::mt19937                               random(1);
+    std::vector<anim_SkeletonAnimationChannel> channels;
+    for (unsigned i = 0; i < numBones; ++i) {
+        channels.emplace_back(CreateChannel("bone", duration, 30.0, &random));
+    }
+
+    auto play = [&](anim_ChannelCursor* cursors) {
+        float checksum = 0;
+        auto  start    = std::chrono::high_resolution_clock::now();
+        for (double time = 0; time < duration; time += frameTime) {
+            for (unsigned i = 0; i < numBones; ++i) {
+                anim_ChannelCursor* cursor = cursors != nullptr ? &cursors[i] : nullptr;
+                checksum += channels[i].SamplePosition(time, cursor).x;
+                checksum += channels[i].SampleScale(time, cursor).y;
+                checksum += channels[i].SampleRotation(time, cursor).w;
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::make_pair(std::chrono::duration<double, std::milli>(end - start).count() / (duration / frameTime), checksum);
+    };
+
+    std::vector<anim_ChannelCursor> cursors(numBones);
+    auto                            searched = play(nullptr);
+    auto                            cached   = play(cursors.data());
+    EXPECT_FLOAT_EQ(searched.second, cached.second);
+    printf("[ BENCH    ] sampling %u bones of a %.0f s clip per frame: binary search %.4f ms, cursor %.4f ms\n",
+           numBones,
+           duration,
+           searched.first,
+           cached.first);
+}
+
+TEST(anim_AnimationBinding, AnimateUsesBoundChannels)
+{
+    anim_SkeletonBone bones[3];
+    const char*       names[3] = {"root", "arm", "hand"};
+    for (int i = 0; i < 3; ++i) {
+        strcpy(bones[i].name, names[i]);
+        bones[i].localTransform = math_Mat4x4::Identity();
+        bones[i].parentIdx      = i - 1;
+    }
+    anim_SkeletonDef skeleton(bones, 3);
+    anim_Pose        pose(&skeleton);
+
+    // Channels in a different order than the bones, and none for the arm
+    std::mt19937                  random(3);
+    anim_SkeletonAnimationChannel channels[2] = {CreateChannel("hand", 1.0, 30.0, &random), CreateChannel("root", 1.0, 30.0, &random)};
+    anim_SkeletonAnimation        animation("clip", 1.0, channels, 2);
+    anim_AnimationBinding         binding(skeleton, animation);
+    EXPECT_EQ(binding.GetChannelIndex(0), 1);
+    EXPECT_EQ(binding.GetChannelIndex(1), -1);
+    EXPECT_EQ(binding.GetChannelIndex(2), 0);
+
+    pose.Animate(animation, binding, 0.5);
+    for (int bone : {0, 2}) {
+        const anim_SkeletonAnimationChannel& channel = channels[binding.GetChannelIndex(bone)];
+        EXPECT_EQ(pose.GetTranslations()[bone], channel.SamplePosition(0.5)) << "bone " << bone;
+        EXPECT_EQ(pose.GetScales()[bone], channel.SampleScale(0.5)) << "bone " << bone;
+        const math_Quat                      rotation = channel.SampleRotation(0.5);
+        EXPECT_EQ(memcmp(&pose.GetRotations()[bone], &rotation, sizeof(math_Quat)), 0) << "bone " << bone;
+    }
+    EXPECT_EQ(pose.GetTranslations()[1], math_Vec3(0, 0, 0));
+    EXPECT_EQ(pose.GetScales()[1], math_Vec3(1, 1, 1));
+}
+
+TEST(anim_AnimationBinding, TransitionBlendsBoundChannels)
+{
+    anim_SkeletonBone bones[2];
+    const char*       names[2] = {"root", "hand"};
+    for (int i = 0; i < 2; ++i) {
+        strcpy(bones[i].name, names[i]);
+        bones[i].localTransform = math_Mat4x4::Identity();
+        bones[i].parentIdx      = i - 1;
+    }
+    anim_SkeletonDef skeleton(bones, 2);
+
+    std::mt19937                  random(5);
+    anim_SkeletonAnimationChannel idleChannels[2] = {CreateChannel("root", 1.0, 30.0, &random), CreateChannel("hand", 1.0, 30.0, &random)};
+    anim_SkeletonAnimationChannel waveChannel     = CreateChannel("hand", 1.0, 30.0, &random);
+    anim_SkeletonAnimation        idle("idle", 1.0, idleChannels, 2);
+    anim_SkeletonAnimation        wave("wave", 1.0, &waveChannel, 1);
+
+    anim_AnimationState  states[2]   = {anim_AnimationState("idle", &idle, true), anim_AnimationState("wave", &wave, false)};
+    anim_TransitionParam transition  = anim_TransitionParam("idle", "wave", "wave", 0.5f);
+    anim_AnimatorConfig  config(&skeleton, states, 2, &transition, 1);
+    anim_Animator        animator(&config);
+    animator.Update(0.25f);
+    animator.Trigger("wave");
+    animator.Update(0.125f);
+
+    // A quarter into the transition, with the idle clip at 0.375 s and the wave clip at its start
+    const float      factor   = 0.25f;
+    const anim_Pose& pose     = animator.GetPose();
+    math_Vec3        expected = math_Lerp(idleChannels[1].SamplePosition(0.375), waveChannel.SamplePosition(0), factor);
+    ExpectNear(pose.GetTranslations()[1], expected);
+
+    // The pose is evaluated in place
+    animator.Update(0.125f);
+    EXPECT_EQ(&animator.GetPose(), &pose);
+}
+
+TEST(anim_Pose, BindPoseMatchesBoneTransforms)
+{
+    anim_SkeletonBone bones[3];
+    const char*       names[3] = {"root", "arm", "hand"};
+    for (int i = 0; i < 3; ++i) {
+        strcpy(bones[i].name, names[i]);
+        bones[i].parentIdx = i - 1;
+    }
+    bones[0].localTransform = math_CreateTransformMatrix(math_Vec3(1, 2, 3), math_QuatFromAxisAngle(math_Vec3(0, 1, 0), 30), math_Vec3(2, 1, 3));
+    bones[1].localTransform = math_CreateTransformMatrix(math_Vec3(0, 4, 0), math_QuatFromAxisAngle(math_Vec3(1, 0, 0), -75), math_Vec3(1, 1, 1));
+    bones[2].localTransform = math_CreateTransformMatrix(math_Vec3(-2, 0, 1), math_QuatFromAxisAngle(math_Vec3(0, 0, 1), 120), math_Vec3(0.5f, 2, 1));
+    anim_SkeletonDef skeleton(bones, 3);
+    anim_Pose        pose(&skeleton);
+
+    math_Mat4x4 expected = math_Mat4x4::Identity();
+    for (int i = 0; i < 3; ++i) {
+        expected = expected * bones[i].localTransform;
+        for (int r = 0; r < 4; ++r) {
+            for (int c = 0; c < 4; ++c)
+                EXPECT_NEAR(pose.GetWorldTransform(i)[r][c], expected[r][c], 1e-4f) << "bone " << i;
+        }
+    }
+}
+
+TEST(anim_Pose, BindPoseKeepsImportedBoneTransforms)
+{
+    // Imported bind transforms are T * R * S, which T * S * R can't rebuild with a non-uniform scale
+    anim_SkeletonBone bones[2];
+    for (int i = 0; i < 2; ++i) {
+        strcpy(bones[i].name, i == 0 ? "root" : "arm");
+        bones[i].parentIdx = i - 1;
+    }
+    bones[0].localTransform = math_CreateTranslationMatrix(math_Vec3(1, 2, 3)) * math_CreateRotationMatrix(math_QuatFromAxisAngle(math_Vec3(0, 1, 0), 30))
+                              * math_CreateScaleMatrix(math_Vec3(2, 1, 3));
+    bones[1].localTransform = math_CreateTransformMatrix(math_Vec3(0, 4, 0), math_QuatFromAxisAngle(math_Vec3(1, 0, 0), -75), math_Vec3(1, 1, 1));
+    anim_SkeletonDef skeleton(bones, 2);
+    anim_Pose        pose(&skeleton);
+
+    ASSERT_EQ(skeleton.GetUnfactoredBones().size(), 1u);
+    EXPECT_EQ(skeleton.GetUnfactoredBones()[0], 0);
+    math_Mat4x4 expected = math_Mat4x4::Identity();
+    for (int i = 0; i < 2; ++i) {
+        expected = expected * bones[i].localTransform;
+        for (int r = 0; r < 4; ++r) {
+            for (int c = 0; c < 4; ++c)
+                EXPECT_NEAR(pose.GetWorldTransform(i)[r][c], expected[r][c], 1e-4f) << "bone " << i;
+        }
+    }
+}
+
+TEST(anim_Animator, LodSkipsLeafBonesAndBlending)
+{
+    anim_SkeletonBone bones[3];
+    const char*       names[3] = {"root", "arm", "hand"};
+    for (int i = 0; i < 3; ++i) {
+        strcpy(bones[i].name, names[i]);
+        bones[i].localTransform = math_Mat4x4::Identity();
+        bones[i].parentIdx      = i - 1;
+    }
+    anim_SkeletonDef skeleton(bones, 3);
+    EXPECT_EQ(skeleton.GetLeafBoneMask()[0], 0);
+    EXPECT_EQ(skeleton.GetLeafBoneMask()[2], 1);
+
+    std::mt19937                  random(9);
+    anim_SkeletonAnimationChannel idleChannels[3]
+        = {CreateChannel("root", 1.0, 30.0, &random), CreateChannel("arm", 1.0, 30.0, &random), CreateChannel("hand", 1.0, 30.0, &random)};
+    anim_SkeletonAnimationChannel waveChannels[3]
+        = {CreateChannel("root", 1.0, 30.0, &random), CreateChannel("arm", 1.0, 30.0, &random), CreateChannel("hand", 1.0, 30.0, &random)};
+    anim_SkeletonAnimation idle("idle", 1.0, idleChannels, 3);
+    anim_SkeletonAnimation wave("wave", 1.0, waveChannels, 3);
+
+    anim_AnimationState  states[2]  = {anim_AnimationState("idle", &idle, true), anim_AnimationState("wave", &wave, false)};
+    anim_TransitionParam transition = anim_TransitionParam("idle", "wave", "wave", 0.5f);
+    anim_AnimatorConfig  config(&skeleton, states, 2, &transition, 1);
+    anim_Animator        animator(&config);
+    animator.Update(0.25f);
+    EXPECT_EQ(animator.GetPose().GetTranslations()[2], idleChannels[2].SamplePosition(0.25));
+    EXPECT_EQ(animator.GetNumEvaluatedBones(), 3u);
+
+    animator.SetLod(anim_AnimatorLod(true, false));
+    EXPECT_TRUE(animator.IsPoseOutdated());
+    EXPECT_EQ(animator.GetPose().GetTranslations()[2], math_Vec3(0, 0, 0));
+    EXPECT_EQ(animator.GetPose().GetTranslations()[1], idleChannels[1].SamplePosition(0.25));
+    EXPECT_EQ(animator.GetNumEvaluatedBones(), 2u);
+
+    // Blending samples both clips, a single clip LOD only the one with the larger weight
+    animator.SetLod(anim_AnimatorLod());
+    animator.Trigger("wave");
+    animator.Update(0.125f);
+    animator.GetPose();
+    EXPECT_EQ(animator.GetNumEvaluatedBones(), 6u);
+
+    animator.SetLod(anim_AnimatorLod(false, true));
+    EXPECT_EQ(animator.GetPose().GetTranslations()[0], idleChannels[0].SamplePosition(0.375));
+    EXPECT_EQ(animator.GetNumEvaluatedBones(), 3u);
+    animator.Update(0.25f);
+    EXPECT_EQ(animator.GetPose().GetTranslations()[0], waveChannels[0].SamplePosition(0));
+}
+
+TEST(anim_SkeletonDef, ZeroScaleBindPoseKeepsRotationFinite)
+{
+    anim_SkeletonBone bones[2];
+    const math_Quat   rotation = math_QuatFromAxisAngle(math_Vec3(0, 0, 1), 90);
+    const math_Vec3   scales[] = {math_Vec3(1, 0, 1), math_Vec3(0, 0, 2)};
+    for (int i = 0; i < 2; ++i) {
+        strcpy(bones[i].name, i == 0 ? "root" : "hand");
+        bones[i].localTransform = math_CreateTransformMatrix(math_Vec3(0, 1, 0), rotation, scales[i]);
+        bones[i].parentIdx      = i - 1;
+    }
+    anim_SkeletonDef skeleton(bones, 2);
+
+    // One flattened axis still tells the rotation, more than one doesn't
+    EXPECT_NEAR(fabsf(math_Dot(skeleton.GetBindRotations()[0], rotation)), 1.0f, 1e-4f);
+    EXPECT_NEAR(math_Dot(skeleton.GetBindRotations()[1], skeleton.GetBindRotations()[1]), 1.0f, 1e-4f);
+    ExpectNear(skeleton.GetBindScales()[0], scales[0]);
+    ExpectNear(skeleton.GetBindScales()[1], scales[1]);
+}
+
+TEST(anim_Animator, TriggersByHashedId)
+{
+    static_assert(anim_HashTrigger("wave") != anim_HashTrigger("idle"), "Trigger ids are known at compile time");
+
+    anim_SkeletonBone bone;
+    strcpy(bone.name, "root");
+    bone.localTransform = math_Mat4x4::Identity();
+    bone.parentIdx      = -1;
+    anim_SkeletonDef skeleton(&bone, 1);
+
+    std::mt19937                  random(21);
+    anim_SkeletonAnimationChannel idleChannel = CreateChannel("root", 1.0, 30.0, &random);
+    anim_SkeletonAnimationChannel waveChannel = CreateChannel("root", 1.0, 30.0, &random);
+    anim_SkeletonAnimation        idle("idle", 1.0, &idleChannel, 1);
+    anim_SkeletonAnimation        wave("wave", 1.0, &waveChannel, 1);
+
+    anim_AnimationState  states[2]      = {anim_AnimationState("idle", &idle, true), anim_AnimationState("wave", &wave, true)};
+    anim_TransitionParam transitions[2] = {anim_TransitionParam("idle", "wave", "wave", 0.1f), anim_TransitionParam("wave", "idle", "stop", 0.1f)};
+    anim_AnimatorConfig  config(&skeleton, states, 2, transitions, 2);
+
+    std::vector<anim_Animator> animators(4, anim_Animator(&config));
+    animators[0].Trigger(anim_HashTrigger("stop")); // Not a transition of the idle state
+    animators[1].Trigger(anim_HashTrigger("wave"));
+    animators[2].Trigger("wave");
+    for (anim_Animator& animator : animators)
+        animator.Update(0.2f);
+
+    ExpectNear(animators[0].GetPose().GetTranslations()[0], idleChannel.SamplePosition(0.2));
+    ExpectNear(animators[1].GetPose().GetTranslations()[0], waveChannel.SamplePosition(0));
+    ExpectNear(animators[2].GetPose().GetTranslations()[0], waveChannel.SamplePosition(0));
+}
+
+TEST(anim_Animator, TriggerDispatchBenchmark)
+{
+    anim_SkeletonBone bone;
+    strcpy(bone.name, "root");
+    bone.localTransform = math_Mat4x4::Identity();
+    bone.parentIdx      = -1;
+    anim_SkeletonDef skeleton(&bone, 1);
+
+    // A locomotion graph with a handful of transitions per state
+    std::mt19937                      random(23);
+    anim_SkeletonAnimationChannel     channel = CreateChannel("root", 1.0, 30.0, &random);
+    anim_SkeletonAnimation            clip("clip", 1.0, &channel, 1);
+    const char*                       names[4] = {"idle", "walk", "run", "jump"};
+    std::vector<anim_AnimationState>  states;
+    std::vector<anim_TransitionParam> transitions;
+    for (const char* from : names) {
+        states.emplace_back(from, &clip, true);
+        for (const char* to : names) {
+            if (from != to)
+                transitions.emplace_back(from, to, (std::string("to_") + to).c_str(), 0.2f);
+        }
+    }
+    anim_AnimatorConfig config(&skeleton, states.data(), states.size(), transitions.data(), transitions.size());
+
+    const size_t               numAnimators = 10000;
+    const int                  numRounds    = 100;
+    std::vector<anim_Animator> animators(numAnimators, anim_Animator(&config));
+    const anim_TriggerId       triggers[2]  = {anim_HashTrigger("to_walk"), anim_HashTrigger("to_idle")};
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int round = 0; round < numRounds; ++round) {
+        for (anim_Animator& animator : animators)
+            animator.Trigger(triggers[round % 2]);
+    }
+    auto   end  = std::chrono::high_resolution_clock::now();
+    double byId = std::chrono::duration<double, std::nano>(end - start).count() / (numRounds * numAnimators);
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int round = 0; round < numRounds; ++round) {
+        for (anim_Animator& animator : animators)
+            animator.Trigger(round % 2 == 0 ? "to_walk" : "to_idle");
+    }
+    end           = std::chrono::high_resolution_clock::now();
+    double byName = std::chrono::duration<double, std::nano>(end - start).count() / (numRounds * numAnimators);
+    printf("[ BENCH    ] trigger per animator: by id %.1f ns, by name %.1f ns\n", byId, byName);
+}
+
+TEST(anim_PoseCache, SharesPosesWithEqualKeys)
+{
+    anim_SkeletonBone bone;
+    strcpy(bone.name, "root");
+    bone.localTransform = math_Mat4x4::Identity();
+    bone.parentIdx      = -1;
+    anim_SkeletonDef skeleton(&bone, 1);
+
+    std::mt19937                  random(27);
+    anim_SkeletonAnimationChannel idleChannel = CreateChannel("root", 1.0, 30.0, &random);
+    anim_SkeletonAnimationChannel waveChannel = CreateChannel("root", 1.0, 30.0, &random);
+    anim_SkeletonAnimation        idle("idle", 1.0, &idleChannel, 1);
+    anim_SkeletonAnimation        wave("wave", 1.0, &waveChannel, 1);
+
+    anim_AnimationState  states[2]  = {anim_AnimationState("idle", &idle, true), anim_AnimationState("wave", &wave, true)};
+    anim_TransitionParam transition = anim_TransitionParam("idle", "wave", "wave", 0.5f);
+    anim_AnimatorConfig  config(&skeleton, states, 2, &transition, 1);
+
+    // Two in phase, one a frame behind within the same step, one out of phase, one transitioning and one at a lower LOD
+    std::vector<anim_Animator> animators(6, anim_Animator(&config));
+    animators[1].Update(0.001f);
+    animators[2].Update(0.5f);
+    animators[3].Trigger("wave");
+    animators[4].SetLod(anim_AnimatorLod(true, false));
+    for (anim_Animator& animator : animators)
+        animator.Update(0.25f);
+
+    anim_PoseCache cache(1.0f / 30);
+    const anim_Pose* poses[6];
+    for (size_t i = 0; i < animators.size(); ++i)
+        poses[i] = &cache.GetPose(animators[i]);
+    EXPECT_EQ(cache.GetNumHits(), 2u);
+    EXPECT_EQ(cache.GetNumMisses(), 4u);
+    EXPECT_EQ(poses[1], poses[0]);
+    EXPECT_EQ(poses[5], poses[0]);
+    EXPECT_NE(poses[2], poses[0]);
+    EXPECT_NE(poses[3], poses[0]);
+    EXPECT_NE(poses[4], poses[0]);
+    EXPECT_TRUE(animators[1].IsPoseOutdated());
+    ExpectNear(poses[2]->GetTranslations()[0], idleChannel.SamplePosition(0.75));
+
+    cache.Clear();
+    EXPECT_EQ(cache.GetNumHits(), 0u);
+    EXPECT_EQ(&cache.GetPose(animators[1]), &animators[1].GetPose());
+}
+
+TEST(anim_PoseCache, CrowdBenchmark)
+{
+    // 500 characters with a 60 bone skeleton, playing a walk cycle in 4 phases
+    const unsigned                 numBones = 60;
+    std::vector<anim_SkeletonBone> bones(numBones);
+    std::mt19937                   random(29);
+    std::vector<anim_SkeletonAnimationChannel> channels;
+    for (unsigned i = 0; i < numBones; ++i) {
+        sprintf(bones[i].name, "bone%u", i);
+        bones[i].localTransform = math_Mat4x4::Identity();
+        bones[i].parentIdx      = static_cast<int>(i) - 1 - static_cast<int>(i % 3 == 2);
+        channels.push_back(CreateChannel(bones[i].name, 1.0, 30.0, &random));
+    }
+    anim_SkeletonDef       skeleton(bones.data(), numBones);
+    anim_SkeletonAnimation walk("walk", 1.0, channels.data(), numBones);
+    anim_AnimationState    state("walk", &walk, true);
+    anim_AnimatorConfig    config(&skeleton, &state, 1, nullptr, 0);
+
+    const size_t               numCharacters = 500;
+    const int                  numFrames     = 200;
+    const float                frameTime     = 1.0f / 60;
+    std::vector<anim_Animator> animators(numCharacters, anim_Animator(&config));
+    for (size_t i = 0; i < numCharacters; ++i)
+        animators[i].Update(0.25f * (i % 4));
+
+    auto run = [&](anim_PoseCache* cache) {
+        std::vector<anim_Animator> crowd    = animators;
+        float                      checksum = 0;
+        auto  start    = std::chrono::high_resolution_clock::now();
+        for (int frame = 0; frame < numFrames; ++frame) {
+            if (cache != nullptr)
+                cache->Clear();
+            for (anim_Animator& animator : crowd) {
+                animator.Update(frameTime);
+                const anim_Pose& pose = cache != nullptr ? cache->GetPose(animator) : animator.GetPose();
+                checksum += pose.GetWorldTransform(numBones - 1)[0][3];
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::make_pair(std::chrono::duration<double, std::milli>(end - start).count() / numFrames, checksum);
+    };
+
+    anim_PoseCache cache;
+    auto           independent = run(nullptr);
+    auto           shared      = run(&cache);
+    EXPECT_EQ(cache.GetNumHits(), numCharacters - 4);
+    EXPECT_NEAR(shared.second, independent.second, 1e-3f * std::abs(independent.second) + 1e-3f);
+    printf("[ BENCH    ] %zu characters: %.3f ms independent, %.3f ms shared (%zu hits per frame)\n",
+           numCharacters,
+           independent.first,
+           shared.first,
+           cache.GetNumHits());
+}
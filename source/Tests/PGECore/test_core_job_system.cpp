@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+#include <core_job_system.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+using namespace pge;
+
+TEST(core_WorkStealingQueue, EveryJobIsTakenOnce)
+{
+    const size_t numJobs    = 200000;
+    const size_t numThieves = 3;
+
+    std::vector<core_Job>         jobs(numJobs);
+    std::vector<std::atomic<int>> taken(numJobs);
+    for (size_t i = 0; i < numJobs; ++i) {
+        jobs[i].data = reinterpret_cast<void*>(i);
+        taken[i]     = 0;
+    }
+
+    core_WorkStealingQueue   queue(1024);
+    std::atomic<size_t>      numTaken(0);
+    std::vector<std::thread> thieves;
+    for (size_t t = 0; t < numThieves; ++t) {
+        thieves.emplace_back([&] {
+            while (numTaken.load() < numJobs) {
+                if (core_Job* job = queue.Steal()) {
+                    taken[reinterpret_cast<size_t>(job->data)]++;
+                    numTaken++;
+                }
+            }
+        });
+    }
+
+    // The owner keeps pushing and popping, so pops race with steals on the last element
+    size_t next = 0;
+    while (numTaken.load() < numJobs) {
+        for (int i = 0; i < 16 && next < numJobs; ++i) {
+            if (queue.Push(&jobs[next]))
+                ++next;
+        }
+        if (core_Job* job = queue.Pop()) {
+            taken[reinterpret_cast<size_t>(job->data)]++;
+            numTaken++;
+        }
+    }
+    for (std::thread& thief : thieves)
+        thief.join();
+
+    EXPECT_EQ(queue.Size(), 0u);
+    for (size_t i = 0; i < numJobs; ++i)
+        ASSERT_EQ(taken[i].load(), 1) << "job " << i;
+}
+
+TEST(core_WorkStealingQueue, PushFailsWhenFull)
+{
+    core_WorkStealingQueue queue(4);
+    core_Job               jobs[5];
+    for (int i = 0; i < 4; ++i)
+        EXPECT_TRUE(queue.Push(&jobs[i]));
+    EXPECT_FALSE(queue.Push(&jobs[4]));
+    EXPECT_EQ(queue.Pop(), &jobs[3]);
+    EXPECT_EQ(queue.Steal(), &jobs[0]);
+    EXPECT_EQ(queue.Size(), 2u);
+}
+
+TEST(core_JobSystem, ParallelForVisitsEveryIndexOnce)
+{
+    core_JobSystem jobSystem(4);
+    for (size_t grainSize : {0, 1, 7, 1000}) {
+        std::vector<std::atomic<int>> visits(10000);
+        for (auto& v : visits)
+            v = 0;
+        core_ParallelFor(&jobSystem, 0, visits.size(), grainSize, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                visits[i]++;
+        });
+        for (size_t i = 0; i < visits.size(); ++i)
+            ASSERT_EQ(visits[i].load(), 1) << "index " << i << " with grain size " << grainSize;
+    }
+}
+
+struct NestedJobData {
+    core_JobSystem*   jobSystem;
+    std::atomic<int>* leaves;
+};
+
+static void
+LeafJob(void* data)
+{
+    (*static_cast<NestedJobData*>(data)->leaves)++;
+}
+
+static void
+SpawningJob(void* data)
+{
+    // Jobs can submit more work and wait on it without blocking their worker
+    NestedJobData*  nested = static_cast<NestedJobData*>(data);
+    core_Job        children[8];
+    core_JobCounter counter;
+    for (core_Job& child : children) {
+        child.function = LeafJob;
+        child.data     = nested;
+    }
+    nested->jobSystem->Run(children, 8, &counter);
+    nested->jobSystem->Wait(&counter);
+}
+
+TEST(core_JobSystem, JobsCanWaitOnNestedJobs)
+{
+    core_JobSystem   jobSystem(4);
+    std::atomic<int> leaves(0);
+    NestedJobData    nested = {&jobSystem, &leaves};
+
+    std::vector<core_Job> jobs(64);
+    for (core_Job& job : jobs) {
+        job.function = SpawningJob;
+        job.data     = &nested;
+    }
+    core_JobCounter counter;
+    jobSystem.Run(jobs.data(), jobs.size(), &counter);
+    jobSystem.Wait(&counter);
+    EXPECT_EQ(counter.value.load(), 0);
+    EXPECT_EQ(leaves.load(), 64 * 8);
+}
+
+TEST(core_JobSystem, CounterFencesDependentBatches)
+{
+    core_JobSystem   jobSystem(4);
+    std::vector<int> first(4096, 0);
+    std::vector<int> second(4096, 0);
+    for (int frame = 0; frame < 20; ++frame) {
+        core_ParallelFor(&jobSystem, 0, first.size(), 64, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                first[i] = frame;
+        });
+        // Reads elements written by other jobs of the previous batch
+        core_ParallelFor(&jobSystem, 0, second.size(), 64, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                second[i] = first[first.size() - 1 - i] + 1;
+        });
+        for (size_t i = 0; i < second.size(); ++i)
+            ASSERT_EQ(second[i], frame + 1);
+    }
+}
+
+TEST(core_JobSystem, ScalabilityBenchmark)
+{
+    const size_t       numItems = 1 << 20;
+    std::vector<float> data(numItems);
+    const size_t       maxWorkers = std::max(1u, std::thread::hardware_concurrency());
+
+    double singleThreaded = 0;
+    for (size_t numWorkers = 1; numWorkers <= maxWorkers; numWorkers *= 2) {
+        core_JobSystem jobSystem(numWorkers);
+        auto           start = std::chrono::high_resolution_clock::now();
+        for (int run = 0; run < 10; ++run) {
+            core_ParallelFor(&jobSystem, 0, numItems, 4096, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                    data[i] = sqrtf(float(i)) * sinf(float(i) + run);
+            });
+        }
+        auto   end = std::chrono::high_resolution_clock::now();
+        double ms  = std::chrono::duration<double, std::milli>(end - start).count() / 10;
+        if (numWorkers == 1)
+            singleThreaded = ms;
+        printf("[ BENCH    ] parallel for over %zu items with %zu workers: %.3f ms (%.2fx)\n", numItems, numWorkers, ms, singleThreaded / ms);
+    }
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <game_behaviour.h>
+
+using namespace pge;
+
+namespace
+{
+    class CountingBehaviour : public game_Behaviour {
+        int* m_alive;
+
+    public:
+        explicit CountingBehaviour(int* alive)
+            : m_alive(alive)
+        {
+            (*m_alive)++;
+        }
+        ~CountingBehaviour() override { (*m_alive)--; }
+        void Update(float delta) override {}
+    };
+
+    class UpdateBehaviour : public game_Behaviour {
+        float* m_elapsed;
+
+    public:
+        explicit UpdateBehaviour(float* elapsed)
+            : m_elapsed(elapsed)
+        {}
+        void Update(float delta) override { *m_elapsed += delta; }
+    };
+} // namespace
+
+TEST(game_BehaviourManager, GarbageCollectFreesDestroyedEntities)
+{
+    game_EntityManager    em;
+    game_BehaviourManager bm;
+    int                   alive = 0;
+
+    game_Entity entities[10];
+    em.CreateEntities(entities, 10);
+    for (const game_Entity& entity : entities)
+        bm.CreateBehaviour(entity, std::make_unique<CountingBehaviour>(&alive));
+    EXPECT_EQ(alive, 10);
+
+    em.DestroyEntity(entities[2]);
+    em.DestroyEntity(entities[5]);
+    em.DestroyEntity(entities[7]);
+    em.CreateEntity(entities[7]); // Resurrected before the collection, so it keeps its behaviour
+    EXPECT_EQ(em.GetDestroyedEntities().size(), 3u);
+
+    bm.GarbageCollect(em);
+    em.ClearDestroyedEntities();
+    EXPECT_EQ(alive, 8);
+    EXPECT_FALSE(bm.HasBehaviour(entities[2]));
+    EXPECT_FALSE(bm.HasBehaviour(entities[5]));
+    EXPECT_TRUE(bm.HasBehaviour(entities[7]));
+    EXPECT_TRUE(em.GetDestroyedEntities().empty());
+}
+
+TEST(game_BehaviourManager, UpdateRunsEveryBehaviour)
+{
+    game_EntityManager    em;
+    game_BehaviourManager bm;
+    float                 elapsed[3] = {};
+
+    game_Entity entities[3];
+    em.CreateEntities(entities, 3);
+    for (int i = 0; i < 3; ++i)
+        bm.CreateBehaviour(entities[i], std::make_unique<UpdateBehaviour>(&elapsed[i]));
+
+    bm.Update(0.5f);
+    bm.Update(0.25f);
+    for (float e : elapsed)
+        EXPECT_EQ(e, 0.75f);
+
+    // Collected behaviours no longer update
+    em.DestroyEntity(entities[1]);
+    bm.GarbageCollect(em);
+    bm.Update(1.0f);
+    EXPECT_EQ(elapsed[0], 1.75f);
+    EXPECT_EQ(elapsed[1], 0.75f);
+    EXPECT_EQ(elapsed[2], 1.75f);
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+#include <game_component_pool.h>
+
+using namespace pge;
+
+TEST(game_ComponentPool, InsertAndFind)
+{
+    game_ComponentPool<int> pool;
+    game_Entity             a(3, 0);
+    game_Entity             b(70, 2);
+    unsigned                ida = pool.Insert(a, 30);
+    unsigned                idb = pool.Insert(b, 700);
+
+    EXPECT_EQ(pool.Size(), 2u);
+    EXPECT_TRUE(pool.Has(a));
+    EXPECT_TRUE(pool.Has(b));
+    EXPECT_EQ(pool.GetId(a), ida);
+    EXPECT_EQ(pool.GetId(b), idb);
+    EXPECT_EQ(pool[ida], 30);
+    EXPECT_EQ(pool[idb], 700);
+    EXPECT_EQ(pool.GetEntity(idb), b);
+}
+
+TEST(game_ComponentPool, RejectsStaleGenerations)
+{
+    game_ComponentPool<int> pool;
+    pool.Insert(game_Entity(5, 1), 1);
+    EXPECT_FALSE(pool.Has(game_Entity(5, 0)));
+    EXPECT_FALSE(pool.Has(game_Entity(5, 2)));
+    EXPECT_FALSE(pool.Has(game_Entity(6, 1)));
+    EXPECT_FALSE(pool.Has(game_Entity(1000, 1)));
+    EXPECT_EQ(pool.Find(game_Entity(5, 2)), game_ComponentPool<int>::InvalidId);
+}
+
+TEST(game_ComponentPool, RemoveSwapsLastIntoPlace)
+{
+    game_ComponentPool<int> pool;
+    for (unsigned i = 0; i < 5; ++i)
+        pool.Insert(game_Entity(i, 0), i * 10);
+
+    pool.Remove(pool.GetId(game_Entity(1, 0)));
+    EXPECT_EQ(pool.Size(), 4u);
+    EXPECT_FALSE(pool.Has(game_Entity(1, 0)));
+    EXPECT_EQ(pool.GetId(game_Entity(4, 0)), 1u);
+    EXPECT_EQ(pool[1], 40);
+
+    pool.Remove(pool.GetId(game_Entity(3, 0)));
+    EXPECT_EQ(pool.Size(), 3u);
+    for (unsigned i : {0u, 2u, 4u})
+        EXPECT_EQ(pool[pool.GetId(game_Entity(i, 0))], int(i * 10));
+
+    pool.Insert(game_Entity(1, 1), 11);
+    EXPECT_TRUE(pool.Has(game_Entity(1, 1)));
+    EXPECT_FALSE(pool.Has(game_Entity(1, 0)));
+}
+
+TEST(game_ComponentPool, ReusingAnIndexBeforeCollectionReplacesTheStaleComponent)
+{
+    game_ComponentPool<int> pool;
+    for (unsigned i = 0; i < 4; ++i)
+        pool.Insert(game_Entity(i, 0), i * 10);
+
+    // Entity 1 was destroyed and its index reused before its component was collected
+    EXPECT_EQ(pool.FindAnyGeneration(game_Entity(1, 1)), pool.GetId(game_Entity(1, 0)));
+    pool.Insert(game_Entity(1, 1), 11);
+    EXPECT_EQ(pool.Size(), 4u);
+    EXPECT_FALSE(pool.Has(game_Entity(1, 0)));
+    ASSERT_TRUE(pool.Has(game_Entity(1, 1)));
+    EXPECT_EQ(pool[pool.GetId(game_Entity(1, 1))], 11);
+
+    // No dense entry is left behind for the old generation
+    unsigned numWithIndex = 0;
+    for (size_t id = 0; id < pool.Size(); ++id)
+        numWithIndex += pool.GetEntity(static_cast<unsigned>(id)).GetIndex() == 1 ? 1 : 0;
+    EXPECT_EQ(numWithIndex, 1u);
+
+    // Removing another entity leaves the new one mapped
+    pool.Remove(pool.GetId(game_Entity(0, 0)));
+    ASSERT_TRUE(pool.Has(game_Entity(1, 1)));
+    EXPECT_EQ(pool[pool.GetId(game_Entity(1, 1))], 11);
+    pool.Remove(pool.GetId(game_Entity(1, 1)));
+    EXPECT_FALSE(pool.Has(game_Entity(1, 1)));
+    EXPECT_EQ(pool.FindAnyGeneration(game_Entity(1, 2)), game_ComponentPool<int>::InvalidId);
+    for (unsigned i : {2u, 3u})
+        EXPECT_EQ(pool[pool.GetId(game_Entity(i, 0))], int(i * 10));
+}
+
+TEST(game_ComponentPool, GrowingKeepsAddresses)
+{
+    game_ComponentPool<int> pool(4);
+    pool.Insert(game_Entity(0, 0), 7);
+    const int* first = &pool[0];
+    for (unsigned i = 1; i < 10000; ++i)
+        pool.Insert(game_Entity(i, 0), int(i));
+
+    EXPECT_EQ(&pool[0], first);
+    EXPECT_EQ(*first, 7);
+    long long sum = 0;
+    for (int component : pool)
+        sum += component;
+    EXPECT_EQ(sum, 7 + 9999LL * 10000 / 2);
+}
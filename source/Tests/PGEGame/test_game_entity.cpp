@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include <game_entity.h>
+#include <mem_frame_arena.h>
+#include <sstream>
+
+using namespace pge;
+
+TEST(game_EntityManager, IteratesAliveEntities)
+{
+    game_EntityManager       em;
+    std::vector<game_Entity> entities(200);
+    em.CreateEntities(&entities[0], entities.size());
+    for (size_t i = 0; i < entities.size(); i += 3)
+        em.DestroyEntity(entities[i]);
+
+    std::vector<game_Entity> alive;
+    for (const game_Entity& entity : em)
+        alive.push_back(entity);
+
+    std::vector<game_Entity> expected;
+    for (size_t i = 0; i < entities.size(); ++i) {
+        if (i % 3 != 0)
+            expected.push_back(entities[i]);
+    }
+    EXPECT_EQ(alive, expected);
+}
+
+TEST(game_EntityManager, RecreateDestroyedEntity)
+{
+    game_EntityManager em;
+    game_Entity        a = em.CreateEntity();
+    game_Entity        b = em.CreateEntity();
+    em.DestroyEntity(a);
+    EXPECT_FALSE(em.IsEntityAlive(a));
+    EXPECT_FALSE(em.IsEntityAlive(game_Entity(a.GetIndex(), a.GetGeneration() + 1)));
+
+    em.CreateEntity(a);
+    EXPECT_TRUE(em.IsEntityAlive(a));
+    EXPECT_TRUE(em.IsEntityAlive(b));
+    EXPECT_EQ(*em.begin(), a);
+}
+
+TEST(game_EntityManager, SerializeRoundTrip)
+{
+    game_EntityManager em;
+    game_Entity        entities[100];
+    for (int i = 0; i < 100; ++i)
+        entities[i] = em.CreateEntity(std::to_string(i).c_str());
+    for (int i = 0; i < 100; i += 2)
+        em.DestroyEntity(entities[i]);
+
+    std::stringstream ss;
+    ss << em;
+    game_EntityManager loaded;
+    ss >> loaded;
+
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(loaded.IsEntityAlive(entities[i]), i % 2 != 0);
+        if (i % 2 != 0)
+            EXPECT_EQ(loaded.GetName(entities[i]), std::to_string(i));
+    }
+    game_Entity created = loaded.CreateEntity();
+    EXPECT_TRUE(loaded.IsEntityAlive(created));
+    EXPECT_EQ(created.GetIndex(), 100u);
+}
+
+TEST(game_EntityManager, GetNameFromFrameArena)
+{
+    game_EntityManager em;
+    mem_FrameArena     arena(1024);
+    game_Entity        named   = em.CreateEntity("Player");
+    game_Entity        unnamed = em.CreateEntity();
+
+    EXPECT_STREQ(em.GetName(named, &arena), "Player");
+    EXPECT_EQ(arena.GetCurrent().GetUsed(), 0u);
+    EXPECT_EQ(std::string(em.GetName(unnamed, &arena)), em.GetName(unnamed));
+    EXPECT_TRUE(arena.GetCurrent().Owns(em.GetName(unnamed, &arena)));
+}
@@ -0,0 +1,281 @@
+#include <gtest/gtest.h>
+#include <game_render_queue.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+using namespace pge;
+
+// The queue only compares resources by address, so no GPU resources are needed
+template <typename T>
+static const T*
+FakeResource(unsigned id)
+{
+    return reinterpret_cast<const T*>(static_cast<uintptr_t>(0x10000 + id * 64));
+}
+
+static const math_Mat4x4 Palette[2];
+
+// The model matrix carries the submission index, to check the order after sorting. Static commands are instanced.
+static game_RenderCommand
+CreateCommand(game_RenderPass pass, unsigned effect, unsigned material, unsigned mesh, bool skinned, unsigned index)
+{
+    game_RenderCommand command;
+    command.pass              = pass;
+    command.effect            = FakeResource<res_Effect>(effect);
+    command.material          = FakeResource<res_Material>(material);
+    command.mesh              = FakeResource<res_Mesh>(mesh);
+    command.modelMatrix       = math_Mat4x4();
+    command.modelMatrix[0][3] = static_cast<float>(index);
+    command.palette           = skinned ? Palette : nullptr;
+    command.numBones          = skinned ? 2 : 0;
+    command.instanced         = !skinned;
+    return command;
+}
+
+static unsigned
+GetIndex(const game_RenderCommand& command)
+{
+    return static_cast<unsigned>(command.modelMatrix[0][3]);
+}
+
+// The state changes of drawing the commands in the given order
+static game_RenderQueueStats
+CountStateChanges(const std::vector<const game_RenderCommand*>& commands)
+{
+    game_RenderQueueStats stats = {};
+    for (size_t i = 0; i < commands.size(); ++i) {
+        const bool first = i == 0 || commands[i - 1]->pass != commands[i]->pass;
+        stats.numCommands++;
+        stats.numEffectChanges += first || commands[i - 1]->effect != commands[i]->effect ? 1 : 0;
+        stats.numMaterialChanges += first || commands[i - 1]->material != commands[i]->material ? 1 : 0;
+        stats.numMeshChanges += first || commands[i - 1]->mesh != commands[i]->mesh ? 1 : 0;
+    }
+    return stats;
+}
+
+TEST(game_RenderQueue, GroupsStateThenDepth)
+{
+    game_RenderQueue queue;
+    queue.Submit(CreateCommand(game_RenderPass::LIGHTING, 1, 2, 3, false, 0), 0.5f);
+    queue.Submit(CreateCommand(game_RenderPass::LIGHTING, 1, 1, 4, false, 1), 0.5f);
+    queue.Submit(CreateCommand(game_RenderPass::LIGHTING, 1, 2, 3, false, 2), 0.2f);
+    queue.Submit(CreateCommand(game_RenderPass::LIGHTING, 2, 3, 5, true, 3), 0.1f);
+    queue.Submit(CreateCommand(game_RenderPass::LIGHTING, 1, 1, 4, false, 4), 0.9f);
+    queue.Submit(CreateCommand(game_RenderPass::LIGHTING, 1, 2, 6, false, 5), 0.0f);
+    queue.Sort();
+
+    // Effect 1 with material 2 was seen before material 1, so it gets the smaller id
+    const unsigned expectedOrder[]   = {2, 0, 5, 1, 4, 3};
+    const uint8_t  expectedChanges[] = {
+        game_RenderStateChange_Effect | game_RenderStateChange_Material | game_RenderStateChange_Mesh | game_RenderStateChange_Skinning,
+        0,
+        game_RenderStateChange_Mesh,
+        game_RenderStateChange_Material | game_RenderStateChange_Mesh,
+        0,
+        game_RenderStateChange_Effect | game_RenderStateChange_Material | game_RenderStateChange_Mesh | game_RenderStateChange_Skinning,
+    };
+    ASSERT_EQ(queue.Size(), 6u);
+    for (size_t i = 0; i < queue.Size(); ++i) {
+        EXPECT_EQ(GetIndex(queue.GetCommand(i)), expectedOrder[i]) << "at " << i;
+        EXPECT_EQ(queue.GetStateChanges(i), expectedChanges[i]) << "at " << i;
+    }
+
+    const game_RenderQueueStats& stats = queue.GetStats();
+    EXPECT_EQ(stats.numCommands, 6u);
+    EXPECT_EQ(stats.numEffectChanges, 2u);
+    EXPECT_EQ(stats.numMaterialChanges, 3u);
+    EXPECT_EQ(stats.numMeshChanges, 4u);
+
+    queue.Clear();
+    EXPECT_EQ(queue.Size(), 0u);
+    queue.Sort();
+    EXPECT_EQ(queue.GetStats().numCommands, 0u);
+    EXPECT_EQ(queue.GetNumBatches(), 0u);
+}
+
+TEST(game_RenderQueue, BatchesInstancedRuns)
+{
+    game_RenderQueue queue;
+    // Three copies of a static mesh, one of them not instanced
+    queue.Submit(CreateCommand(game_RenderPass::LIGHTING, 1, 1, 1, false, 0), 0.1f);
+    queue.Submit(CreateCommand(game_RenderPass::LIGHTING, 1, 1, 1, false, 1), 0.2f);
+    game_RenderCommand single = CreateCommand(game_RenderPass::LIGHTING, 1, 1, 1, false, 2);
+    single.instanced          = false;
+    queue.Submit(single, 0.3f);
+    queue.Submit(CreateCommand(game_RenderPass::LIGHTING, 1, 1, 1, false, 3), 0.4f);
+    // The same mesh with another material, and two skinned copies
+    queue.Submit(CreateCommand(game_RenderPass::LIGHTING, 1, 2, 1, false, 4), 0.5f);
+    queue.Submit(CreateCommand(game_RenderPass::LIGHTING, 1, 2, 1, false, 5), 0.6f);
+    queue.Submit(CreateCommand(game_RenderPass::LIGHTING, 2, 3, 2, true, 6), 0.7f);
+    queue.Submit(CreateCommand(game_RenderPass::LIGHTING, 2, 3, 2, true, 7), 0.8f);
+    // The depth pass comes first, in batches of its own
+    queue.Submit(CreateCommand(game_RenderPass::DEPTH, 1, 1, 1, false, 8), 0.9f);
+    queue.Submit(CreateCommand(game_RenderPass::DEPTH, 1, 1, 1, false, 9), 1.0f);
+    queue.Sort();
+
+    const game_RenderBatch expected[] = {{0, 2}, {2, 2}, {4, 1}, {5, 1}, {6, 2}, {8, 1}, {9, 1}};
+    const size_t           numBatches = sizeof(expected) / sizeof(expected[0]);
+    ASSERT_EQ(queue.GetNumBatches(), numBatches);
+    EXPECT_EQ(queue.GetStats().numBatches, numBatches);
+    for (size_t i = 0; i < numBatches; ++i) {
+        EXPECT_EQ(queue.GetBatch(i).first, expected[i].first) << "batch " << i;
+        EXPECT_EQ(queue.GetBatch(i).count, expected[i].count) << "batch " << i;
+    }
+    // The command that isn't instanced splits the run of its copies
+    EXPECT_EQ(GetIndex(queue.GetCommand(queue.GetBatch(2).first)), 2u);
+
+    // Batches are split at the largest instanced draw
+    queue.Clear();
+    const size_t numCommands = game_RenderQueue::MAX_BATCH_SIZE * 2 + 1;
+    for (size_t i = 0; i < numCommands; ++i)
+        queue.Submit(CreateCommand(game_RenderPass::SHADOW, 1, 1, 1, false, static_cast<unsigned>(i)), 0.5f);
+    queue.Sort();
+    ASSERT_EQ(queue.GetNumBatches(), 3u);
+    EXPECT_EQ(queue.GetBatch(0).count, game_RenderQueue::MAX_BATCH_SIZE);
+    EXPECT_EQ(queue.GetBatch(1).count, game_RenderQueue::MAX_BATCH_SIZE);
+    EXPECT_EQ(queue.GetBatch(2).count, 1u);
+}
+
+TEST(game_RenderQueue, SortIsOrderedAndStable)
+{
+    std::mt19937                          random(11);
+    std::uniform_int_distribution<int>    effect(0, 4), material(0, 40), mesh(0, 300), pass(0, 2), skinned(0, 9);
+    std::uniform_real_distribution<float> depth(-0.1f, 1.1f);
+
+    game_RenderQueue queue;
+    for (int frame = 0; frame < 3; ++frame) {
+        queue.Clear();
+        const unsigned numCommands = 5000;
+        for (unsigned i = 0; i < numCommands; ++i) {
+            // Few distinct depths, so many keys are equal
+            const float quantizedDepth = std::round(depth(random) * 8) / 8;
+            queue.Submit(CreateCommand(static_cast<game_RenderPass>(pass(random)), effect(random), material(random), mesh(random), skinned(random) == 0, i),
+                         quantizedDepth);
+        }
+        queue.Sort();
+        ASSERT_EQ(queue.Size(), numCommands);
+
+        std::vector<bool>                      seen(numCommands, false);
+        std::vector<const game_RenderCommand*> sorted;
+        for (size_t i = 0; i < queue.Size(); ++i) {
+            const unsigned index = GetIndex(queue.GetCommand(i));
+            ASSERT_FALSE(seen[index]);
+            seen[index] = true;
+            sorted.push_back(&queue.GetCommand(i));
+            if (i > 0) {
+                ASSERT_LE(queue.GetKey(i - 1), queue.GetKey(i));
+                if (queue.GetKey(i - 1) == queue.GetKey(i)) {
+                    ASSERT_LT(GetIndex(queue.GetCommand(i - 1)), index) << "equal keys keep their submission order";
+                }
+                if (queue.GetCommand(i - 1).pass == queue.GetCommand(i).pass) {
+                    ASSERT_EQ(queue.GetStateChanges(i) & game_RenderStateChange_Mesh, queue.GetCommand(i - 1).mesh != queue.GetCommand(i).mesh ? game_RenderStateChange_Mesh : 0);
+                }
+            }
+        }
+
+        // Passes come in order, and the counted changes are those of drawing in sorted order
+        EXPECT_EQ(queue.GetCommand(0).pass, game_RenderPass::DEPTH);
+        EXPECT_EQ(queue.GetCommand(queue.Size() - 1).pass, game_RenderPass::LIGHTING);
+        const game_RenderQueueStats expected = CountStateChanges(sorted);
+        EXPECT_EQ(queue.GetStats().numEffectChanges, expected.numEffectChanges);
+        EXPECT_EQ(queue.GetStats().numMaterialChanges, expected.numMaterialChanges);
+        EXPECT_EQ(queue.GetStats().numMeshChanges, expected.numMeshChanges);
+
+        // Batches cover the commands in order, and share the state of their first command
+        size_t next = 0;
+        for (size_t b = 0; b < queue.GetNumBatches(); ++b) {
+            const game_RenderBatch&   batch = queue.GetBatch(b);
+            const game_RenderCommand& first = queue.GetCommand(batch.first);
+            ASSERT_EQ(batch.first, next);
+            ASSERT_GE(batch.count, 1u);
+            ASSERT_LE(batch.count, game_RenderQueue::MAX_BATCH_SIZE);
+            for (size_t i = batch.first + 1; i < batch.first + batch.count; ++i) {
+                const game_RenderCommand& command = queue.GetCommand(i);
+                ASSERT_TRUE(command.instanced && command.palette == nullptr);
+                ASSERT_TRUE(command.pass == first.pass && command.effect == first.effect && command.material == first.material
+                            && command.mesh == first.mesh);
+            }
+            next += batch.count;
+        }
+        EXPECT_EQ(next, queue.Size());
+    }
+}
+
+TEST(game_RenderQueue, MoreResourcesThanIdsKeepKeysInTheirFields)
+{
+    // More effects than the key has ids for, all at the same depth
+    game_RenderQueue queue;
+    const unsigned   numEffects = 3000;
+    for (unsigned i = 0; i < numEffects; ++i) {
+        queue.Submit(CreateCommand(game_RenderPass::DEPTH, i, 0, 0, false, i), 0.5f);
+    }
+    queue.Submit(CreateCommand(game_RenderPass::LIGHTING, 0, 0, 0, false, numEffects), 0.5f);
+    queue.Sort();
+
+    // The overflowing effects must not spill into the pass, and every change of effect is still bound
+    ASSERT_EQ(queue.Size(), numEffects + 1);
+    for (size_t i = 0; i < numEffects; ++i) {
+        EXPECT_EQ(queue.GetCommand(i).pass, game_RenderPass::DEPTH);
+    }
+    EXPECT_EQ(queue.GetCommand(numEffects).pass, game_RenderPass::LIGHTING);
+    EXPECT_EQ(queue.GetStats().numEffectChanges, numEffects + 1);
+
+    // The next frame starts handing out ids again, so a new effect gets the first one
+    game_RenderQueue fresh;
+    fresh.Submit(CreateCommand(game_RenderPass::DEPTH, numEffects, 0, 0, false, 0), 0.5f);
+    fresh.Sort();
+    queue.Clear();
+    queue.Submit(CreateCommand(game_RenderPass::DEPTH, numEffects, 0, 0, false, 0), 0.5f);
+    queue.Sort();
+    EXPECT_EQ(queue.GetKey(0), fresh.GetKey(0));
+}
+
+TEST(game_RenderQueue, SortBenchmark)
+{
+    // A dungeon-like frame: few effects, a few dozen materials and a few hundred meshes, in component order
+    std::mt19937                          random(13);
+    std::uniform_int_distribution<int>    material(0, 30), mesh(0, 250);
+    std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+    const unsigned                        numCommands = 20000;
+
+    std::vector<game_RenderCommand> commands;
+    std::vector<float>              depths;
+    for (unsigned i = 0; i < numCommands; ++i) {
+        const int meshId = mesh(random);
+        commands.push_back(CreateCommand(game_RenderPass::LIGHTING, meshId % 3, material(random), meshId, false, i));
+        depths.push_back(depth(random));
+    }
+
+    game_RenderQueue queue;
+    const int        numFrames = 20;
+    auto             start     = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < numFrames; ++frame) {
+        queue.Clear();
+        for (unsigned i = 0; i < numCommands; ++i)
+            queue.Submit(commands[i], depths[i]);
+        queue.Sort();
+    }
+    auto   end       = std::chrono::high_resolution_clock::now();
+    double queueTime = std::chrono::duration<double, std::milli>(end - start).count() / numFrames;
+
+    std::vector<const game_RenderCommand*> unsorted;
+    for (const game_RenderCommand& command : commands)
+        unsorted.push_back(&command);
+    const game_RenderQueueStats  before = CountStateChanges(unsorted);
+    const game_RenderQueueStats& after  = queue.GetStats();
+    EXPECT_LT(after.numMaterialChanges, before.numMaterialChanges);
+    EXPECT_LT(after.numMeshChanges, before.numMeshChanges);
+    printf("[ BENCH    ] %u draws: %.3f ms to submit and sort, effect/material/mesh changes %zu/%zu/%zu in submission order, %zu/%zu/%zu sorted, %zu draw calls after instancing\n",
+           numCommands,
+           queueTime,
+           before.numEffectChanges,
+           before.numMaterialChanges,
+           before.numMeshChanges,
+           after.numEffectChanges,
+           after.numMaterialChanges,
+           after.numMeshChanges,
+           after.numBatches);
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <game_script.h>
+#include <core_log.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+using namespace pge;
+
+static void
+WriteScript(const char* path, const char* source)
+{
+    std::ofstream file(path);
+    file << source;
+}
+
+static size_t
+CountLogRecords(const char* message)
+{
+    size_t count = 0;
+    for (const auto& record : core_GetLogRecords()) {
+        if (record.message.find(message) != std::string::npos)
+            count++;
+    }
+    return count;
+}
+
+TEST(game_ScriptManager, ScriptsSharingAFileHaveOwnState)
+{
+    const char* path = "test_game_script_state.lua";
+    WriteScript(path,
+                "count = 0\n"
+                "function onUpdate(dt)\n"
+                "    count = count + 1\n"
+                "    if count == 3 then print('count reached 3') end\n"
+                "end\n");
+
+    core_ClearLogRecords();
+    {
+        game_ScriptManager scriptManager(2);
+        scriptManager.CreateScript(game_Entity(1, 0), path);
+        scriptManager.CreateScript(game_Entity(2, 0), path);
+        for (int i = 0; i < 3; ++i)
+            scriptManager.UpdateScripts();
+    }
+    EXPECT_EQ(CountLogRecords("count reached 3"), 2);
+    std::remove(path);
+}
+
+TEST(game_ScriptManager, ReloadPicksUpChangedSource)
+{
+    const char* path = "test_game_script_reload.lua";
+    WriteScript(path, "function onUpdate(dt) print('old source') end\n");
+
+    core_ClearLogRecords();
+    game_ScriptManager scriptManager(1);
+    scriptManager.CreateScript(game_Entity(1, 0), path);
+    scriptManager.UpdateScripts();
+
+    WriteScript(path, "function onUpdate(dt) print('new source') end\n");
+    scriptManager.UpdateScripts();
+    scriptManager.ReloadScript(path);
+    scriptManager.UpdateScripts();
+
+    EXPECT_EQ(CountLogRecords("old source"), 2);
+    EXPECT_EQ(CountLogRecords("new source"), 1);
+    std::remove(path);
+}
+
+TEST(game_ScriptManager, UpdateBenchmark)
+{
+    const char* path       = "test_game_script_bench.lua";
+    const int   numScripts = 1000;
+    const int   numFrames  = 100;
+    WriteScript(path,
+                "local x = 0\n"
+                "function onUpdate(dt)\n"
+                "    x = x + dt * 2.0\n"
+                "end\n");
+
+    game_ScriptManager scriptManager(numScripts);
+    for (int i = 0; i < numScripts; ++i)
+        scriptManager.CreateScript(game_Entity(i + 1, 0), path);
+
+    scriptManager.UpdateScripts();
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < numFrames; ++i)
+        scriptManager.UpdateScripts();
+    auto   end     = std::chrono::high_resolution_clock::now();
+    double msFrame = std::chrono::duration<double, std::milli>(end - start).count() / numFrames;
+    printf("[ BENCH    ] %d scripts: %.4f ms/frame\n", numScripts, msFrame);
+    std::remove(path);
+}
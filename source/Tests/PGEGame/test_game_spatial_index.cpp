@@ -0,0 +1,196 @@
+#include <gtest/gtest.h>
+#include <game_spatial_index.h>
+#include <game_transform.h>
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+using namespace pge;
+
+static math_AABB
+RandomBox(std::mt19937* random, float worldSize, float maxSize)
+{
+    std::uniform_real_distribution<float> position(-worldSize, worldSize);
+    std::uniform_real_distribution<float> size(0.1f, maxSize);
+    math_Vec3                             min(position(*random), position(*random), position(*random) * 0.1f);
+    return math_AABB(min, min + math_Vec3(size(*random), size(*random), size(*random)));
+}
+
+static bool
+Overlaps(const math_AABB& a, const math_AABB& b)
+{
+    return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y && a.max.y >= b.min.y && a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+static std::vector<unsigned>
+Sorted(const std::vector<game_Entity>& entities)
+{
+    std::vector<unsigned> ids;
+    for (const game_Entity& entity : entities)
+        ids.push_back(entity.id);
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+// Compares every query with testing all boxes
+static void
+ExpectMatchesBruteForce(const game_SpatialIndex& index, const std::vector<math_AABB>& boxes, const std::vector<bool>& indexed, std::mt19937* random)
+{
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (int query = 0; query < 50; ++query) {
+        math_AABB box = RandomBox(random, 60.0f, 20.0f);
+        math_Ray  ray(math_Vec3(unit(*random) * 80, unit(*random) * 80, unit(*random) * 10),
+                      math_Normalize(math_Vec3(unit(*random), unit(*random), unit(*random) * 0.2f)));
+        math_Vec3 center = box.min;
+        float     radius = 15.0f * (unit(*random) + 1);
+
+        std::vector<game_Entity> expectedBox, expectedSphere, expectedRay;
+        float                    closestDistance = FLT_MAX;
+        for (unsigned i = 0; i < boxes.size(); ++i) {
+            if (!indexed[i])
+                continue;
+            if (Overlaps(boxes[i], box))
+                expectedBox.push_back(game_Entity(i));
+            math_Vec3 closest(std::min(std::max(center.x, boxes[i].min.x), boxes[i].max.x),
+                              std::min(std::max(center.y, boxes[i].min.y), boxes[i].max.y),
+                              std::min(std::max(center.z, boxes[i].min.z), boxes[i].max.z));
+            if (math_LengthSquared(closest - center) <= radius * radius)
+                expectedSphere.push_back(game_Entity(i));
+            float distance = 0;
+            if (math_Raycast_IntersectsAABB(ray, boxes[i], &distance)) {
+                if (distance <= 100.0f)
+                    expectedRay.push_back(game_Entity(i));
+                closestDistance = std::min(closestDistance, distance);
+            }
+        }
+
+        std::vector<game_Entity> result;
+        index.QueryAABB(box, &result);
+        EXPECT_EQ(Sorted(result), Sorted(expectedBox)) << "query " << query;
+        result.clear();
+        index.QuerySphere(center, radius, &result);
+        EXPECT_EQ(Sorted(result), Sorted(expectedSphere)) << "query " << query;
+        result.clear();
+        index.QueryRay(ray, 100.0f, &result);
+        EXPECT_EQ(Sorted(result), Sorted(expectedRay)) << "query " << query;
+
+        float       distance = 0;
+        game_Entity hit      = index.Raycast(ray, &distance);
+        EXPECT_EQ(distance, closestDistance) << "query " << query;
+        if (closestDistance < FLT_MAX) {
+            float hitDistance = 0;
+            ASSERT_NE(hit, game_Entity(game_EntityId_Invalid));
+            EXPECT_TRUE(math_Raycast_IntersectsAABB(ray, boxes[hit.id], &hitDistance));
+            EXPECT_EQ(hitDistance, closestDistance);
+        } else {
+            EXPECT_EQ(hit, game_Entity(game_EntityId_Invalid));
+        }
+    }
+}
+
+TEST(game_SpatialIndex, QueriesMatchBruteForce)
+{
+    std::mt19937           random(31);
+    game_SpatialIndex      index(4.0f);
+    std::vector<math_AABB> boxes;
+    for (unsigned i = 0; i < 2000; ++i) {
+        // A few span too many cells, and go to the oversized list
+        boxes.push_back(RandomBox(&random, 50.0f, i % 100 == 0 ? 40.0f : 3.0f));
+        index.Update(game_Entity(i), boxes.back());
+    }
+    std::vector<bool> indexed(boxes.size(), true);
+    EXPECT_EQ(index.Size(), boxes.size());
+    ExpectMatchesBruteForce(index, boxes, indexed, &random);
+
+    // Move a third and remove a tenth of them
+    for (unsigned i = 0; i < boxes.size(); ++i) {
+        if (i % 10 == 3) {
+            index.Remove(game_Entity(i));
+            indexed[i] = false;
+        } else if (i % 3 == 0) {
+            boxes[i] = RandomBox(&random, 50.0f, i % 99 == 0 ? 40.0f : 3.0f);
+            index.Update(game_Entity(i), boxes[i]);
+        }
+    }
+    EXPECT_FALSE(index.Has(game_Entity(3)));
+    EXPECT_EQ(index.GetBounds(game_Entity(6)).min, boxes[6].min);
+    ExpectMatchesBruteForce(index, boxes, indexed, &random);
+}
+
+TEST(game_TransformManager, ReportsMovedEntities)
+{
+    game_TransformManager    tm(16);
+    std::vector<game_Entity> moved;
+    tm.TakeMovedEntities(&moved); // Starts tracking
+    EXPECT_TRUE(moved.empty());
+
+    tm.CreateTransform(game_Entity(0, 0));
+    tm.CreateTransform(game_Entity(1, 0));
+    tm.CreateTransform(game_Entity(2, 0));
+    tm.SetParent(tm.GetTransformId(game_Entity(2, 0)), tm.GetTransformId(game_Entity(1, 0)));
+    tm.UpdateWorldTransforms();
+    tm.TakeMovedEntities(&moved);
+    EXPECT_EQ(Sorted(moved), (std::vector<unsigned>{game_Entity(0, 0).id, game_Entity(1, 0).id, game_Entity(2, 0).id}));
+
+    // Moving a parent moves its children
+    tm.Translate(tm.GetTransformId(game_Entity(1, 0)), math_Vec3(1, 0, 0));
+    tm.UpdateWorldTransforms();
+    tm.TakeMovedEntities(&moved);
+    EXPECT_EQ(Sorted(moved), (std::vector<unsigned>{game_Entity(1, 0).id, game_Entity(2, 0).id}));
+    tm.TakeMovedEntities(&moved);
+    EXPECT_TRUE(moved.empty());
+}
+
+TEST(game_SpatialIndex, PickingBenchmark)
+{
+    // A 300 mesh dungeon and a 100k entity stress world, both picked with rays across the level
+    const unsigned worldSizes[2] = {300, 100000};
+    for (unsigned numEntities : worldSizes) {
+        std::mt19937           random(37);
+        const float            worldSize = std::sqrt(float(numEntities));
+        game_SpatialIndex      index(4.0f);
+        std::vector<math_AABB> boxes;
+        for (unsigned i = 0; i < numEntities; ++i) {
+            boxes.push_back(RandomBox(&random, worldSize, 2.0f));
+            index.Update(game_Entity(i), boxes.back());
+        }
+
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<math_Ray>                 rays;
+        for (int i = 0; i < 200; ++i) {
+            math_Vec3 target(unit(random) * worldSize, unit(random) * worldSize, 0);
+            math_Vec3 eye = target + math_Vec3(0, -10, 12);
+            rays.push_back(math_Ray(eye, math_Normalize(target - eye)));
+        }
+
+        unsigned numHits = 0;
+        auto     start   = std::chrono::high_resolution_clock::now();
+        for (const math_Ray& ray : rays)
+            numHits += index.Raycast(ray, nullptr) != game_Entity(game_EntityId_Invalid) ? 1 : 0;
+        auto   end     = std::chrono::high_resolution_clock::now();
+        double indexed = std::chrono::duration<double, std::milli>(end - start).count() / rays.size();
+
+        unsigned bruteHits = 0;
+        start              = std::chrono::high_resolution_clock::now();
+        for (const math_Ray& ray : rays) {
+            bool hit = false;
+            for (const math_AABB& box : boxes) {
+                float distance = 0;
+                hit            = math_Raycast_IntersectsAABB(ray, box, &distance) || hit;
+            }
+            bruteHits += hit ? 1 : 0;
+        }
+        end          = std::chrono::high_resolution_clock::now();
+        double brute = std::chrono::duration<double, std::milli>(end - start).count() / rays.size();
+        EXPECT_EQ(numHits, bruteHits);
+        printf("[ BENCH    ] raycast %u entities: %.4f ms indexed, %.4f ms brute force (%u of %zu rays hit)\n",
+               numEntities,
+               indexed,
+               brute,
+               numHits,
+               rays.size());
+    }
+}
@@ -0,0 +1,293 @@
+#include <gtest/gtest.h>
+#include <game_transform.h>
+#include <game_component_pool.h>
+#include <chrono>
+#include <cstdio>
+
+using namespace pge;
+
+static void
+ExpectNear(const math_Vec3& a, const math_Vec3& b)
+{
+    EXPECT_NEAR(a.x, b.x, 1e-4f);
+    EXPECT_NEAR(a.y, b.y, 1e-4f);
+    EXPECT_NEAR(a.z, b.z, 1e-4f);
+}
+
+// Builds a chain (deep) or a single parent with all others as its children (wide); entity i has index i
+static void
+CreateHierarchy(game_TransformManager* tm, unsigned numTransforms, bool deep)
+{
+    for (unsigned i = 0; i < numTransforms; ++i) {
+        tm->CreateTransform(game_Entity(i, 0), math_Vec3(1, 0, 0));
+        if (i > 0) {
+            tm->SetParent(tm->GetTransformId(game_Entity(i, 0)), tm->GetTransformId(game_Entity(deep ? i - 1 : 0, 0)));
+        }
+    }
+    tm->UpdateWorldTransforms();
+}
+
+static game_TransformId
+Tid(const game_TransformManager& tm, unsigned index)
+{
+    return tm.GetTransformId(game_Entity(index, 0));
+}
+
+TEST(game_TransformManager, WorldResolvesLazily)
+{
+    game_TransformManager tm(16);
+    CreateHierarchy(&tm, 4, true);
+    ExpectNear(tm.GetWorldPosition(Tid(tm, 3)), math_Vec3(1, 0, 0)); // Parenting keeps the world position
+
+    tm.SetLocalPosition(Tid(tm, 0), math_Vec3(10, 0, 0));
+    tm.SetLocalPosition(Tid(tm, 2), math_Vec3(0, 5, 0));
+    ExpectNear(tm.GetWorldPosition(Tid(tm, 3)), math_Vec3(10, 5, 0)); // Without an update in between
+    ExpectNear(tm.GetWorldPosition(Tid(tm, 1)), math_Vec3(10, 0, 0));
+
+    tm.Translate(Tid(tm, 1), math_Vec3(0, 0, 1));
+    tm.UpdateWorldTransforms();
+    ExpectNear(tm.GetWorldPosition(Tid(tm, 3)), math_Vec3(10, 5, 1));
+}
+
+TEST(game_TransformManager, DestroyKeepsChildrenInPlace)
+{
+    game_TransformManager tm(16);
+    CreateHierarchy(&tm, 3, true);
+    tm.SetLocalPosition(Tid(tm, 0), math_Vec3(0, 2, 0));
+
+    tm.DestroyTransform(Tid(tm, 1));
+    game_TransformId child = Tid(tm, 2);
+    EXPECT_EQ(tm.GetParent(child), game_TransformId_Invalid);
+    ExpectNear(tm.GetWorldPosition(child), math_Vec3(0, 2, 0));
+}
+
+TEST(game_TransformManager, ReusingAnIndexBeforeCollectionReplacesTheStaleTransform)
+{
+    game_TransformManager tm(16);
+    CreateHierarchy(&tm, 3, true);
+    tm.SetLocalPosition(Tid(tm, 0), math_Vec3(0, 2, 0));
+
+    // Entity 1 was destroyed and its index reused before its transform was collected
+    tm.CreateTransform(game_Entity(1, 1), math_Vec3(0, 0, 7));
+    EXPECT_EQ(tm.GetNumTransforms(), 3u);
+    EXPECT_FALSE(tm.HasTransform(game_Entity(1, 0)));
+    ASSERT_TRUE(tm.HasTransform(game_Entity(1, 1)));
+    game_TransformId reused = tm.GetTransformId(game_Entity(1, 1));
+    EXPECT_EQ(tm.GetParent(reused), game_TransformId_Invalid);
+    ExpectNear(tm.GetWorldPosition(reused), math_Vec3(0, 0, 7));
+
+    // The old generation's child is a root that kept its place
+    game_TransformId child = Tid(tm, 2);
+    EXPECT_EQ(tm.GetParent(child), game_TransformId_Invalid);
+    ExpectNear(tm.GetWorldPosition(child), math_Vec3(0, 2, 0));
+}
+
+TEST(game_TransformManager, WorldRotationAndScaleAreCached)
+{
+    game_TransformManager tm(4);
+    tm.CreateTransform(game_Entity(0, 0), math_Vec3(1, 0, 0), math_QuatFromAxisAngle(math_Vec3(0, 0, 1), 90), math_Vec3(2, 2, 2));
+    tm.CreateTransform(game_Entity(1, 0));
+    tm.SetParent(Tid(tm, 1), Tid(tm, 0));
+    tm.SetLocal(Tid(tm, 1), math_Vec3(0, 1, 0), math_QuatFromAxisAngle(math_Vec3(0, 0, 1), 90), math_Vec3(1, 3, 1));
+
+    // Queried before any update, so the cached values have to be resolved lazily.
+    // Scale applies along the parent's axes (T * S * R), so the child's stretch ends up along x.
+    const math_Quat expected = math_QuatFromAxisAngle(math_Vec3(0, 0, 1), 180);
+    EXPECT_NEAR(fabsf(math_Dot(tm.GetWorldRotation(Tid(tm, 1)), expected)), 1.0f, 1e-4f);
+    ExpectNear(tm.GetWorldScale(Tid(tm, 1)), math_Vec3(6, 2, 2));
+    ExpectNear(tm.GetWorldScale(Tid(tm, 0)), math_Vec3(2, 2, 2));
+    ExpectNear(tm.GetWorldPosition(Tid(tm, 1)), math_Vec3(-1, 0, 0));
+
+    tm.SetLocalScale(Tid(tm, 0), math_Vec3(1, 1, 1));
+    tm.UpdateWorldTransforms();
+    ExpectNear(tm.GetWorldScale(Tid(tm, 1)), math_Vec3(3, 1, 1));
+    EXPECT_NEAR(fabsf(math_Dot(tm.GetWorldRotation(Tid(tm, 0)), math_QuatFromAxisAngle(math_Vec3(0, 0, 1), 90))), 1.0f, 1e-4f);
+}
+
+TEST(game_TransformManager, ZeroScaleKeepsRotationFinite)
+{
+    game_TransformManager tm(4);
+    const math_Quat       rotation = math_QuatFromAxisAngle(math_Vec3(0, 0, 1), 90);
+    tm.CreateTransform(game_Entity(0, 0), math_Vec3(1, 0, 0), rotation);
+    tm.CreateTransform(game_Entity(1, 0), math_Vec3(0, 1, 0), rotation);
+
+    // One flattened axis still tells the rotation, more than one doesn't
+    tm.SetLocalScale(Tid(tm, 0), math_Vec3(1, 0, 1));
+    tm.SetLocalScale(Tid(tm, 1), math_Vec3(0, 0, 2));
+    tm.UpdateWorldTransforms();
+    EXPECT_NEAR(fabsf(math_Dot(tm.GetWorldRotation(Tid(tm, 0)), rotation)), 1.0f, 1e-4f);
+    ExpectNear(tm.GetWorldScale(Tid(tm, 0)), math_Vec3(1, 0, 1));
+    const math_Quat flat = tm.GetWorldRotation(Tid(tm, 1));
+    EXPECT_NEAR(math_Dot(flat, flat), 1.0f, 1e-4f);
+    ExpectNear(tm.GetWorldScale(Tid(tm, 1)), math_Vec3(0, 0, 2));
+}
+
+// Checks that transforms are sorted by depth and that the world matrices match their local chain
+static void
+ExpectOrderedHierarchy(const game_TransformManager& tm, unsigned numTransforms)
+{
+    unsigned prevDepth = 0;
+    for (game_TransformId id = 0; id < numTransforms; ++id) {
+        unsigned    depth = 0;
+        math_Mat4x4 world = tm.GetLocalMatrix(id);
+        for (game_TransformId p = tm.GetParent(id); p != game_TransformId_Invalid; p = tm.GetParent(p)) {
+            EXPECT_LT(p, id);
+            world = tm.GetLocalMatrix(p) * world;
+            ++depth;
+        }
+        EXPECT_GE(depth, prevDepth);
+        prevDepth = depth;
+        ExpectNear(tm.GetWorldPosition(id), math_Vec3(world[0][3], world[1][3], world[2][3]));
+    }
+}
+
+TEST(game_TransformManager, HierarchyStaysSortedByDepth)
+{
+    const unsigned        numTransforms = 64;
+    game_TransformManager tm(numTransforms);
+    for (unsigned i = 0; i < numTransforms; ++i) {
+        tm.CreateTransform(game_Entity(i, 0), math_Vec3(float(i), 0, 0));
+    }
+
+    unsigned seed = 12345;
+    auto     rand = [&seed](unsigned n) {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) % n;
+    };
+    auto reparent = [&](unsigned child, unsigned parent) {
+        game_TransformId cid = Tid(tm, child);
+        game_TransformId pid = Tid(tm, parent);
+        if (child != parent && !tm.IsAncestor(pid, cid)) {
+            tm.SetParent(cid, pid);
+        }
+    };
+
+    for (unsigned i = 1; i < numTransforms; ++i) {
+        reparent(i, rand(i));
+    }
+    tm.UpdateWorldTransforms();
+    ExpectOrderedHierarchy(tm, numTransforms);
+    ExpectNear(tm.GetWorldPosition(Tid(tm, 40)), math_Vec3(40, 0, 0)); // Parenting keeps the world position
+
+    for (unsigned i = 0; i < 32; ++i) {
+        reparent(rand(numTransforms), rand(numTransforms));
+        if (i % 8 == 0) {
+            tm.SetParent(Tid(tm, rand(numTransforms)), game_TransformId_Invalid);
+        }
+        tm.SetLocalPosition(Tid(tm, rand(numTransforms)), math_Vec3(0, float(i), 0));
+    }
+    tm.UpdateWorldTransforms();
+    ExpectOrderedHierarchy(tm, numTransforms);
+
+    unsigned numAlive = numTransforms;
+    for (unsigned i = 0; i < numTransforms; i += 3) {
+        if (i + 1 < numTransforms) {
+            tm.Translate(Tid(tm, i + 1), math_Vec3(0, 0, 1));
+        }
+        tm.DestroyTransform(Tid(tm, i));
+        --numAlive;
+    }
+    tm.UpdateWorldTransforms();
+    ExpectOrderedHierarchy(tm, numAlive);
+}
+
+static void
+GarbageCollect(game_EntityManager* em, game_TransformManager* tm, game_ComponentPool<unsigned>* pool)
+{
+    tm->GarbageCollect(*em);
+    for (const game_Entity& entity : em->GetDestroyedEntities()) {
+        if (pool->Has(entity))
+            pool->Remove(pool->GetId(entity));
+    }
+    em->ClearDestroyedEntities();
+}
+
+TEST(game_TransformManager, CreateDestroyManyEntities)
+{
+    const unsigned numEntities = 250000;
+    auto           start       = std::chrono::high_resolution_clock::now();
+
+    // Start small, so both the transforms and the pool have to grow many times
+    game_EntityManager           em;
+    game_TransformManager        tm(16);
+    game_ComponentPool<unsigned> pool(16);
+    std::vector<game_Entity>     entities(numEntities);
+    em.CreateEntities(&entities[0], numEntities);
+    pool.Insert(entities[0], 0);
+    const unsigned* firstComponent = &pool[0];
+    for (unsigned i = 0; i < numEntities; ++i) {
+        tm.CreateTransform(entities[i], math_Vec3(float(i), 0, 0));
+        if (i > 0)
+            pool.Insert(entities[i], i);
+        if (i % 4 != 0)
+            tm.SetParent(tm.GetTransformId(entities[i]), tm.GetTransformId(entities[i - 1]));
+    }
+    tm.UpdateWorldTransforms();
+    EXPECT_EQ(tm.GetNumTransforms(), numEntities);
+    EXPECT_EQ(pool.Size(), numEntities);
+    EXPECT_EQ(&pool[0], firstComponent);
+    ExpectNear(tm.GetWorldPosition(tm.GetTransformId(entities[numEntities - 1])), math_Vec3(float(numEntities - 1), 0, 0));
+
+    for (unsigned i = 0; i < numEntities; i += 2)
+        em.DestroyEntity(entities[i]);
+    GarbageCollect(&em, &tm, &pool);
+    EXPECT_EQ(tm.GetNumTransforms(), numEntities / 2);
+    EXPECT_EQ(pool.Size(), numEntities / 2);
+    for (unsigned i = 1; i < numEntities; i += 2) {
+        EXPECT_EQ(pool[pool.GetId(entities[i])], i);
+    }
+    ExpectNear(tm.GetWorldPosition(tm.GetTransformId(entities[numEntities - 1])), math_Vec3(float(numEntities - 1), 0, 0));
+
+    // Reuse the freed slots, then tear everything down
+    for (unsigned i = 0; i < numEntities; i += 2) {
+        entities[i] = em.CreateEntity();
+        tm.CreateTransform(entities[i]);
+        pool.Insert(entities[i], i);
+    }
+    EXPECT_EQ(tm.GetNumTransforms(), numEntities);
+    for (const game_Entity& entity : entities)
+        em.DestroyEntity(entity);
+    GarbageCollect(&em, &tm, &pool);
+    EXPECT_EQ(tm.GetNumTransforms(), 0u);
+    EXPECT_EQ(pool.Size(), 0u);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    printf("[ BENCH    ] create/destroy of %u entities: %.1f ms\n", numEntities, std::chrono::duration<double, std::milli>(end - start).count());
+}
+
+static double
+BenchmarkHierarchy(unsigned numTransforms, bool deep, bool updatePerMove)
+{
+    const int movesPerFrame = 10;
+    const int numFrames     = 20;
+
+    game_TransformManager tm(numTransforms);
+    CreateHierarchy(&tm, numTransforms, deep);
+    const game_TransformId root = Tid(tm, 0);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < numFrames; ++frame) {
+        for (int move = 0; move < movesPerFrame; ++move) {
+            tm.Translate(root, math_Vec3(0.01f, 0, 0));
+            if (updatePerMove)
+                tm.UpdateWorldTransforms();
+        }
+        tm.UpdateWorldTransforms();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / numFrames;
+}
+
+TEST(game_TransformManager, UpdateBenchmark)
+{
+    const unsigned numTransforms = 1000;
+    for (bool deep : {true, false}) {
+        double eager = BenchmarkHierarchy(numTransforms, deep, true);
+        double lazy  = BenchmarkHierarchy(numTransforms, deep, false);
+        printf("[ BENCH    ] %s hierarchy of %u, 10 moves/frame: %.3f ms/frame updating per move, %.3f ms/frame updating once\n",
+               deep ? "deep" : "wide",
+               numTransforms,
+               eager,
+               lazy);
+    }
+}
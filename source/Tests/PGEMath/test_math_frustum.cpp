@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <math_frustum.h>
+#include <math_constants.h>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace pge;
+
+// Where all eight corners land in clip space: 1 if all are inside, -1 if all are outside the same plane, else 0
+static int
+ClassifyCorners(const math_Mat4x4& viewProj, const math_AABB& box)
+{
+    int  outsideMask = 0x3f;
+    bool allInside   = true;
+    for (int corner = 0; corner < 8; ++corner) {
+        math_Vec3 point((corner & 1 ? box.max : box.min).x, (corner & 2 ? box.max : box.min).y, (corner & 4 ? box.max : box.min).z);
+        math_Vec4 clip = viewProj * math_Vec4(point, 1);
+        int       mask = (clip.x < -clip.w) | (clip.x > clip.w) << 1 | (clip.y < -clip.w) << 2 | (clip.y > clip.w) << 3
+                   | (clip.z < 0) << 4 | (clip.z > clip.w) << 5;
+        outsideMask &= mask;
+        allInside = allInside && mask == 0;
+    }
+    return allInside ? 1 : (outsideMask != 0 ? -1 : 0);
+}
+
+// A grid of unit boxes on the ground plane around the origin, with z up
+static std::vector<math_AABB>
+CreateGrid(int halfSize, float spacing)
+{
+    std::vector<math_AABB> boxes;
+    for (int x = -halfSize; x <= halfSize; ++x) {
+        for (int y = -halfSize; y <= halfSize; ++y) {
+            math_Vec3 min(x * spacing + 0.013f, y * spacing + 0.029f, -0.5f);
+            boxes.push_back(math_AABB(min, min + math_Vec3(1, 1, 1)));
+        }
+    }
+    return boxes;
+}
+
+static void
+ExpectCullsGrid(const math_Mat4x4& viewProj, const std::vector<math_AABB>& boxes)
+{
+    math_Frustum         frustum = math_CreateFrustum(viewProj);
+    std::vector<uint8_t> visible(boxes.size());
+    size_t               numVisible = math_Frustum_CullAABBs(frustum, boxes.data(), boxes.size(), visible.data());
+
+    size_t numInside = 0, numOutside = 0, numCounted = 0;
+    for (size_t i = 0; i < boxes.size(); ++i) {
+        int corners = ClassifyCorners(viewProj, boxes[i]);
+        EXPECT_EQ(visible[i] != 0, math_Frustum_IntersectsAABB(frustum, boxes[i])) << "box " << i;
+        if (corners == 1) {
+            EXPECT_EQ(visible[i], 1) << "box " << i;
+            ++numInside;
+        } else if (corners == -1) {
+            EXPECT_EQ(visible[i], 0) << "box " << i;
+            ++numOutside;
+        }
+        numCounted += visible[i];
+    }
+    EXPECT_EQ(numVisible, numCounted);
+    EXPECT_GT(numInside, 0u);
+    EXPECT_GT(numOutside, 0u);
+}
+
+TEST(math_Frustum, CullsGridInPerspective)
+{
+    math_Mat4x4 view = math_LookAt(math_Vec3(0, -10, 8), math_Vec3(0, 0, 0));
+    math_Mat4x4 proj = math_PerspectiveFovRH(math_DegToRad(60.0f), 16.0f / 9, 0.1f, 30.0f);
+    ExpectCullsGrid(proj * view, CreateGrid(25, 1.7f));
+}
+
+TEST(math_Frustum, CullsGridInOrthographic)
+{
+    // Like the shadow pass: a light looking down at an angle
+    math_Mat4x4 view = math_LookAt(math_Vec3(4, 6, 8), math_Vec3(0, 0, 0));
+    math_Mat4x4 proj = math_OrthographicRH(13.0f, 17.0f, 0.0f, 14.0f);
+    ExpectCullsGrid(proj * view, CreateGrid(25, 1.7f));
+}
+
+TEST(math_Frustum, PlanesFaceInward)
+{
+    math_Mat4x4  view    = math_LookAt(math_Vec3(0, -5, 0), math_Vec3(0, 0, 0));
+    math_Frustum frustum = math_CreateFrustum(math_PerspectiveFovRH(math_DegToRad(90.0f), 1.0f, 1.0f, 10.0f) * view);
+    for (const math_Vec4& plane : frustum.planes) {
+        EXPECT_NEAR(math_Length(plane.xyz), 1.0f, 1e-5f);
+        EXPECT_GT(math_Dot(plane, math_Vec4(0, 0, 0, 1)), 0.0f); // The origin is inside
+    }
+    // Behind the camera, beyond the far plane and in front
+    EXPECT_FALSE(math_Frustum_IntersectsAABB(frustum, math_AABB(math_Vec3(-1, -8, -1), math_Vec3(1, -6, 1))));
+    EXPECT_FALSE(math_Frustum_IntersectsAABB(frustum, math_AABB(math_Vec3(-1, 6, -1), math_Vec3(1, 7, 1))));
+    EXPECT_TRUE(math_Frustum_IntersectsAABB(frustum, math_AABB(math_Vec3(-1, -1, -1), math_Vec3(1, 1, 1))));
+}
+
+TEST(math_Frustum, CullingBenchmark)
+{
+    math_Mat4x4            view    = math_LookAt(math_Vec3(0, -10, 8), math_Vec3(0, 0, 0));
+    math_Mat4x4            proj    = math_PerspectiveFovRH(math_DegToRad(60.0f), 16.0f / 9, 0.1f, 30.0f);
+    math_Frustum           frustum = math_CreateFrustum(proj * view);
+    std::vector<math_AABB> boxes   = CreateGrid(50, 1.1f);
+    std::vector<uint8_t>   visible(boxes.size());
+
+    const int numRounds  = 200;
+    size_t    numVisible = 0;
+    auto      start      = std::chrono::high_resolution_clock::now();
+    for (int round = 0; round < numRounds; ++round)
+        numVisible += math_Frustum_CullAABBs(frustum, boxes.data(), boxes.size(), visible.data());
+    auto   end     = std::chrono::high_resolution_clock::now();
+    double batched = std::chrono::duration<double, std::nano>(end - start).count() / (numRounds * boxes.size());
+
+    size_t numScalar = 0;
+    start            = std::chrono::high_resolution_clock::now();
+    for (int round = 0; round < numRounds; ++round) {
+        for (const math_AABB& box : boxes)
+            numScalar += math_Frustum_IntersectsAABB(frustum, box) ? 1 : 0;
+    }
+    end           = std::chrono::high_resolution_clock::now();
+    double scalar = std::chrono::duration<double, std::nano>(end - start).count() / (numRounds * boxes.size());
+    EXPECT_EQ(numVisible, numScalar);
+    printf("[ BENCH    ] %zu boxes, %zu visible: %.2f ns per box batched, %.2f ns scalar\n",
+           boxes.size(),
+           numVisible / numRounds,
+           batched,
+           scalar);
+}
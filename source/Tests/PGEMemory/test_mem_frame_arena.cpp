@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <mem_frame_arena.h>
+#include <mem_allocator.h>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+using namespace pge;
+
+TEST(mem_LinearArena, AllocationsAreAlignedAndDisjoint)
+{
+    mem_LinearArena arena(4096);
+    char*           a = static_cast<char*>(arena.Allocate(3, 1));
+    double*         b = static_cast<double*>(arena.Allocate(sizeof(double), alignof(double)));
+    char*           c = static_cast<char*>(arena.Allocate(64, 64));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % alignof(double), 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(c) % 64, 0u);
+    EXPECT_GE(reinterpret_cast<char*>(b), a + 3);
+    EXPECT_GE(c, reinterpret_cast<char*>(b + 1));
+    EXPECT_TRUE(arena.Owns(a) && arena.Owns(b) && arena.Owns(c));
+
+    arena.Reset();
+    EXPECT_EQ(arena.GetUsed(), 0u);
+    EXPECT_EQ(arena.Allocate(3, 1), a);
+}
+
+TEST(mem_LinearArena, OverflowFallsBackToHeap)
+{
+    mem_LinearArena arena(128);
+    void*           inside = arena.Allocate(100);
+    void*           spill  = arena.Allocate(100, 16);
+    EXPECT_TRUE(arena.Owns(inside));
+    EXPECT_FALSE(arena.Owns(spill));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(spill) % 16, 0u);
+    EXPECT_EQ(arena.GetNumOverflows(), 1u);
+    memset(spill, 0xcd, 100);
+
+    arena.Reset();
+    EXPECT_EQ(arena.GetNumOverflows(), 0u);
+}
+
+TEST(mem_LinearArena, ConcurrentAllocationsDoNotOverlap)
+{
+    const size_t             numThreads = 4;
+    const size_t             numAllocs  = 1000;
+    mem_LinearArena          arena(numThreads * numAllocs * 16);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&, t] {
+            for (size_t i = 0; i < numAllocs; ++i) {
+                uint32_t* p = static_cast<uint32_t*>(arena.Allocate(16, 16));
+                for (int j = 0; j < 4; ++j)
+                    p[j] = static_cast<uint32_t>(t);
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    EXPECT_EQ(arena.GetUsed(), numThreads * numAllocs * 16);
+    EXPECT_EQ(arena.GetNumOverflows(), 0u);
+}
+
+TEST(mem_FrameArena, PreviousFrameSurvivesOneFrame)
+{
+    mem_FrameArena arena(1024);
+    int*           first = arena.AllocateArray<int>(4);
+    for (int i = 0; i < 4; ++i)
+        first[i] = i;
+
+    arena.NextFrame();
+    EXPECT_TRUE(arena.GetPrevious().Owns(first));
+    EXPECT_EQ(arena.GetCurrent().GetUsed(), 0u);
+    int* second = arena.AllocateArray<int>(4);
+    EXPECT_FALSE(arena.GetPrevious().Owns(second));
+    for (int i = 0; i < 4; ++i)
+        EXPECT_EQ(first[i], i);
+
+    arena.NextFrame();
+    EXPECT_EQ(arena.GetCurrent().GetUsed(), 0u);
+    EXPECT_TRUE(arena.GetCurrent().Owns(first));
+    EXPECT_TRUE(arena.GetPrevious().Owns(second));
+}
+
+TEST(mem_ArenaAllocator, ContainersAllocateFromTheArena)
+{
+    mem_FrameArena arena(64 * 1024);
+
+    mem_FrameVector<int> numbers{mem_ArenaAllocator<int>(&arena)};
+    for (int i = 0; i < 1000; ++i)
+        numbers.push_back(i);
+    EXPECT_TRUE(arena.GetCurrent().Owns(numbers.data()));
+    for (int i = 0; i < 1000; ++i)
+        ASSERT_EQ(numbers[i], i);
+
+    mem_FrameString name("Entity [", mem_ArenaAllocator<char>(&arena));
+    name += "a name long enough to not fit in the small string buffer";
+    name += "]";
+    EXPECT_TRUE(arena.GetCurrent().Owns(name.c_str()));
+    EXPECT_EQ(name.back(), ']');
+    EXPECT_EQ(arena.GetCurrent().GetNumOverflows(), 0u);
+}
+
+TEST(mem_FrameArena, AllocationBenchmark)
+{
+    const int      numFrames = 100;
+    const int      numAllocs = 10000;
+    mem_FrameArena arena(numAllocs * 64);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < numFrames; ++frame) {
+        arena.NextFrame();
+        for (int i = 0; i < numAllocs; ++i) {
+            char* p = static_cast<char*>(arena.Allocate(48));
+            p[0]    = char(i);
+        }
+    }
+    auto   end     = std::chrono::high_resolution_clock::now();
+    double arenaNs = std::chrono::duration<double, std::nano>(end - start).count() / (numFrames * numAllocs);
+
+    std::vector<char*> blocks(numAllocs);
+    start = std::chrono::high_resolution_clock::now();
+    for (int frame = 0; frame < numFrames; ++frame) {
+        for (int i = 0; i < numAllocs; ++i) {
+            blocks[i]    = new char[48];
+            blocks[i][0] = char(i);
+        }
+        for (int i = 0; i < numAllocs; ++i)
+            delete[] blocks[i];
+    }
+    end           = std::chrono::high_resolution_clock::now();
+    double heapNs = std::chrono::duration<double, std::nano>(end - start).count() / (numFrames * numAllocs);
+    printf("[ BENCH    ] 48 byte allocations: frame arena %.2f ns, global heap %.2f ns\n", arenaNs, heapNs);
+}
@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include <res_mesh.h>
+#include <res_mesh_bvh.h>
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+using namespace pge;
+
+static const std::string DungeonPackDir = std::string(PGE_TEST_DATA_DIR) + "/Dungeon Pack Export/";
+
+static res_MeshBVH
+CreateBVH(const res_SerializedMesh& mesh)
+{
+    return res_MeshBVH(mesh.GetVertexData(), mesh.GetVertexStride(), mesh.GetTriangleData(), mesh.GetNumTriangles());
+}
+
+static math_Vec3
+GetVertex(const res_SerializedMesh& mesh, unsigned triangle, unsigned corner)
+{
+    const unsigned index    = mesh.GetTriangleData()[triangle * 3 + corner];
+    const float*   position = reinterpret_cast<const float*>(mesh.GetVertexData() + index * mesh.GetVertexStride());
+    return math_Vec3(position[0], position[1], position[2]);
+}
+
+static bool
+RaycastBruteForce(const res_SerializedMesh& mesh, const math_Ray& ray, float maxDistance, float* distanceOut)
+{
+    float closest = maxDistance;
+    bool  found   = false;
+    for (unsigned i = 0; i < mesh.GetNumTriangles(); ++i) {
+        float distance = 0;
+        if (math_Raycast_IntersectsTriangle(ray, GetVertex(mesh, i, 0), GetVertex(mesh, i, 1), GetVertex(mesh, i, 2), &distance)
+            && distance <= closest) {
+            closest = distance;
+            found   = true;
+        }
+    }
+    *distanceOut = closest;
+    return found;
+}
+
+// Rays from around the mesh through random points in its bounds, so most of them come close to the geometry
+static std::vector<math_Ray>
+CreateRays(const math_AABB& bounds, size_t numRays, unsigned seed)
+{
+    std::mt19937                          random(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const math_Vec3                       size   = bounds.max - bounds.min;
+    const float                           radius = math_Length(size) + 1.0f;
+
+    std::vector<math_Ray> rays;
+    for (size_t i = 0; i < numRays; ++i) {
+        math_Vec3 target = bounds.min + math_Vec3(size.x * unit(random), size.y * unit(random), size.z * unit(random));
+        math_Vec3 offset = math_Normalize(math_Vec3(unit(random) - 0.5f, unit(random) - 0.5f, unit(random) - 0.5f));
+        math_Vec3 origin = target + offset * radius;
+        rays.push_back(math_Ray(origin, math_Normalize(target - origin)));
+    }
+    return rays;
+}
+
+TEST(res_MeshBVH, MatchesBruteForceOnDungeonMeshes)
+{
+    const char* meshes[] = {"Barrel_01.mesh", "Wall_17.mesh", "Door_03.mesh", "Skeleton_02.mesh", "Weapon_05.mesh"};
+    for (const char* name : meshes) {
+        const std::string path = DungeonPackDir + name;
+        if (!std::ifstream(path).is_open())
+            GTEST_SKIP() << "No mesh at " << path;
+        res_SerializedMesh mesh(path.c_str());
+        res_MeshBVH        bvh = CreateBVH(mesh);
+        EXPECT_EQ(bvh.GetNumTriangles(), mesh.GetNumTriangles());
+        EXPECT_EQ(bvh.GetBounds().min, mesh.GetAABB().min);
+        EXPECT_EQ(bvh.GetBounds().max, mesh.GetAABB().max);
+
+        unsigned numHits = 0;
+        for (const math_Ray& ray : CreateRays(mesh.GetAABB(), 500, 3)) {
+            float          expected  = 0;
+            bool           expectHit = RaycastBruteForce(mesh, ray, FLT_MAX, &expected);
+            res_MeshBVHHit hit{};
+            ASSERT_EQ(bvh.Raycast(ray, FLT_MAX, &hit), expectHit) << name;
+            EXPECT_EQ(bvh.RaycastAny(ray, FLT_MAX), expectHit) << name;
+            if (!expectHit)
+                continue;
+            numHits++;
+            EXPECT_EQ(hit.distance, expected) << name;
+
+            // The reported triangle is the one hit, in the mesh's own triangle order
+            float distance = 0;
+            ASSERT_LT(hit.triangle, mesh.GetNumTriangles());
+            EXPECT_TRUE(math_Raycast_IntersectsTriangle(ray, GetVertex(mesh, hit.triangle, 0), GetVertex(mesh, hit.triangle, 1), GetVertex(mesh, hit.triangle, 2), &distance));
+            EXPECT_EQ(distance, expected) << name;
+
+            // Nothing is hit before the closest triangle
+            EXPECT_FALSE(bvh.Raycast(ray, expected * 0.99f, &hit)) << name;
+            EXPECT_FALSE(bvh.RaycastAny(ray, expected * 0.99f)) << name;
+        }
+        EXPECT_GT(numHits, 0u) << name;
+    }
+}
+
+TEST(res_MeshBVH, EmptyMeshIsNeverHit)
+{
+    res_MeshBVH    bvh(nullptr, sizeof(math_Vec3), nullptr, 0);
+    res_MeshBVHHit hit{};
+    EXPECT_EQ(bvh.GetNumNodes(), 0u);
+    EXPECT_FALSE(bvh.Raycast(math_Ray(math_Vec3(0, 0, 0), math_Vec3(1, 0, 0)), FLT_MAX, &hit));
+    EXPECT_FALSE(bvh.RaycastAny(math_Ray(math_Vec3(0, 0, 0), math_Vec3(1, 0, 0)), FLT_MAX));
+}
+
+TEST(res_MeshBVH, BuildAndQueryBenchmark)
+{
+    if (!std::filesystem::is_directory(DungeonPackDir))
+        GTEST_SKIP() << "No meshes at " << DungeonPackDir;
+
+    // Building the hierarchies of the whole pack
+    std::vector<std::unique_ptr<res_SerializedMesh>> meshes;
+    for (const auto& entry : std::filesystem::directory_iterator(DungeonPackDir)) {
+        if (entry.path().extension() == ".mesh")
+            meshes.emplace_back(new res_SerializedMesh(entry.path().string().c_str()));
+    }
+    size_t numTriangles = 0, numBytes = 0;
+    auto   start        = std::chrono::high_resolution_clock::now();
+    for (const auto& mesh : meshes) {
+        res_MeshBVH bvh = CreateBVH(*mesh);
+        numTriangles += bvh.GetNumTriangles();
+        numBytes += bvh.GetSizeInBytes();
+    }
+    auto   end       = std::chrono::high_resolution_clock::now();
+    double buildTime = std::chrono::duration<double, std::milli>(end - start).count();
+    printf("[ BENCH    ] built %zu meshes, %zu triangles in %.2f ms (%zu bytes)\n", meshes.size(), numTriangles, buildTime, numBytes);
+
+    // Picking the densest mesh
+    const res_SerializedMesh* densest = meshes[0].get();
+    for (const auto& mesh : meshes) {
+        if (mesh->GetNumTriangles() > densest->GetNumTriangles())
+            densest = mesh.get();
+    }
+    res_MeshBVH           bvh  = CreateBVH(*densest);
+    std::vector<math_Ray> rays = CreateRays(densest->GetAABB(), 1000, 5);
+
+    unsigned numHits = 0;
+    start            = std::chrono::high_resolution_clock::now();
+    for (const math_Ray& ray : rays) {
+        res_MeshBVHHit hit;
+        numHits += bvh.Raycast(ray, FLT_MAX, &hit) ? 1 : 0;
+    }
+    end                = std::chrono::high_resolution_clock::now();
+    double closestTime = std::chrono::duration<double, std::micro>(end - start).count() / rays.size();
+
+    unsigned numAnyHits = 0;
+    start               = std::chrono::high_resolution_clock::now();
+    for (const math_Ray& ray : rays)
+        numAnyHits += bvh.RaycastAny(ray, FLT_MAX) ? 1 : 0;
+    end            = std::chrono::high_resolution_clock::now();
+    double anyTime = std::chrono::duration<double, std::micro>(end - start).count() / rays.size();
+
+    unsigned bruteHits = 0;
+    start              = std::chrono::high_resolution_clock::now();
+    for (const math_Ray& ray : rays) {
+        float distance = 0;
+        bruteHits += RaycastBruteForce(*densest, ray, FLT_MAX, &distance) ? 1 : 0;
+    }
+    end              = std::chrono::high_resolution_clock::now();
+    double bruteTime = std::chrono::duration<double, std::micro>(end - start).count() / rays.size();
+
+    EXPECT_EQ(numHits, bruteHits);
+    EXPECT_EQ(numAnyHits, bruteHits);
+    printf("[ BENCH    ] %s (%u triangles, %zu nodes): %.2f us closest hit, %.2f us any hit, %.2f us brute force per ray\n",
+           densest->GetPath().c_str(),
+           densest->GetNumTriangles(),
+           bvh.GetNumNodes(),
+           closestTime,
+           anyTime,
+           bruteTime);
+}
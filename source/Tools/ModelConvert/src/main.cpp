@@ -11,14 +11,17 @@
 #include <res_mesh.h>
 #include <res_material.h>
 #include <res_skeleton.h>
+#include <anim_compression.h>
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <fstream>
 #include <sstream>
 #include <Windows.h>
 
 void
-ExtractMesh(const aiMesh* mesh, const char* targetPath, const pge::anim_Skeleton* skeleton, const aiMatrix4x4 importTransform)
+ExtractMesh(const aiMesh* mesh, const char* targetPath, const pge::anim_SkeletonDef* skeleton, const aiMatrix4x4 importTransform)
 {
     using namespace pge;
 
@@ -231,7 +234,7 @@ QuatFromAssimp(const aiQuaternion& quat)
 }
 
 void
-ExtractAnimation(const aiAnimation* animation, const char* targetPath)
+ExtractAnimation(const aiAnimation* animation, const char* targetPath, const pge::anim_CompressionSettings& settings)
 {
     std::vector<pge::anim_SkeletonAnimationChannel> channels;
     channels.reserve(animation->mNumChannels);
@@ -281,10 +284,21 @@ ExtractAnimation(const aiAnimation* animation, const char* targetPath)
     ss << targetPath << "\\" << animation->mName.C_Str() << ".skelanim";
     std::ofstream animFile(ss.str(), std::ios::binary);
     anim.Write(animFile);
+
+    const pge::anim_CompressedAnimation compressed(*anim.GetAnimation(), settings);
+    std::ofstream                       compressedFile(ss.str() + "c", std::ios::binary);
+    compressedFile << compressed;
+    printf("Compressed animation %s: %u bytes -> %u bytes\n",
+           animation->mName.C_Str(),
+           static_cast<unsigned>(animFile.tellp()),
+           static_cast<unsigned>(compressedFile.tellp()));
 }
 
 void
-ConvertModel(const char* sourcePath, const char* targetPath, const aiMatrix4x4& importTransform = aiMatrix4x4())
+ConvertModel(const char*                          sourcePath,
+             const char*                          targetPath,
+             const aiMatrix4x4&                   importTransform     = aiMatrix4x4(),
+             const pge::anim_CompressionSettings& compressionSettings = pge::anim_CompressionSettings())
 {
     unsigned importFlags = 0;
     //    importFlags |= aiProcess_CalcTangentSpace;
@@ -333,16 +347,62 @@ ConvertModel(const char* sourcePath, const char* targetPath, const aiMatrix4x4&
         printf("Done extracting material %d: %s\n", i + 1, scene->mMaterials[i]->GetName().C_Str());
     }
     for (unsigned i = 0; i < scene->mNumAnimations; ++i) {
-        ExtractAnimation(scene->mAnimations[i], targetPath);
+        ExtractAnimation(scene->mAnimations[i], targetPath, compressionSettings);
         printf("Done extracting animation %d: %s\n", i + 1, scene->mAnimations[i]->mName.C_Str());
     }
 
     aiReleaseImport(scene);
 }
 
+static void
+PrintUsage(const char* program)
+{
+    const pge::anim_CompressionSettings defaults;
+    printf("Usage: %s [options]\n", program);
+    printf("  --sample-rate <hz>         Animation compression grid (default %g)\n", defaults.sampleRate);
+    printf("  --translation-error <m>    Maximum translation error (default %g)\n", defaults.translationError);
+    printf("  --rotation-error <rad>     Maximum rotation error (default %g)\n", defaults.rotationError);
+    printf("  --scale-error <factor>     Maximum scale error (default %g)\n", defaults.scaleError);
+}
+
+// Returns false if an option is unknown or its value isn't a positive number
+static bool
+ParseCompressionSettings(int argc, char** argv, pge::anim_CompressionSettings* settings)
+{
+    for (int i = 1; i < argc; ++i) {
+        float* value = nullptr;
+        if (strcmp(argv[i], "--sample-rate") == 0)
+            value = &settings->sampleRate;
+        else if (strcmp(argv[i], "--translation-error") == 0)
+            value = &settings->translationError;
+        else if (strcmp(argv[i], "--rotation-error") == 0)
+            value = &settings->rotationError;
+        else if (strcmp(argv[i], "--scale-error") == 0)
+            value = &settings->scaleError;
+        if (value == nullptr || i + 1 == argc) {
+            printf("Unknown option or missing value: %s\n", argv[i]);
+            return false;
+        }
+
+        char* end = nullptr;
+        *value    = strtof(argv[++i], &end);
+        if (*end != 0 || !(*value > 0)) {
+            printf("Invalid value for %s: %s\n", argv[i - 1], argv[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
 int
-main()
+main(int argc, char** argv)
 {
+    pge::anim_CompressionSettings compressionSettings;
+    if (!ParseCompressionSettings(argc, argv, &compressionSettings)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
     //    const char* inPath  = R"(C:\Users\phili\Desktop\Dungeon Pack)";
     //    const char* outPath = R"(D:\Projects\pge\data\Dungeon Pack Export)";
     //    auto        models  = pge::core_FSItemsWithExtension(inPath, "fbx", false);
@@ -365,7 +425,7 @@ main()
 
     aiMatrix4x4 importTransform = rotationZ * rotationX * scale;
 
-    ConvertModel(R"(C:\Users\phili\Desktop\Walking.fbx)", R"(C:\Users\phili\Desktop\Walking)", importTransform);
+    ConvertModel(R"(C:\Users\phili\Desktop\Walking.fbx)", R"(C:\Users\phili\Desktop\Walking)", importTransform, compressionSettings);
     //    ConvertModel(R"(C:\Users\phili\Desktop\Idle.fbx)", R"(D:\Projects\pge\data\Vampire\Idle)");
     return 0;
 }
\ No newline at end of file